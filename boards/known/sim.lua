@@ -9,9 +9,18 @@ return {
     advanced_shell = true,
     term = { lines = 25, cols = 80 },
     mmcfs = { spi = 0, cs_port = 0, cs_pin = 0 },
+    cints = true,
+    luaints = true,
+    can_buffers = true,
+    adc = { buf_size = 4 },
+    tcpip = { ip = "10.0.0.1", netmask = "255.255.255.0", gw = "10.0.0.254", dns = "10.0.0.254", rx_buf_size = 6144 },
+    dns = true,
+  },
+  config = {
+    swtmr = { num = 64 }
   },
   modules = {
-    generic = { 'pd', 'all_lua', 'term', 'elua' }
+    generic = { 'pd', 'all_lua', 'term', 'elua', 'spi', 'i2c', 'can', 'cpu', 'pio', 'adc', 'net', 'httpd' }
   }
 }
 
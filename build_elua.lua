@@ -115,7 +115,7 @@ local function check_cmdline_vs_conf( argname, comp, bd )
   end
 end
 
-builder:add_option( 'target', 'build "regular" float lua, 32 bit integer-only "lualong" or 64-bit integer only lua "lualonglong"', 'lua', { 'lua', 'lualong', 'lualonglong' } )
+builder:add_option( 'target', 'build "regular" float lua, float lua with an integer subtype "luahybrid", 32 bit integer-only "lualong" or 64-bit integer only lua "lualonglong"', 'lua', { 'lua', 'luahybrid', 'lualong', 'lualonglong' } )
 builder:add_option( 'allocator', 'select memory allocator', 'auto', { 'newlib', 'multiple', 'simple', 'auto' } )
 builder:add_option( 'board', 'selects board for target (cpu will be inferred)', nil, board_list )
 builder:add_option( 'toolchain', 'specifies toolchain to use (auto=search for usable toolchain)', 'auto', { bd.get_all_toolchains(), 'auto' } )
@@ -264,7 +264,9 @@ if comp.romfs == 'compile' then
     print "Build it by running 'lua cross-lua.lua'"
     os.exit( -1 )
   end
-  local cmdpath = { lfs.currentdir(), sf( 'luac.cross%s -ccn %s -cce %s -o %%s -s %%s', suffix, toolset[ "cross_" .. comp.target:lower() ], toolset.cross_cpumode:lower() ) }
+  -- "luahybrid" uses the same bytecode format as "lua"
+  local crosstarget = comp.target == 'luahybrid' and 'lua' or comp.target:lower()
+  local cmdpath = { lfs.currentdir(), sf( 'luac.cross%s -ccn %s -cce %s -o %%s -s %%s', suffix, toolset[ "cross_" .. crosstarget ], toolset.cross_cpumode:lower() ) }
   fscompcmd = table.concat( cmdpath, utils.dir_sep )
 elseif comp.romfs == 'compress' then
   if comp.target == 'lualong' or comp.target == 'lualonglong' then fscompoptnums = '' else fscompoptnums = '--opt-numbers' end
@@ -336,6 +338,7 @@ end
 if comp.boot == 'luarpc' then addm( "ELUA_BOOT_RPC" ) end
 if comp.target == 'lualong' or comp.target == 'lualonglong' then addm( "LUA_NUMBER_INTEGRAL" ) end
 if comp.target == 'lualonglong' then addm( "LUA_INTEGRAL_LONGLONG" ) end
+if comp.target == 'luahybrid' then addm( "LUA_NUMBER_HYBRID" ) end
 if comp.target ~= 'lualong' and comp.target ~= "lualonglong" then addm( "LUA_PACK_VALUE" ) end
 if bd.get_endianness_of_platform( platform ) == "big" then addm( "ELUA_ENDIAN_BIG" ) else addm( "ELUA_ENDIAN_LITTLE" ) end
 
@@ -353,7 +356,7 @@ local source_files = utils.get_files( "src", function( fname )
   return include
 end )
 -- Add uIP files manually because not all of them are included in the build ([TODO] why?)
-local uip_files = " " .. utils.prepend_path( "uip_arp.c uip.c uiplib.c dhcpc.c psock.c resolv.c uip-neighbor.c", "src/uip" )
+local uip_files = " " .. utils.prepend_path( "uip_arp.c uip.c uip_chksum.c uiplib.c dhcpc.c psock.c resolv.c uip-neighbor.c", "src/uip" )
 
 addi{ { 'inc', 'inc/newlib',  'inc/remotefs', 'src/platform', 'src/lua' }, { 'src/modules', 'src/platform/' .. platform, 'src/platform/' .. platform .. '/cpus' }, "src/uip", "src/fatfs" }
 addm( "LUA_OPTIMIZE_MEMORY=" .. ( comp.optram and "2" or "0" ) )
@@ -84,6 +84,8 @@ function init()
   -- Not really a component, not quite a config ... Implementation wise,
   -- it is easier to declare it as a component
   components.uart_buffers = { macro = 'BUF_ENABLE_UART' }
+  -- CAN RX buffering (same as above)
+  components.can_buffers = { macro = 'BUF_ENABLE_CAN', needs = 'cints' }
   -- XMODEM
   components.xmodem = {
     macro = 'BUILD_XMODEM',
@@ -171,7 +173,9 @@ function init()
       ip = at.ip_attr( 'ELUA_CONF_IPADDR' ),
       netmask = at.ip_attr( 'ELUA_CONF_NETMASK' ),
       gw = at.ip_attr( 'ELUA_CONF_DEFGW' ),
-      dns = at.ip_attr( 'ELUA_CONF_DNS' )
+      dns = at.ip_attr( 'ELUA_CONF_DNS' ),
+      rx_buf_size = at.make_optional( at.int_attr( 'ELUA_NET_RX_BUF_SIZE', 1, 65535 ) ),
+      arp_size = at.make_optional( at.int_attr( 'ELUA_NET_ARP_SIZE', 1, 255 ) )
     }
   }
   -- Serial multiplexer
@@ -194,13 +198,24 @@ function init()
     }
   }
   -- DNS client
-  components.dns = { macro = 'BUILD_DNS', needs = 'tcpip' }
+  components.dns = {
+    macro = 'BUILD_DNS',
+    needs = 'tcpip',
+    attrs = {
+      cache_size = at.make_optional( at.int_attr( 'ELUA_NET_DNS_CACHE_SIZE', 1, 255 ) ),
+      max_ttl = at.make_optional( at.int_attr( 'ELUA_NET_DNS_MAX_TTL', 0 ) ),
+      neg_ttl = at.make_optional( at.int_attr( 'ELUA_NET_DNS_NEG_TTL', 0 ) )
+    }
+  }
   -- DHCP client
   components.dhcp = { macro = 'BUILD_DHCPC', needs = 'tcpip' }
   -- ROMFS
   components.romfs = { macro = 'BUILD_ROMFS' }
   -- WOFS
   components.wofs = { macro = "BUILD_WOFS" }
+  -- GC timing statistics
+  components.gcstats = { macro = "BUILD_GC_STATS" }
+  components.membudget = { macro = "BUILD_MEM_BUDGETS" }
   -- All done
   return components
 end
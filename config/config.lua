@@ -135,6 +135,14 @@ local sanity_code = [[
 #define VTMR_NUM_TIMERS       0
 #endif // #ifndef VTMR_NUM_TIMERS
 
+#ifndef SWTMR_NUM_TIMERS
+#define SWTMR_NUM_TIMERS      0
+#endif // #ifndef SWTMR_NUM_TIMERS
+
+#ifndef SWTMR_TICK_US
+#define SWTMR_TICK_US         1000
+#endif // #ifndef SWTMR_TICK_US
+
 #ifndef SERMUX_FLOW_TYPE
 #define SERMUX_FLOW_TYPE      PLATFORM_UART_FLOW_NONE
 #endif
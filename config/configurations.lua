@@ -142,6 +142,14 @@ function init()
     required = { num = 0, freq = 1 }
   }
 
+  -- Software timers (timer wheel)
+  configs.swtmr = {
+    attrs = {
+      num = at.int_attr( 'SWTMR_NUM_TIMERS', 0, 1024 ),
+      tick = at.int_attr( 'SWTMR_TICK_US', 1, nil, 1000 )
+    }
+  }
+
   -- EGC
   configs.egc = {
     confcheck = egc_checker,
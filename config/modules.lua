@@ -24,6 +24,7 @@ local lua_modules = {
 --       For example: NUM_CAN > 0, _NOT_ NUM_CAN>0.
 local elua_generic_modules = { 
   adc = { guards = { "BUILD_ADC", "NUM_ADC > 0" } }, 
+  array = {},
   bit = {}, 
   can = { guards = { "NUM_CAN > 0" } }, 
   cpu = {}, 
@@ -32,6 +33,7 @@ local elua_generic_modules = {
   pack = {}, 
   rpc = { guards = { "BUILD_RPC" } },
   net = { guards = { "BUILD_UIP" } },
+  httpd = { guards = { "BUILD_UIP" } },
   pd = {}, 
   pio = { guards = { "NUM_PIO > 0" } },
   pwm = { guards = {"NUM_PWM > 0" } }, 
@@ -62,7 +62,9 @@ enum
     },
 
      {  sig = "int #platform_can_recv#( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data );",
-        desc = "Receive CAN bus message.",
+        desc = [[Receive CAN bus message. If the interface is buffered the message is read from the buffer, otherwise it is read directly from the hardware.<br>
+  This function is "split" in two parts: a platform independent part that is implemented in %src/common_can.c% and handles buffering and acceptance filters, and a 
+  platform-dependent part that must be implemented by each platform in a function named @#platform_s_can_recv@platform_s_can_recv@.]],
         args =
        {
           "$id$ - CAN interface ID.",
@@ -73,6 +75,65 @@ enum
        },
        ret = "PLATFORM_OK for success, PLATFORM_UNDERFLOW for error. (see @arch_platform_ll.html@here@ for details)"
     },
+
+    { sig = "int #platform_s_can_recv#( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data );",
+      link = "platform_s_can_recv",
+      desc = [[This is the platform-dependent part of @#platform_can_recv@platform_can_recv@: it reads the next message from the hardware receive FIFO without waiting.
+  If the platform implements the $INT_CAN_RX$ interrupt, the interrupt handler of the buffering code calls this function until it returns $PLATFORM_UNDERFLOW$.]],
+      args = "same as @#platform_can_recv@platform_can_recv@.",
+      ret = "PLATFORM_OK if a message was received, PLATFORM_UNDERFLOW if the hardware FIFO is empty."
+    },
+
+    { sig = "int #platform_can_set_buffer#( unsigned id, unsigned log2size );",
+      desc = [[Sets the receive buffer of the specified CAN interface. This function is fully implemented in %src/common_can.c% and needs the $BUF_ENABLE_CAN$ macro 
+  (the $can_buffers$ component), C interrupt support and the $INT_CAN_RX$ interrupt.]],
+      args =
+      {
+        "$id$ - CAN interface ID.",
+        "$log2size$ - the base 2 logarithm of the buffer size (in messages) or 0 to disable buffering."
+      },
+      ret = "$PLATFORM_OK$ if the operation succeeded, $PLATFORM_ERR$ otherwise."
+    },
+
+    { sig = "int #platform_can_set_filter#( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype );",
+      desc = [[Sets acceptance filter $idx$ (between 0 and $PLATFORM_CAN_NUM_FILTERS - 1$) on the specified CAN interface. A message is accepted if at least one filter 
+  is set and it matches, or if no filter is set. This function is implemented in %src/common_can.c%. The filters are always applied in software; if the platform defines
+  $PLATFORM_HAS_CAN_HW_FILTERS$ they are also forwarded to the hardware with @#platform_s_can_set_filter@platform_s_can_set_filter@.]],
+      args =
+      {
+        "$id$ - CAN interface ID.",
+        "$idx$ - filter index.",
+        "$canid$ - the identifier to match.",
+        "$mask$ - the bits of the identifier that must match (a message matches if $( id & mask ) == ( canid & mask )$).",
+        "$idtype$ - the identifier type, as defined @#can_id_types@here@."
+      },
+      ret = "$PLATFORM_OK$ if the operation succeeded, $PLATFORM_ERR$ otherwise."
+    },
+
+    { sig = "int #platform_can_clear_filter#( unsigned id, unsigned idx );",
+      desc = "Removes acceptance filter $idx$ from the specified CAN interface. This function is implemented in %src/common_can.c%.",
+      args =
+      {
+        "$id$ - CAN interface ID.",
+        "$idx$ - filter index."
+      },
+      ret = "$PLATFORM_OK$ if the operation succeeded, $PLATFORM_ERR$ otherwise."
+    },
+
+    { sig = "int #platform_s_can_set_filter#( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype, int enable );",
+      link = "platform_s_can_set_filter",
+      desc = [[Programs (or disables) a hardware acceptance filter. Only needed if the platform defines $PLATFORM_HAS_CAN_HW_FILTERS$. While no filter is enabled, the
+  hardware must accept all the messages.]],
+      args =
+      {
+        "$id$ - CAN interface ID.",
+        "$idx$ - filter index.",
+        "$canid$ - the identifier to match.",
+        "$mask$ - the bits of the identifier that must match.",
+        "$idtype$ - the identifier type, as defined @#can_id_types@here@.",
+        "$enable$ - 1 to enable the filter, 0 to disable it."
+      },
+      ret = "$PLATFORM_OK$ if the operation succeeded, $PLATFORM_ERR$ otherwise (for example if the hardware doesn't have enough filters)."
+    },
   }
 }
-
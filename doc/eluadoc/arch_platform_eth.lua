@@ -77,6 +77,21 @@ data_en =
       ret = "the size of the read packet or 0 if no packet is available"
     },
 
+    { sig = "void* #platform_eth_get_rx_buffer#( u32 *psize );",
+      desc = [[Only for the platforms that define $PLATFORM_HAS_ETH_RX_BUFFER$ (instead of implementing @#platform_eth_get_packet_nb@platform_eth_get_packet_nb@), usually because
+  their Ethernet controller receives the packets with DMA in buffers of the driver. The driver lends the buffer of the next received packet to uIP, which processes the packet
+  without copying it to its own buffer, so the data is copied only once, to the socket that receives it. uIP builds its answer in the same buffer, so it must have room for
+  $UIP_BUFSIZE + 2$ bytes and must be aligned to 16 bits. The platform must also define $UIP_CONF_EXTERNAL_BUFFER$ to 1 in its $uip-conf.h$.]],
+      args = "$psize$ - receives the size of the Ethernet packet",
+      ret = "the address of the buffer of the packet or NULL if no packet is available"
+    },
+
+    { sig = "void #platform_eth_release_rx_buffer#( void *buf );",
+      desc = [[Gives back to the driver a buffer obtained with @#platform_eth_get_rx_buffer@platform_eth_get_rx_buffer@, when uIP is done with the packet (and has sent the
+  answer to it with @#platform_eth_send_packet@platform_eth_send_packet@). Only one buffer is lent at a time.]],
+      args = "$buf$ - the address of the buffer"
+    },
+
     { sig = "void #platform_eth_force_interrupt#();",
       desc = "Force the Ethernet interrupt on the platform (see @#overview@overview@ above for details)",
     },
@@ -89,6 +104,12 @@ data_en =
         "0 if the uIP loop was called because of Ethernet activity, not because a timer expired",
         "the Ethernet timer period in ms (which indicates timer activity)"
       },
+    },
+
+    { sig = "void #platform_eth_poll#();",
+      desc = [[Only for the platforms that don't have an Ethernet interrupt and define $PLATFORM_HAS_ETH_POLL$ (for example the $sim$ platform). It is called repeatedly
+  by the network functions while they wait for uIP, and it should call the uIP main loop ($elua_uip_mainloop$) until all the received packets are processed. The function
+  must not call the main loop again if it is already running.]],
     }
   }
 }
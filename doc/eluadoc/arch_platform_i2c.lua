@@ -98,6 +98,23 @@ enum
         "$ack$ - 1 to send ACK, 0 to send NAK. If $ACK$ is 0 a STOP condition will automatically be generated after the NAK."
       },
       ret = "1 for success, 0 for error."
+    },
+
+    { sig = "int #platform_i2c_transfer#( unsigned id, u16 address, const u8 *txdata, u32 txlen, u8 *rxdata, u32 rxlen );",
+      desc = [[Executes a complete transaction: START, address (transmitter), $txlen$ bytes from $txdata$, repeated START, address (receiver), $rxlen$ bytes to $rxdata$, STOP. 
+  The write part is skipped if $txlen$ is 0 and the read part is skipped if $rxlen$ is 0. A generic implementation that uses the functions above is provided in 
+  %src/common.c%. Platforms that can do better (for example with an interrupt or DMA driven I2C controller) should implement this function and define 
+  $PLATFORM_HAS_I2C_TRANSFER$ in their $platform_generic.h$ file.]],
+      args =
+      {
+        "$id$ - I2C interface ID.",
+        "$address$ - I2C peripheral address.",
+        "$txdata$ - data to send.",
+        "$txlen$ - number of bytes to send.",
+        "$rxdata$ - buffer for the received data.",
+        "$rxlen$ - number of bytes to receive."
+      },
+      ret = "the number of bytes received or -1 if the slave didn't acknowledge its address or the data sent to it."
     }
   }
 }
@@ -108,6 +108,39 @@ data_en =
         when called with the $PLATFORM_IO_PIN_PULLDOWN$ operation.]]
      }
     },
+
+    { sig = "void #platform_pio_wave_play#( const pio_wave_step *steps, unsigned nsteps );",
+      desc = [[Replays a waveform. For each step the pins in $mask$ are set to the corresponding bits of $value$, then the function waits until $delay$ microseconds passed since 
+  the previous step started. A generic implementation that uses @#platform_pio_op@platform_pio_op@ and the system timer is provided in %src/common.c%. A platform can provide its own
+  implementation (for example one that uses a hardware timer or DMA) by defining $PLATFORM_HAS_PIO_WAVE$ in its $platform_generic.h$ file.
+  $pio_wave_step$ is defined as follows (it has the same layout as 4 consecutive elements of a S32 $array$):</p>
+  ~typedef struct
+{
+  u32 port;         $// port code (PLATFORM_IO_ENCODE( port, 0, 1 ))$
+  pio_type mask;    $// the pins that are changed by this step$
+  pio_type value;   $// the new value of the pins$
+  u32 delay;        $// delay after this step (us)$
+} pio_wave_step;~<p>]],
+      args =
+      {
+        "$steps$ - the steps of the waveform.",
+        "$nsteps$ - the number of steps."
+      }
+    },
+
+    { sig = "unsigned #platform_pio_wave_capture#( unsigned port, pio_type mask, u32 *pdata, unsigned maxentries, u32 timeout );",
+      desc = [[Records the changes of the pins in $mask$ as ( $timestamp, value$ ) pairs of words in $pdata$. The first entry is the value of the pins at the start of the capture,
+  with timestamp 0. As @#platform_pio_wave_play@platform_pio_wave_play@, it has a generic implementation in %src/common.c% which can be replaced by the platform.]],
+      args =
+      {
+        "$port$ - the port code.",
+        "$mask$ - the pins to monitor.",
+        "$pdata$ - the buffer that receives the entries (2 words per entry).",
+        "$maxentries$ - the maximum number of entries.",
+        "$timeout$ - the maximum duration of the capture in microseconds."
+      },
+      ret = "the number of recorded entries."
+    },
   }
 }
 
@@ -39,7 +39,9 @@ enum
     },
 
     { sig = "u32 #platform_pwm_setup#( unsigned id, u32 frequency, unsigned duty );",
-      desc = "Sets up a PWM channel",
+      desc = [[Sets up a PWM channel. This function is "split" in two parts: a platform independent part implemented in %src/common_pwm.c% (that remembers the
+  frequency of each channel for @#platform_pwm_update@platform_pwm_update@) and a platform dependent part that must be implemented by each platform in a function named
+  $platform_s_pwm_setup$.]],
       args = 
       {
         "$id$ - PWM channel ID",
@@ -49,6 +51,31 @@ enum
       ret = "The actual frequency set on the PWM channel, which might differ from the $frequency$ parameter, depeding on the hardware",
     },
 
+    { sig = "int #platform_pwm_update#( unsigned n, const u8 *ids, const u8 *duties );",
+      desc = [[Changes the duty cycles of several PWM channels at once. This function is implemented in %src/common_pwm.c%. If the platform defines
+  $PLATFORM_HAS_PWM_UPDATE$ in its %platform_generic.h% header it must implement @#platform_s_pwm_update@platform_s_pwm_update@, otherwise the channels are
+  reprogrammed one after the other with $platform_s_pwm_setup$ with interrupts disabled.]],
+      args =
+      {
+        "$n$ - the number of channels",
+        "$ids$ - the IDs of the channels, which must be set up with @#platform_pwm_setup@platform_pwm_setup@ first",
+        "$duties$ - the new duty cycle of each channel, as percent (from 0 to 100)"
+      },
+      ret = "$PLATFORM_OK$ for success, $PLATFORM_ERR$ if a channel was not set up or a duty cycle is not valid"
+    },
+
+    { sig = "void #platform_s_pwm_update#( unsigned n, const u8 *ids, const u8 *duties );",
+      desc = [[Platform dependent part of @#platform_pwm_update@platform_pwm_update@, needed only if $PLATFORM_HAS_PWM_UPDATE$ is defined. It is called with interrupts
+  disabled and valid arguments, and must make all the new duty cycles take effect at the same time (for example by writing the compare registers while the
+  update of the shadow registers is disabled).]],
+      args =
+      {
+        "$n$ - the number of channels",
+        "$ids$ - the IDs of the channels",
+        "$duties$ - the new duty cycle of each channel, as percent (from 0 to 100)"
+      }
+    },
+
     { sig = "u32 #platform_pwm_start#( unsigned id );",
       desc = "Starts PWM generation on the specified channel",
       args = 
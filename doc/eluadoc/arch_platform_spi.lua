@@ -70,6 +70,19 @@ data_en =
        ret = "data read from the SPI interface"
     },
 
+    {  sig = "void #platform_spi_send_recv_block#( unsigned id, const u8 *txdata, u8 *rxdata, u32 len );",
+       desc = [[Executes $len$ SPI read/write cycles with 8-bit data words. A generic implementation that calls @#platform_spi_send_recv@platform_spi_send_recv@ for each byte 
+  is provided in %src/common.c%. Platforms that can do better (for example with a FIFO or DMA) should implement this function and define $PLATFORM_HAS_SPI_BLOCK$ in their 
+  $platform_generic.h$ file.]],
+       args = 
+       {
+         "$id$ - SPI interface ID",
+         "$txdata$ - data to be sent to the SPI interface. If NULL, 0xFF is sent for each cycle.",
+         "$rxdata$ - buffer for the data read from the SPI interface. If NULL, the data read is discarded.",
+         "$len$ - number of bytes to transfer"
+       }
+    },
+
     { sig = "void #platform_spi_select#( unsigned id, int is_select );",
       desc = [[For platforms that have a dedicates SS (Slave Select) pin in master SPI mode that can be controlled manually, this function should enable/disable this pin. If this functionality
   does not exist in hardware this function does nothing.]],
@@ -35,21 +35,22 @@ data_en =
       },
       ret = "$sample$ - numeric value of conversion, or nil if sample was not available."
     },
-    { sig = "samples = #adc.getsamples#( id, count )",
+    { sig = "samples = #adc.getsamples#( id, [count], [type] )",
       desc = "Get multiple conversion values from the buffer associated with a given channel.",
       args = 
       {
         "$id$ - ADC channel ID.",
-        "$count$ - optional parameter to indicate number of samples to return. If not included, all available samples are returned."
+        "$count$ - optional parameter to indicate number of samples to return. If not included, all available samples are returned.",
+        "$type$ - optional @refman_gen_array.html#array_types@array type@. If specified, the samples are returned in a packed @refman_gen_array.html@array@ of this type instead of a table, which uses much less memory."
       },
-      ret = "$samples$ - table containing integer conversion values. If not enough samples are available, remaining indices will be nil."
+      ret = "$samples$ - table (or packed array) containing integer conversion values. If not enough samples are available, remaining indices will be nil."
     },
     { sig = "#adc.insertsamples#( id, table, idx, count )",
       desc = "Get multiple conversion values from a channel's buffer, and write them into a table.",
       args = 
       {
         "$id$ - ADC channel ID.",
-        "$table$ - table to write samples to. Values at $table$[$idx$] to $table$[$idx$ + $count$ -1] will be overwritten with samples (or nil if not enough samples are available).",
+        "$table$ - table to write samples to. Values at $table$[$idx$] to $table$[$idx$ + $count$ -1] will be overwritten with samples (or nil if not enough samples are available). This can also be a packed @refman_gen_array.html@array@, in which case missing samples are set to 0.",
         "$idx$ - first index to use in the table for writing samples.",
         "$count$ - number of samples to return. If not enough samples are available (after blocking, if enabled) remaining values will be nil."
       }
@@ -95,6 +96,47 @@ data_en =
         "$id$ - ADC channel ID.",
         "$length$ - number of preceding samples to include in moving average filter (must be a power of 2). If 1, filter is disabled. When enabled, a filter buffer is filled before the main conversion buffer, so that averages are always over the same number of samples."
       }
+    },
+    { sig = "#adc.setfilter#( id, [stages] )",
+      desc = [[Set a filter for the samples of a channel. The filter is a list of stages that process each sample in C as soon as it is converted, before it is
+  placed in the conversion buffer (and before the moving average filter set with @#adc.setsmoothing@adc.setsmoothing@). Any pending acquisition on the channel is stopped and its buffered samples are discarded.]],
+      args =
+      {
+        "$id$ - ADC channel ID.",
+        [[$stages (optional)$ - a table with the filter stages, executed in order (at most 8). If not specified, the filter of the channel is removed. Each stage can be:
+  <ul><li>${ adc.FIR, c0, c1, ..., cn }$: a FIR filter with up to 256 coefficients in Q15 format (32768 is 1.0), $c0$ applies to the newest sample.</li>
+  <li>${ adc.IIR, b0, b1, b2, a1, a2 }$: a biquad IIR filter ( $y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]$ ) with coefficients in Q14 format (16384 is 1.0).</li>
+  <li>${ adc.DECIMATE, n }$: keep one sample out of $n$. A FIR stage followed by a decimation stage computes only the samples that are kept.</li></ul>
+  The output of the filter is limited to the range of the converter (0 to @#adc.maxval@adc.maxval@). When decimating, the sample count given to @#adc.sample@adc.sample@ is the number of samples at the output of the filter.]]
+      }
+    },
+    { sig = "#adc.startstream#( id, frames )",
+      desc = [[Start a continuous acquisition on one or more channels. The samples are written by the platform (usually with DMA) directly to a buffer made of two halves and 
+  retrieved one half at a time with @#adc.getsamples_packed@adc.getsamples_packed@, without any processing for each sample (the filters aren't applied). The acquisition 
+  runs at the frequency set with @#adc.setclock@adc.setclock@ until @#adc.stopstream@adc.stopstream@ is called and @#adc.sample@adc.sample@ can't be used in the meantime. Only 
+  available on some platforms.]],
+      args =
+      {
+        "$id$ - ADC channel ID or a table containing a list of channel IDs.",
+        "$frames$ - the size of a half of the buffer, in sequences (a sequence has one sample for each channel), at most 16384 by default."
+      }
+    },
+    { sig = "#adc.stopstream#()",
+      desc = "Stop the continuous acquisition started with @#adc.startstream@adc.startstream@ and free its buffer."
+    },
+    { sig = "data, lost = #adc.getsamples_packed#( [timeout] )",
+      desc = [[Get the samples of the continuous acquisition, one half of the buffer at a time. A half must be read before the next one is filled, otherwise it is
+  lost (overwritten by the platform).]],
+      args =
+      {
+        "$timeout (optional)$ - how long to wait for a half to be filled in microseconds. By default it waits until data is available."
+      },
+      ret =
+      {
+        [[$data$ - the samples as a string of 16-bit values (native byte order), sequence by sequence, each sequence containing one sample for each channel in increasing order 
+  of the channel ID. $nil$ if no data is available before the timeout.]],
+        "$lost$ - the number of halves lost since the last call."
+      }
     }
   }
 }
@@ -0,0 +1,73 @@
+-- eLua reference manual - array module
+
+data_en = 
+{
+
+  -- Title
+  title = "eLua reference manual - array module",
+
+  -- Menu name
+  menu_name = "array",
+
+  -- Overview
+  overview = [[This module implements fixed size arrays of packed numeric values. Each element of a regular Lua table uses a full Lua value, while an element of
+a packed array uses only 1, 2 or 4 bytes, depending on the array type. This makes packed arrays a good fit for large sets of samples, like the ones returned by 
+@refman_gen_adc.html#adc.getsamples@adc.getsamples@ or received with @refman_gen_uart.html#uart.read@uart.read@. An array is indexed like a regular table 
+(from 1 to its capacity) and its size is returned by the $#$ operator.]],
+
+  -- Data structures, constants and types
+  structures = 
+  {
+    { text = [[array.U8
+array.U16
+array.S32
+array.FLOAT]],
+      name = "Array types",
+      desc = "Element types: unsigned 8 bit integer, unsigned 16 bit integer, signed 32 bit integer and single precision floating point. Integer values that don't fit in the element type are truncated."
+    }
+  },
+
+  -- Functions
+  funcs = 
+  {
+    { sig = "arr = #array.new#( capacity, [type], [fill] )",
+      desc = "Create a new packed array.",
+      args = 
+      {
+        "$capacity$ - the number of elements in the array.",
+        "$type$ - optional, the element type (see @#array_types@here@), defaults to $array.S32$.",
+        "$fill$ - optional, the initial value of all the elements, defaults to 0."
+      },
+      ret = "the new array."
+    },
+
+    { sig = "arr = #array.new#( table, [type] )",
+      desc = "Create a new packed array from the array part of a Lua table.",
+      args = 
+      {
+        "$table$ - the table with the initial values of the array.",
+        "$type$ - optional, the element type (see @#array_types@here@), defaults to $array.S32$."
+      },
+      ret = "the new array."
+    },
+
+    { sig = "table = #array.totable#( arr, [first], [last] )",
+      desc = "Copy the elements of a packed array to a new Lua table.",
+      args = 
+      {
+        "$arr$ - the array.",
+        "$first$ - optional, the index of the first element to copy, defaults to 1.",
+        "$last$ - optional, the index of the last element to copy, defaults to the capacity of the array."
+      },
+      ret = "a table with the elements from $first$ to $last$, starting at index 1."
+    },
+
+    { sig = "str = #array.tostring#( arr )",
+      desc = "Return the packed content of the array (in the native byte order of the CPU) as a string.",
+      args = "$arr$ - the array.",
+      ret = "the content of the array as a string."
+    },
+  },
+}
+
+data_pt = data_en
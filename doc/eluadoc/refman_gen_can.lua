@@ -62,6 +62,51 @@ enum
         "$canidtype$ - identifier type as defined @#can_id_types@here@.",
         "$message$ - message in string format, 8 or fewer bytes."
       }
+    },
+
+    { sig = "frames = #can.recvall#( id, [max] )",
+      desc = [[Receive all the pending CAN bus messages (or at most $max$ messages) in a single call. If the interface is buffered (see @#can.set_buffer@can.set_buffer@) 
+  the messages are read from the buffer, otherwise they are read directly from the hardware.]],
+      args =
+      {
+        "$id$ - the ID of the CAN interface.",
+        "$max (optional)$ - maximum number of messages to receive. If not specified or 0, all the pending messages are received."
+      },
+      ret = "an array of messages (empty if no message is pending). Each message is an array with 3 elements: ${ canid, canidtype, message }$."
+    },
+
+    { sig = "#can.set_buffer#( id, [size] )",
+      desc = [[Sets the size of the receive buffer of the CAN interface. When buffering is enabled the received messages are moved from the hardware to the buffer
+  by the $INT_CAN_RX$ interrupt handler, so they are not lost while the Lua code is busy. If the buffer is full, new messages are discarded. Buffering must be enabled
+  in the build (the $can_buffers$ component) and the platform must implement the $INT_CAN_RX$ interrupt.]],
+      args =
+      {
+        "$id$ - the ID of the CAN interface.",
+        "$size (optional)$ - the size of the buffer in messages (a power of 2 between 2 and 32768). If not specified, buffering is disabled."
+      }
+    },
+
+    { sig = "#can.set_filter#( id, idx, canid, mask, canidtype )",
+      desc = [[Sets an acceptance filter on the CAN interface. If at least one filter is set, only the messages that match one of the filters are received, the others are
+  dropped. A message matches a filter if its identifier type is $canidtype$ and $( message_id & mask ) == ( canid & mask )$. The filters are applied in hardware if the 
+  platform supports this and in software otherwise (messages are dropped before reaching the receive buffer in both cases).]],
+      args =
+      {
+        "$id$ - the ID of the CAN interface.",
+        "$idx$ - the index of the filter, between 0 and $can.NUM_FILTERS - 1$.",
+        "$canid$ - CAN identifier to match.",
+        "$mask$ - the bits of the identifier that must match $canid$.",
+        "$canidtype$ - identifier type as defined @#can_id_types@here@."
+      }
+    },
+
+    { sig = "#can.clear_filter#( id, [idx] )",
+      desc = "Removes an acceptance filter from the CAN interface. When all the filters are removed, all the messages are received.",
+      args =
+      {
+        "$id$ - the ID of the CAN interface.",
+        "$idx (optional)$ - the index of the filter. If not specified, all the filters are removed."
+      }
     }
    
   },
@@ -24,6 +24,43 @@ data_en =
       },
     },
     
+    { sig = "id = #elua.budget_new#( soft, hard, [callback] )",
+      desc = [[Allocate a new memory budget. Every memory block allocated by a coroutine is charged to the budget of that coroutine until it is freed (new coroutines inherit the budget of the coroutine that created them). Allocations that would take a budget over its hard limit run a full garbage collection cycle first; if the budget is still over its limit, they fail with a "not enough memory" error in the coroutine that made them, so a runaway script can't starve the rest of the system. Only available if the $membudget$ component is enabled (see @configurator.html@here@).]],
+      args = 
+      {
+        "$soft$ - soft limit in bytes (0 for none). When the budget goes over this limit, $callback$ is called once, at the next point where the garbage collector could run, from a coroutine charged to this budget.",
+        "$hard$ - hard limit in bytes (0 for none).",
+        "$callback$ - optional function called as $callback( id, used )$ when the soft limit is exceeded. It can raise an error to abort the coroutine that went over the limit."
+      },
+      ret = "the budget id, or $nil$ if all the budgets are in use."
+    },
+
+    { sig = "#elua.budget_free#( id )",
+      desc = "Release a memory budget allocated by $elua.budget_new$. The id can't be reused until all the memory charged to it is freed.",
+      args = "$id$ - the budget id.",
+    },
+
+    { sig = "previd = #elua.budget_set#( id, [co] )",
+      desc = "Charge all future allocations of a coroutine to a memory budget.",
+      args = 
+      {
+        "$id$ - the budget id. Budget 0 is the default budget, which has no limits.",
+        "$co$ - optional coroutine, the running coroutine if not specified."
+      },
+      ret = "the id of the budget previously used by the coroutine."
+    },
+
+    { sig = "used, peak, failures = #elua.budget_info#( [id] )",
+      desc = "Return the usage statistics of a memory budget.",
+      args = "$id$ - optional budget id, the budget of the running coroutine if not specified.",
+      ret = 
+      {
+        "$used$ - number of bytes currently charged to the budget.",
+        "$peak$ - highest value of $used$ since the budget was allocated.",
+        "$failures$ - number of allocations refused because of the hard limit."
+      }
+    },
+
     { sig = "#elua.save_history#( filename )",
       desc = "Save the interpreter line history. Only available if linenoise is enabled, check @linenoise.html@here@ for details.",
       args = "$filename$ - the name of the file where the history will be saved. $CAUTION$: the file will be overwritten.",
@@ -0,0 +1,66 @@
+-- eLua reference manual - httpd module
+
+data_en =
+{
+
+  -- Title
+  title = "eLua reference manual - httpd module",
+
+  -- Menu name
+  menu_name = "httpd",
+
+  -- Overview
+  overview = [[This module implements a small HTTP/1.1 server on top of the TCP/IP stack of eLua. It can be enabled only if networking support is also enabled
+  (see @building.html@building@ for details). The requests are served by Lua functions (the $handlers$) or, if a root directory is given, by the
+  files in that directory. The server keeps the connections open between requests ($keep-alive$) and serves up to 4 connections at the same time
+  ($HTTPD_MAX_CONNS$ in %src/modules/httpd.c%); a connection that doesn't send a new request in 5 seconds is closed.</p>
+  <p>The files from a file system that keeps them in memory (for example the ROM file system) are sent directly from memory, without copying them to a
+  buffer first (see $elua_net_send_static$ in %inc/elua_net.h%). The files from the other file systems are read in blocks of 512 bytes.</p>
+  <p>The server has some limits: the request line and each header line must fit in 256 bytes ($HTTPD_LINE_SIZE$), a request can have at most 32
+  headers ($HTTPD_MAX_HEADERS$) and the body of a request (which must have a $Content-Length$ header) can have at most 4096 bytes
+  ($HTTPD_MAX_BODY$). The requests that exceed these limits are answered with an error status (400, 413, 414 or 431) and their connection is closed.
+  Chunked request bodies are not supported (501).</p>
+  <p><span class="warning">NOTE:</span> @#httpd.serve@httpd.serve@ doesn't return until the server is stopped, so the script does nothing else
+  while the server runs; the Lua interrupt handlers are not called while the server waits for requests.]],
+
+  -- Functions
+  funcs =
+  {
+    { sig = "#httpd.serve#( port, handlers, [root] )",
+      desc = [[Starts the server and serves the requests until @#httpd.stop@httpd.stop@ is called (by a handler) or a Lua error occurs outside a
+  handler. The keys of the $handlers$ table are the paths of the requests (for example $"/status"$), optionally preceded by a method and a space (for
+  example $"POST /led"$); the handler for the method and the path is used if it exists, otherwise the handler for the path. A handler is called with
+  a table that describes the request:
+  <ul>
+    <li>$method$ - the method of the request ($"GET"$, $"POST"$ ...).</li>
+    <li>$path$ - the path of the request, with the URL escapes decoded.</li>
+    <li>$query$ - the part of the URL after $?$ (not decoded) or an empty string.</li>
+    <li>$headers$ - a table with the headers of the request; the names of the headers are in lowercase.</li>
+    <li>$body$ - the body of the request or $nil$.</li>
+  </ul>
+  and returns $status, body, headers$:
+  <ul>
+    <li>$status$ - the status of the response (200 if it isn't a number).</li>
+    <li>$body$ - the body of the response, either a string or a function. The function is called repeatedly and returns the next part of the body
+  or $nil$ at the end; the parts are sent as they are produced (with the $chunked$ encoding of HTTP/1.1), so the body doesn't have to be
+  kept in memory.</li>
+    <li>$headers$ - an optional table with more headers for the response (for example ${ ["Content-Type"] = "text/plain" }$). The default
+  $Content-Type$ is $text/html$.</li>
+  </ul>
+  An error in a handler is printed and the request is answered with the 500 status. The requests without a handler are answered with a file from
+  $root$ ($GET$ and $HEAD$ only, with $index.html$ for the paths that end with $/$) or with the 404 status.]],
+      args =
+      {
+        "$port$ - the TCP port of the server.",
+        "$handlers$ - the table of handlers (it can be empty).",
+        [[$root (optional)$ - the directory of the files served by the server (for example $"/rom"$). If not given, only the handlers are used.]]
+      }
+    },
+
+    { sig = "#httpd.stop#()",
+      desc = [[Stops the server: @#httpd.serve@httpd.serve@ returns after the current request was answered and the connections were closed.]]
+    }
+  }
+}
+
+data_pt = data_en
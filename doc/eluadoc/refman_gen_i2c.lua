@@ -67,6 +67,33 @@ data_en =
         "$numbytes$ - the number of bytes to read."
       },
       ret = "a string with all the data read from the I2C interface."
+    },
+
+    { sig = "data = #i2c.transfer#( id, address, [txdata], [rxlen] )",
+      desc = [[Executes a complete I2C transaction with a single call: START, send $address$ as a transmitter, write $txdata$, repeated START, send $address$ as a receiver, 
+  read $rxlen$ bytes, STOP. The write part is skipped if $txdata$ is empty and the read part is skipped if $rxlen$ is 0. If both are missing, only the address is sent, which 
+  can be used to check if a slave is present.]],
+      args =
+      {
+        "$id$ - the ID of the I2C interface.",
+        "$address$ - the address of the slave.",
+        "$txdata (optional)$ - a string with the data to write.",
+        "$rxlen (optional)$ - the number of bytes to read (default 0)."
+      },
+      ret = "a string with the data read from the slave, or $nil$ if the slave didn't acknowledge its address or the data sent to it."
+    },
+
+    { sig = "data = #i2c.readreg#( id, address, register, [count] )",
+      desc = [[Reads one or more consecutive registers of a slave that uses the common I2C register access protocol (the register number is written first, then the register 
+  data is read). It is the same as $i2c.transfer( id, address, string.char( register ), count )$.]],
+      args =
+      {
+        "$id$ - the ID of the I2C interface.",
+        "$address$ - the address of the slave.",
+        "$register$ - the number of the first register (0 to 255).",
+        "$count (optional)$ - the number of bytes to read (default 1)."
+      },
+      ret = "a string with the register data, or $nil$ if the slave didn't acknowledge."
     }
    
   },
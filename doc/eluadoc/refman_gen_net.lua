@@ -14,7 +14,21 @@ data_en =
   (see @building.html@building@ for details).</p>
   <p><span class="warning">NOTE:</span> TCP/IP support is $experimental$ in eLua. While functional, it's still slow and suffers from a number of
   other issues. It will most likely change a lot in the future, so expect major changes to this module as well.</p>
-  <p><span class="warning">NOTE:</span> currently, only TCP sockets are supported by eLua.]],
+  <p>UDP sockets ($net.SOCK_DGRAM$) send datagrams with @#net.sendto@net.sendto@ and receive them with @#net.recvfrom@net.recvfrom@. The datagrams
+  received by a socket wait in a small queue (two full size datagrams by default, see $ELUA_NET_UDP_QUEUE_SIZE$ in %src/elua_uip.c%); the datagrams that
+  don't fit in the queue are dropped. UDP sockets use the UDP connections of uIP that are not used by the DHCP client and the DNS resolver.</p>
+  <p>The functions that wait for the network accept a timeout. With a timeout of 0 ($net.NO_TIMEOUT$) they never wait, so a single script can serve
+  more than one connection, using @#net.select@net.select@ to find the sockets that are ready.</p>
+  <p>Each TCP socket has a receive buffer, which keeps the data received while the script doesn't read it; @#net.recv@net.recv@ returns the data
+  already in the buffer right away. The window advertised to the remote host is the room left in the buffer, so the remote host stops sending when the
+  buffer is full instead of sending data that would be dropped. The size of the buffer is set by the $rx_buf_size$ attribute of the $tcpip$ component in
+  the board configuration (by default the receive window of uIP, see $UIP_CONF_RECEIVE_WINDOW$); @#net.rxstats@net.rxstats@ shows how it is used. A
+  connection received by a port that @#net.accept@net.accept@ listens to can receive data in a buffer before it is accepted. The data sent with
+  @#net.send@net.send@ goes through the send buffer of the socket (a few TCP segments, see $UIP_CONF_TCP_SND_WND$ in the %uip-conf.h% file of the
+  platform), which keeps it until the remote host acknowledges it, so more than one segment can be in transit. If the platform supports it, the
+  $INT_NET_EVENT$ interrupt signals the
+  events on the sockets (new connection, data received, send finished or connection closed) with the socket as resource number (for a new connection
+  it is the socket that @#net.accept@net.accept@ will return).]],
 
   -- Structures
   structures =
@@ -75,16 +89,74 @@ argument. The IP is given as a string.]],
     },
 
 
+    { sig = "res = #net.chksum#( str, [i, j] )",
+      desc = [[Computes the Internet checksum (RFC 1071, as in the IP, UDP and TCP headers) of a string, using the checksum code of the TCP/IP stack.]],
+      args =
+      {
+        "$str$ - the data.",
+        [[$i, j (optional)$ - only use the bytes from $i$ to $j$ of the string (with the same meaning as in $string.sub$). Up to 65535 bytes can be used.]]
+      },
+      ret = "$res$ - the checksum (the one's complement of the one's complement sum of the 16-bit words of the data)."
+    },
+
     { sig = "ip = #net.lookup#( hostname )",
-      desc = "Does a DNS lookup.",
+      desc = [[Does a DNS lookup. The answers are cached for the time given by the name server (their TTL), but at most 1 hour, and the names that
+  don't exist are cached for 60 seconds. The number of cached names and these times can be changed in the configurator (see
+  @configurator.html@the configurator@). See also @#net.dnsstats@net.dnsstats@.]],
       args = "$hostname$ - the name of the computer.",
-      ret = "The IP address of the computer."
+      ret = "The IP address of the computer (0 if the name was not found)."
     },
 
     { sig = "socket = #net.socket#( type )",
       desc = "Create a socket for TCP/IP communication.",
-      args = [[$type$ - can be either $net.SOCK_STREAM$ for TCP sockets or $net.SOCK_DGRAM$ for UDP sockets (<span class="warning">not yet supported</span>).]],
-      ret = "The socket that will be used in subsequent operations."
+      args = [[$type$ - can be either $net.SOCK_STREAM$ for TCP sockets or $net.SOCK_DGRAM$ for UDP sockets.]],
+      ret = "The socket that will be used in subsequent operations (-1 for error)."
+    },
+
+    { sig = "res = #net.bind#( sock, port )",
+      desc = "Set the local port of a UDP socket (a new UDP socket gets a free port chosen by the TCP/IP stack).",
+      args =
+      {
+        "$sock$ - a UDP socket obtained from @#net.socket@net.socket@.",
+        "$port$ - the local port."
+      },
+      ret = "$res$ - 0 for success, -1 for error (for example if the port is used by another socket)."
+    },
+
+    { sig = "res, err = #net.sendto#( sock, str, ip, port )",
+      desc = [[Send a datagram from a UDP socket. The function returns after the datagram was passed to the Ethernet driver.
+  <span class="warning">NOTE:</span> if the Ethernet address of the remote system is not known yet, the datagram is replaced by an ARP request, so it is lost.]],
+      args =
+      {
+        "$sock$ - a UDP socket obtained from @#net.socket@net.socket@.",
+        "$str$ - the data to send (it must fit in a single Ethernet frame).",
+        "$ip$ - the IP address of the remote system obtained from @#net.packip@net.packip@.",
+        "$port$ - the port of the remote system."
+      },
+      ret =
+      {
+        "$res$ - the number of bytes sent or -1 for error.",
+        "$err$ - the error code, as defined @#error_codes@here@."
+      }
+    },
+
+    { sig = "res, remoteip, port, err = #net.recvfrom#( sock, maxsize, [timer_id, timeout] )",
+      desc = "Receive a datagram on a UDP socket with an optional timeout. The part of the datagram that doesn't fit in $maxsize$ bytes is lost.",
+      args =
+      {
+        "$sock$ - a UDP socket obtained from @#net.socket@net.socket@.",
+        "$maxsize$ - the maximum number of bytes to return.",
+        [[$timer_id (optional)$ - the ID of the timer used for measuring the timeout. Use $nil$ or $tmr.SYS_TIMER$ to specify the @arch_platform_timers.html#the_system_timer@system timer@.]],
+        [[$timeout (optional)$ - timeout of the operation, can be either $net.NO_TIMEOUT$ or 0 for non-blocking operation, $net.INF_TIMEOUT$ for
+blocking operation, or a positive number that specifies the timeout in microseconds. The default value of this argument is $net.INF_TIMEOUT$.]]
+      },
+      ret =
+      {
+        "$res$ - the data of the datagram.",
+        "$remoteip$ - the IP of the sender.",
+        "$port$ - the port of the sender.",
+        "$err$ - the error code, as defined @#error_codes@here@ ($net.ERR_OVERFLOW$ if the datagram didn't fit in $maxsize$ bytes, $net.ERR_TIMEDOUT$ if no datagram was received)."
+      }
     },
 
     { sig = "res = #net.close#( socket )",
@@ -105,7 +177,7 @@ argument. The IP is given as a string.]],
     },
 
     { sig = "socket, remoteip, err = #net.accept#( port, [timer_id, timeout] )",
-      desc = "Accept a connection from a remote system with an optional timeout.",
+      desc = "Accept a connection from a remote system with an optional timeout. The port keeps listening after the call, the connections received in the meantime are returned by the next calls.",
       args =
       {
         "$port$ - the port to wait for connections from the remote system.",
@@ -122,22 +194,26 @@ blocking operation, or a positive number that specifies the timeout in microseco
       }
     },
 
-    { sig = "res, err = #net.send#( sock, str )",
-      desc = "Send data to a socket.",
+    { sig = "res, err = #net.send#( sock, str, [timer_id, timeout] )",
+      desc = [[Send data to a socket. The data is copied to the send buffer of the socket and sent from there while the script runs; the function waits until
+  all the data was copied (or the timeout expires). @#net.close@net.close@ waits until the remote host acknowledges the data still in the buffer.]],
       args = 
       {
         "$sock$ - the socket.",
-        "$str$ - the data to send."
+        "$str$ - the data to send.",
+        [[$timer_id (optional)$ - the ID of the timer used for measuring the timeout. Use $nil$ or $tmr.SYS_TIMER$ to specify the @arch_platform_timers.html#the_system_timer@system timer@.]],
+        [[$timeout (optional)$ - timeout of the operation, can be either $net.NO_TIMEOUT$ or 0 for non-blocking operation, $net.INF_TIMEOUT$ for 
+blocking operation, or a positive number that specifies the timeout in microseconds.]]
       },
       ret = 
       {
-        "$res$ - the number of bytes actually sent or -1 for error.",
-        "$err$ - the error code, as defined @#error_codes@here@."
+        "$res$ - the number of bytes copied to the send buffer or -1 for error.",
+        "$err$ - the error code, as defined @#error_codes@here@ ($net.ERR_TIMEDOUT$ if no data could be copied before the timeout)."
       }
     },
 
     { sig = "res, err = #net.recv#( sock, format, [timer_id, timeout] )",
-      desc = "Read data from a socket.",
+      desc = "Read data from a socket. The data already in the receive buffer of the socket (see @#overview@overview@) is returned right away.",
       args = 
       {
         "$sock$ - the socket.",
@@ -155,6 +231,75 @@ blocking operation, or a positive number that specifies the timeout in microseco
         "$res$ - the number of bytes read.",
         "$err$ - the error code, as defined @#error_codes@here@."
       }
+    },
+
+    { sig = "readable, writable = #net.select#( recvt, [sendt], [timer_id, timeout] )",
+      desc = [[Wait until some sockets are ready. A socket is ready for reading if @#net.recv@net.recv@ can return data right away (or the connection was closed) and
+  ready for writing if there is room in its send buffer. UDP sockets are ready for reading if they received a datagram. The function also returns early (with empty tables) if there are Lua interrupts waiting to be handled.]],
+      args =
+      {
+        "$recvt$ - an array with the sockets to check for reading.",
+        "$sendt (optional)$ - an array with the sockets to check for writing.",
+        [[$timer_id (optional)$ - the ID of the timer used for measuring the timeout. Use $nil$ or $tmr.SYS_TIMER$ to specify the @arch_platform_timers.html#the_system_timer@system timer@.]],
+        [[$timeout (optional)$ - timeout of the operation, can be either $net.NO_TIMEOUT$ or 0 to only check the sockets, $net.INF_TIMEOUT$ to wait
+until a socket is ready, or a positive number that specifies the timeout in microseconds. The default value of this argument is $net.INF_TIMEOUT$.]]
+      },
+      ret =
+      {
+        "$readable$ - an array with the sockets from $recvt$ that are ready for reading.",
+        "$writable$ - an array with the sockets from $sendt$ that are ready for writing."
+      }
+    },
+
+    { sig = "queued, buffered, dropped = #net.rxstats#( sock, [reset] )",
+      desc = [[Get the statistics of the receive buffer of a TCP socket (see @#overview@overview@).]],
+      args =
+      {
+        "$sock$ - the socket.",
+        "$reset (optional)$ - if $true$, the $buffered$ and $dropped$ counters are cleared after they are read."
+      },
+      ret =
+      {
+        "$queued$ - the number of bytes waiting in the buffer.",
+        "$buffered$ - the number of bytes received in the buffer.",
+        [[$dropped$ - the number of bytes dropped because they didn't fit in the buffer (they are sent again by the remote host, so they are not lost, but
+  they waste bandwidth).]]
+      }
+    },
+
+    { sig = "segments, bytes = #net.telnetstats#( [reset] )",
+      desc = [[Get the statistics of the console over TCP/IP (telnet) since the telnet client connected. The console output is gathered in segments
+  that are sent when they are full, when the console reads, when $io.flush$ is called or after a short delay, so $bytes / segments$ shows how
+  well the output is grouped. Only available if the console over TCP/IP is enabled.]],
+      args = "$reset (optional)$ - if $true$, the counters are cleared after they are read.",
+      ret =
+      {
+        "$segments$ - the number of TCP segments of console output sent (without the retransmissions).",
+        "$bytes$ - the number of bytes of console output sent in these segments."
+      }
+    },
+
+    { sig = "hits, misses = #net.arpstats#( [reset] )",
+      desc = [[Get the statistics of the ARP table, which keeps the Ethernet addresses of the computers on the local network. Each IP packet sent looks up
+  the address of its destination (or of the gateway); a miss sends an ARP request instead of the packet, which is sent again later. The size of the
+  table can be changed in the configurator (see @configurator.html@the configurator@).]],
+      args = "$reset (optional)$ - if $true$, the counters are cleared after they are read.",
+      ret =
+      {
+        "$hits$ - the number of packets sent with an address from the table.",
+        "$misses$ - the number of packets replaced by an ARP request."
+      }
+    },
+
+    { sig = "hits, neghits, misses = #net.dnsstats#( [reset] )",
+      desc = [[Get the statistics of the cache of @#net.lookup@net.lookup@. Only available if the DNS resolver is enabled.]],
+      args = "$reset (optional)$ - if $true$, the counters are cleared after they are read.",
+      ret =
+      {
+        "$hits$ - the number of lookups answered with an address from the cache.",
+        "$neghits$ - the number of lookups answered from the cache with a name that doesn't exist.",
+        "$misses$ - the number of lookups that sent a query to the name server."
+      }
     }
   },
 }
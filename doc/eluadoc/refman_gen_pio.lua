@@ -16,7 +16,8 @@ data_en =
   and $PC$, you can reffer to them using $pio.PA$, $pio.PB$ and $pio.PC$, respectively. If your CPU uses $P0$, $P1$, $P2$ instead of $PA$, $PB$ and $PC$, 
   you can simply use $pio.P0$, $pio.P1$ and $pio.P2$ instead.</p>
   <p>You can also reffer to individual $pins$ instead of ports. With the same notation as above, $pio.PA_0$ refers to the first pin of port $PA$, 
-  $P0_15$ refers to the 16th pin of port $P0$ and so on.
+  $P0_15$ refers to the 16th pin of port $P0$ and so on. A name is parsed only the first time it is used, after that its value is returned from a small
+  cache.
   ]],
 
   -- Functions
@@ -192,6 +193,28 @@ data_en =
       }
     },
 
+    { sig = "snapshot = #pio.port.snapshot#( [port1], [port2], ..., [portn] )",
+      desc = "Read the value of one or more ports at once. The ports are read with interrupts disabled, one right after the other, so the values are consistent with each other (for example for a parallel bus spread over more than one port).",
+      args =
+      {
+        "$port1 (optional)$ - the first port. If no port is given, all the ports of the CPU are read.",
+        "$port2 (optional)$ - the second port",
+        "$portn (optional)$ - the %n%-th port"
+      },
+      ret = "a table indexed by port ($pio.PA$, $pio.PB$ ...) with the value of each port. It can be given directly to @#pio.port.apply@pio.port.apply@ to restore the ports later."
+    },
+
+    { sig = "#pio.port.apply#( changes )",
+      desc = [[Change pins on one or more ports at once. All the changes are merged per port before accessing the hardware, then written with interrupts disabled with a single register write for a whole port
+  value, or at most a "set" and a "clear" write for the other cases (instead of one call for each pin or port).]],
+      args =
+      {
+        [[$changes$ - a table indexed by ports and pins. A port entry ($[ pio.PA ] = value$) sets the value of the whole port, while a masked port entry
+  ($[ pio.PA ] = { value, mask }$) changes only the pins in $mask$. A pin entry ($[ pio.PB_3 ] = 1$) sets a single pin to 0 or 1 and takes precedence over a port value
+  given in the same table.]]
+      }
+    },
+
     { sig = "port, pin = #pio.decode#( resnum )",
       desc = "Convert a PIO resource number to the corresponding port and pin. This is most commonly used in GPIO edge interrupt routines to convert the Lua interrupt routine's argument to the port and pin that caused the interrupt but it can also be used on the values returned by the pin names pio.PA_0, pio.P2_15 and so on.",
       args =
@@ -204,6 +227,38 @@ data_en =
         "$pin$ - the pin number, usually from 0 to 31",
       },
     },
+
+    { sig = "#pio.waveform.play#( steps, [count] )",
+      desc = [[Replays a timed sequence of pin changes from C, without the overhead of the Lua VM between the edges. Each step drives some pins of a port to a value, then waits
+  a number of microseconds. The delays are measured from the start of the waveform using the system timer, so the time spent changing the pins doesn't accumulate. Useful for
+  bit-banged protocols and sensor strobes.]],
+      args =
+      {
+        [[$steps$ - the steps of the waveform. It can be either an @refman_gen_array.html@array@ of type $array.S32$ with 4 elements ( $port, mask, value, delay$ ) 
+  for each step (used as is, without any conversion) or a table of ${ port, mask, value, delay }$ tables. $port$ is a port code such as $pio.PA$, the pins in $mask$ are set to 
+  the corresponding bits of $value$ and $delay$ is given in microseconds.]],
+        "$count (optional)$ - how many times to play the waveform, 1 by default."
+      }
+    },
+
+    { sig = "data, n = #pio.waveform.capture#( port, mask, maxentries | array, timeout )",
+      desc = [[Records the changes of some pins of a port, using the system timer for timestamps. The function returns when $maxentries$ entries were recorded or when $timeout$ 
+  microseconds passed without reaching this number.]],
+      args =
+      {
+        "$port$ - the port code (for example $pio.PB$).",
+        "$mask$ - the mask of the pins to monitor.",
+        [[$maxentries$ - the maximum number of entries. An $array.S32$ @refman_gen_array.html@array@ can be given instead, in which case the entries are recorded directly in it 
+  (its length must be at least twice the number of entries).]],
+        "$timeout$ - the maximum duration of the capture in microseconds."
+      },
+      ret =
+      {
+        [[$data$ - an $array.S32$ with ( $timestamp, value$ ) pairs, one for each entry: the timestamp in microseconds since the start of the capture and the new value of the pins in
+  $mask$. The first entry is always the value of the pins at the start of the capture (timestamp 0).]],
+        "$n$ - the number of entries."
+      }
+    },
    
   }
 
@@ -51,6 +51,40 @@ duty cycles (particulary 0 and 100) might not be achievable.]]
        desc = "Get the base clock of the given PWM module.",
        args = "$id$ - the ID of the PWM module.",
        ret = "The base clock of the PWM module."
+    },
+
+    { sig = "#pwm.update#( duties )",
+      desc = [[Change the duty cycles of several PWM modules at once (for example the three phases of a motor drive). On the platforms that support it, all the new
+duty cycles take effect at the start of the same PWM period, otherwise the modules are reprogrammed one after the other with interrupts disabled. The modules must
+be set up with @#pwm.setup@pwm.setup@ first, their frequency doesn't change.]],
+      args = "$duties$ - a table with the new duty cycles (in percents) indexed by PWM module ID, for example ${ [ 0 ] = 25, [ 1 ] = 50, [ 2 ] = 75 }$."
+    },
+
+    { sig = "#pwm.startseq#( timer_id, period, ids, duties, [count] )",
+      desc = [[Play a sequence of duty cycles on one or more PWM modules from the match interrupt of a timer, without running any Lua code. The first step is applied
+right away, then the sequencer moves to the next step every $period$ microseconds. After the last repetition the PWM modules keep the duty cycles of the last step.
+Only one sequence can be played at a time, starting a new sequence stops the previous one. This function is available only if the platform supports timer match
+interrupts and C interrupt handlers.]],
+      args =
+      {
+        [[$timer_id$ - the ID of the timer that paces the sequence (it can be a virtual timer). The timer is used exclusively by the sequencer until
+@#pwm.stopseq@pwm.stopseq@ is called.]],
+        "$period$ - the duration of each step in microseconds.",
+        "$ids$ - a table with the IDs of the PWM modules in the sequence, which must be set up with @#pwm.setup@pwm.setup@ first.",
+        [[$duties$ - the duty cycles (in percents). It can be either an @refman_gen_array.html@array@ of type $array.U8$ with a duty cycle for each module in $ids$
+for each step, or a table of steps, each step being a table with a duty cycle for each module in $ids$. The duty cycles are copied, so $duties$ can be changed
+after this call.]],
+        "$count (optional)$ - how many times to play the sequence, 0 (the default) to play it until @#pwm.stopseq@pwm.stopseq@ is called."
+      }
+    },
+
+    { sig = "#pwm.stopseq#()",
+      desc = "Stop the sequence started with @#pwm.startseq@pwm.startseq@ and release its timer. The PWM modules keep their current duty cycles."
+    },
+
+    { sig = "active = #pwm.seqactive#()",
+      desc = "Check if a sequence started with @#pwm.startseq@pwm.startseq@ is still playing.",
+      ret = "$true$ if the sequence is playing, $false$ if it was stopped or all its repetitions were played."
     }
   },
 
@@ -61,6 +61,73 @@ data_en =
         "$datan (optional)$ - the %n%-th string/number to send."
       },
       ret = "An array with all the data read from the SPI interface."
+    },
+
+    { sig = "rxdata = #spi.transfer#( id, txdata, [rxlen] )",
+      desc = [[Write a string to the SPI interface and return the data read from the same interface as a string. The data is transferred in blocks, so this is much faster than 
+  $spi.readwrite$ for large transfers and it doesn't create a Lua table. If $rxlen$ is larger than the length of $txdata$, 0xFF is sent for the remaining bytes. Only 8-bit SPI data 
+  words are supported.]],
+      args =
+      {
+        "$id$ - the ID of the SPI interface.",
+        "$txdata$ - the string to send, or $nil$ to only receive data.",
+        "$rxlen (optional)$ - the number of bytes to receive. Defaults to the length of $txdata$. Use 0 to only send data."
+      },
+      ret = "A string with the data read from the SPI interface."
+    },
+
+    { sig = "count = #spi.transfer#( id, txdata, array )",
+      desc = [[Same as the above function, but the received data is written in a packed @refman_gen_array.html@array@ instead of a string, so the same buffer can be reused 
+  for each transfer. The length of the transfer is the size of the array.]],
+      args =
+      {
+        "$id$ - the ID of the SPI interface.",
+        "$txdata$ - the string to send, or $nil$ to only receive data.",
+        "$array$ - the array that receives the data."
+      },
+      ret = "The number of bytes written in $array$."
+    },
+
+    { sig = "dev = #spi.device#( id, clock, cpol, cpha, databits, [cs] )",
+      desc = [[Create a SPI device handle. A device remembers the configuration of the SPI interface and the chip select pin of a single slave. Before each transaction, the 
+  interface is reconfigured only if its current configuration is different from the device configuration, so many devices can share the same SPI interface efficiently.]],
+      args =
+      {
+        "$id$ - the ID of the SPI interface.",
+        "$clock$ - the clock of the SPI interface.",
+        "$cpol$ - the clock polarity (0 or 1).",
+        "$cpha$ - the clock phase (0 or 1).",
+        "$databits$ - the length of the SPI data word.",
+        "$cs (optional)$ - a pin (for example $pio.PA_3$) used as an active low chip select. The pin is configured as an output. If not specified, the dedicated SS line of the SPI interface is used (see @#spi.sson@spi.sson@)."
+      },
+      ret = "The device handle."
+    },
+
+    { sig = "rxdata = #dev:transfer#( txdata, [rxlen] )",
+      desc = [[Execute a complete transaction on a device: configure the SPI interface (if needed), select the device, transfer the data (like @#spi.transfer@spi.transfer@) 
+  and deselect the device. An array can also be given instead of $rxlen$, like in @#spi.transfer@spi.transfer@.]],
+      args =
+      {
+        "$txdata$ - the string to send, or $nil$ to only receive data.",
+        "$rxlen (optional)$ - the number of bytes to receive. Defaults to the length of $txdata$."
+      },
+      ret = "A string with the data read from the device (or the number of bytes written in the array)."
+    },
+
+    { sig = "transfers, bytes = #dev:stats#( [reset] )",
+      desc = "Return the transfer counters of a device.",
+      args = "$reset (optional)$ - if $true$, the counters are cleared after they are read.",
+      ret =
+      {
+        "$transfers$ - the number of transactions executed on this device.",
+        "$bytes$ - the number of bytes transferred to/from this device."
+      }
+    },
+
+    { sig = "rxdata1, rxdata2, ..., rxdatan = #spi.batch#( transactions )",
+      desc = [[Execute a list of transactions, possibly on different devices, with a single call. Each transaction is executed exactly like @#dev:transfer@dev:transfer@.]],
+      args = "$transactions$ - an array of transactions. Each transaction is an array ${ dev, txdata, [rxlen] }$.",
+      ret = "The result of each transaction, in order."
     }
    
   },
@@ -109,6 +109,24 @@ $NOTE:$ this function does not work with virtual timers or the system timer.]]
         "$period$ - the interrupt period in microseconds. Setting this to 0 disabled the timer match interrupt.",
         "$type$ - $tmr.INT_ONESHOT$ to generate a single interrupt after $period$ microseconds, or $tmr.INT_CYCLIC$ to generate interrupts every $period$ microseconds.",
       }
+    },
+
+    { sig = "handle = #tmr.schedule#( period, func, [periodic] )",
+      desc = [[Schedule a Lua function to be called after $period$ microseconds using a software timer. Any number of callbacks (up to the $swtmr$ limit set in the board
+  configuration) can be pending at the same time without using any hardware timer. The software timers are advanced from the system timer interrupt, so their resolution 
+  can't be better than the period of this interrupt. The callbacks are called from the Lua interrupt handler, so interrupt support must be enabled (check @inthandlers.html@here@).]],
+      args =
+      {
+        "$period$ - the delay (or the period for a periodic callback) in microseconds. The period of a periodic callback must be greater than 0.",
+        "$func$ - the function to call. It receives the handle of the timer as its only argument.",
+        "$periodic (optional)$ - $true$ to call the function every $period$ microseconds until it is cancelled, $false$ (default) to call it only once."
+      },
+      ret = "a handle that can be given to @#tmr.cancel@tmr.cancel@."
+    },
+
+    { sig = "#tmr.cancel#( handle )",
+      desc = "Cancel a callback scheduled with @#tmr.schedule@tmr.schedule@. Cancelling a callback that was already called (or already cancelled) has no effect.",
+      args = "$handle$ - the handle returned by @#tmr.schedule@tmr.schedule@."
     }
 
   }
@@ -76,6 +76,7 @@ blocking operation, or a positive number that specifies the timeout in microseco
   <li>$'*n'$ - read an integer. The integer can optionally have a sign. Reading continues until the first non-digit character is detected or a timeout occurs. This is the only case in which $read$ returns a number instead of an integer.</li>
   <li>$'*s'$ - read until a spacing character (like a space or a TAB) is found (the spacing character is not returned) or a timeout occurs.</li>
   <li>$a positive number$ - read at most this many characters before returning (reading can stop earlier if a timeout occurs).</li>
+  <li>$a packed array$ - read at most as many characters as the capacity of the @refman_gen_array.html@array@, storing one character in each element. In this case $read$ returns the number of characters read.</li>
 </ul>]],
         [[$timeout (optional)$ - timeout of the operation, can be either $uart.NO_TIMEOUT$ or 0 for non-blocking operation, $uart.INF_TIMEOUT$ for 
 blocking operation, or a positive number that specifies the timeout in microseconds. The default value of this argument is $uart.INF_TIMEOUT$.]],
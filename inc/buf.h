@@ -13,8 +13,9 @@ enum
 {
   BUF_ID_UART = 0,
   BUF_ID_ADC = 1,
+  BUF_ID_CAN = 2,
   BUF_ID_FIRST = BUF_ID_UART,
-  BUF_ID_LAST = BUF_ID_ADC,
+  BUF_ID_LAST = BUF_ID_CAN,
   BUF_ID_TOTAL = BUF_ID_LAST - BUF_ID_FIRST + 1
 };
 
@@ -52,7 +53,9 @@ enum
 {
   BUF_DSIZE_U8 = 0,
   BUF_DSIZE_U16,
-  BUF_DSIZE_U32
+  BUF_DSIZE_U32,
+  BUF_DSIZE_U64,
+  BUF_DSIZE_U128
 };
 
 
@@ -13,6 +13,17 @@
 #define VTMR_GET_ID( x )        ( ( x ) - VTMR_FIRST_ID )
 #define TIMER_IS_VIRTUAL( x )   ( ( VTMR_NUM_TIMERS > 0 ) && ( ( x ) >= VTMR_FIRST_ID ) && ( ( x ) < VTMR_NUM_TIMERS + VTMR_FIRST_ID ) )
 
+// Software timers data
+// A handle has the timer index in its low SWTMR_ID_BITS bits and an allocation
+// counter in the high bits. A valid handle is never 0.
+#define SWTMR_ID_BITS           10
+#define SWTMR_GET_ID( x )       ( ( x ) & ( ( 1 << SWTMR_ID_BITS ) - 1 ) )
+
+// PWM duty sequencer errors (cmn_pwm_seq_start can also return the
+// PLATFORM_TIMER_INT_xxx codes of platform_timer_set_match_int)
+#define CMN_PWM_SEQ_NOT_SETUP   ( -1 )
+#define CMN_PWM_SEQ_NO_MEMORY   ( -2 )
+
 // FS interface
 #define CMN_FS_INFO_BEFORE_READDIR      0
 #define CMN_FS_INFO_INSIDE_READDIR      1
@@ -46,6 +57,18 @@ void cmn_systimer_set_interrupt_freq( u32 freq_hz );
 void cmn_systimer_set_interrupt_period_us( u32 period );
 void cmn_systimer_periodic(void);
 timer_data_type cmn_systimer_get(void);
+// Software timers (timer wheel)
+void cmn_swtmr_run(void);
+int cmn_swtmr_start( timer_data_type delay_us, timer_data_type period_us );
+int cmn_swtmr_stop( unsigned handle );
+int cmn_swtmr_is_periodic( unsigned handle );
+int cmn_swtmr_int_set_status( elua_int_resnum resnum, int status );
+int cmn_swtmr_int_get_status( elua_int_resnum resnum );
+int cmn_swtmr_int_get_flag( elua_int_resnum resnum, int clear );
+// PWM duty sequencer
+int cmn_pwm_seq_start( unsigned timer_id, timer_data_type period_us, unsigned nch, const u8 *ids, const u8 *duties, unsigned nsteps, unsigned count );
+void cmn_pwm_seq_stop(void);
+int cmn_pwm_seq_is_active(void);
 // Filesystem-related functions
 int cmn_fs_walkdir( const char *path, p_cmn_fs_walker_cb cb, void *pdata, int recursive );
 char* cmn_fs_split_path( const char *path, const char **pmask );
@@ -2,8 +2,37 @@
 #define __ELUA_ADC_H__
 
 #include "platform_conf.h"
+#include "platform.h"
 
 
+// Filter stage types
+enum
+{
+  ADC_FILTER_FIR,
+  ADC_FILTER_IIR,
+  ADC_FILTER_DECIMATE
+};
+
+#define ADC_FILTER_IIR_NUM_COEFS  5
+
+// A stage of a channel filter. FIR coefficients are in Q15 format, IIR
+// (biquad) coefficients are b0, b1, b2, a1, a2 in Q14 format
+typedef struct
+{
+  u8              type;
+  u16             len; // FIR: number of taps, decimation: the factor
+  u16             pos; // FIR: position in the delay line, decimation: counter
+  s16             *coefs;
+  s32             *state; // FIR: delay line, IIR: x[n-1], x[n-2], y[n-1], y[n-2]
+} elua_adc_filter_stage;
+
+typedef struct
+{
+  u16                   maxval;
+  u8                    nstages;
+  elua_adc_filter_stage stages[ 1 ];
+} elua_adc_filter;
+
 typedef struct 
 {
   // Status Bit Flags
@@ -20,6 +49,8 @@ typedef struct
   volatile u32    smoothsum;
   u16             *smoothbuf;
 
+  elua_adc_filter *filter;
+
   volatile u16    reqsamples;
   volatile u16    *value_ptr;
 } elua_adc_ch_state;
@@ -38,6 +69,27 @@ typedef struct
   volatile u8         seq_ctr, seq_len;
 } elua_adc_dev_state;
 
+#ifdef PLATFORM_HAS_ADC_STREAM
+// Largest half of the continuous acquisition buffer, in sequences
+#ifndef ADC_STREAM_MAX_FRAMES
+#define ADC_STREAM_MAX_FRAMES     16384
+#endif
+
+// Continuous acquisition: the platform writes the samples of the active
+// sequence (usually with DMA) to a circular buffer made of two halves and
+// calls adc_stream_half_done() every time a half is filled, while the other
+// half is read by the application
+typedef struct
+{
+  u16                 *buf;
+  unsigned            half_len; // number of samples in a half
+  volatile u32        halves; // halves filled since the start of the acquisition
+  u32                 rd_halves; // halves read (or skipped) since the start
+  u32                 lost; // halves lost since the last call to adc_stream_get_lost
+  u8                  active;
+} elua_adc_stream_state;
+#endif
+
 // Channel Management
 #define ACTIVATE_CHANNEL( d, id ) ( d->ch_active |= ( ( u32 )1 << ( id ) ) )
 #define INACTIVATE_CHANNEL( d, id ) ( d->ch_active &= ~( ( u32 )1 << ( id ) ) )
@@ -56,6 +108,20 @@ void adc_flush_smoothing( unsigned id );
 u16 adc_samples_requested( unsigned id );
 u16 adc_samples_available( unsigned id );
 u16 adc_wait_samples( unsigned id, unsigned samples );
+int adc_set_filter( unsigned id, elua_adc_filter *filter );
+elua_adc_filter *adc_alloc_filter( unsigned id, unsigned nstages, const u8 *types, const unsigned *lens );
+int adc_filter_sample( elua_adc_ch_state *s );
+
+#ifdef PLATFORM_HAS_ADC_STREAM
+int adc_stream_start( u32 chmask, unsigned frames );
+void adc_stream_stop( void );
+int adc_stream_is_active( void );
+void adc_stream_half_done( void );
+const u16 *adc_stream_get_half( timer_data_type timeout );
+int adc_stream_release_half( void );
+unsigned adc_stream_get_half_len( void );
+u32 adc_stream_get_lost( void );
+#endif
 
 #endif
 
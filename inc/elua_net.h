@@ -43,11 +43,31 @@ int elua_net_close( int s );
 elua_net_size elua_net_recvbuf( int s, luaL_Buffer *buf, elua_net_size maxsize, s16 readto, unsigned timer_id, timer_data_type to_us );
 elua_net_size elua_net_recv( int s, void *buf, elua_net_size maxsize, s16 readto, unsigned timer_id, timer_data_type to_us );
 elua_net_size elua_net_send( int s, const void* buf, elua_net_size len );
+elua_net_size elua_net_send_buffered( int s, const void* buf, elua_net_size len, unsigned timer_id, timer_data_type to_us );
+s32 elua_net_send_static( int s, const void* buf, u32 len );
 int elua_accept( u16 port, unsigned timer_id, timer_data_type to_us, elua_net_ip* pfrom );
 int elua_net_connect( int s, elua_net_ip addr, u16 port );
 elua_net_ip elua_net_lookup( const char* hostname );
+int elua_net_select( int *rsocks, unsigned *pnr, int *wsocks, unsigned *pnw, unsigned timer_id, timer_data_type to_us );
+u16 elua_net_chksum( const void* buf, u16 len );
+
+// eLua UDP functions
+int elua_net_bind( int s, u16 port );
+elua_net_size elua_net_sendto( int s, const void* buf, elua_net_size len, elua_net_ip addr, u16 port );
+elua_net_size elua_net_recvfrom( int s, void *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us );
+elua_net_size elua_net_recvfrombuf( int s, luaL_Buffer *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us );
 
 int elua_net_get_last_err( int s );
+int elua_net_rxstats( int s, u32 *pqueued, u32 *pbuffered, u32 *pdropped, int reset );
 int elua_net_get_telnet_socket( void );
+void elua_net_telnet_flush( void );
+int elua_net_telnet_stats( u32 *psegments, u32 *pbytes, int reset );
+void elua_net_arpstats( u32 *phits, u32 *pmisses, int reset );
+int elua_net_dnsstats( u32 *phits, u32 *pneg, u32 *pmisses, int reset );
+
+// INT_NET_EVENT interrupt support (the resource number is the socket)
+int elua_net_int_set_status( elua_int_resnum resnum, int status );
+int elua_net_int_get_status( elua_int_resnum resnum );
+int elua_net_int_get_flag( elua_int_resnum resnum, int clear );
 
 #endif
@@ -10,7 +10,6 @@
 enum
 {
   ELUA_UIP_STATE_IDLE = 0,
-  ELUA_UIP_STATE_SEND,
   ELUA_UIP_STATE_RECV,
   ELUA_UIP_STATE_RECV_2,
   ELUA_UIP_STATE_CONNECT,
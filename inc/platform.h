@@ -68,6 +68,21 @@ int platform_pio_has_pin( unsigned port, unsigned pin );
 int platform_pio_get_num_pins( unsigned port );
 pio_type platform_pio_op( unsigned port, pio_type pinmask, int op );
 
+// Waveform step: drive the pins in 'mask' to the corresponding bits of 'value'
+// on port 'port' (a port code, as returned by PLATFORM_IO_ENCODE), then wait
+// 'delay' microseconds. The layout (4 32-bit words) is the same as the layout
+// of 4 consecutive elements of a S32 'array'.
+typedef struct
+{
+  u32 port;
+  pio_type mask;
+  pio_type value;
+  u32 delay;
+} pio_wave_step;
+
+void platform_pio_wave_play( const pio_wave_step *steps, unsigned nsteps );
+unsigned platform_pio_wave_capture( unsigned port, pio_type mask, u32 *pdata, unsigned maxentries, u32 timeout );
+
 // *****************************************************************************
 // Timer subsection
 
@@ -145,6 +160,11 @@ void platform_timer_sys_disable_int(void);
 // Maximum length for any CAN message
 #define PLATFORM_CAN_MAXLEN                   8
 
+// Number of acceptance filters for each CAN interface
+#ifndef PLATFORM_CAN_NUM_FILTERS
+#define PLATFORM_CAN_NUM_FILTERS              8
+#endif
+
 // eLua CAN ID types
 enum
 {
@@ -156,6 +176,11 @@ int platform_can_exists( unsigned id );
 u32 platform_can_setup( unsigned id, u32 clock );
 int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data );
 int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data );
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data );
+int platform_can_set_buffer( unsigned id, unsigned log2size );
+int platform_can_set_filter( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype );
+int platform_can_clear_filter( unsigned id, unsigned idx );
+int platform_s_can_set_filter( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype, int enable );
 
 // *****************************************************************************
 // SPI subsection
@@ -182,6 +207,11 @@ int platform_spi_exists( unsigned id );
 u32 platform_spi_setup( unsigned id, int mode, u32 clock, unsigned cpol, unsigned cpha, unsigned databits );
 spi_data_type platform_spi_send_recv( unsigned id, spi_data_type data );
 void platform_spi_select( unsigned id, int is_select );
+// Block transfer of 'len' bytes. 'txdata' can be NULL (0xFF is sent instead) and
+// 'rxdata' can be NULL (the received data is discarded).
+// Platforms that implement it must define PLATFORM_HAS_SPI_BLOCK, otherwise a
+// generic implementation in src/common.c calls platform_spi_send_recv for each byte
+void platform_spi_send_recv_block( unsigned id, const u8 *txdata, u8 *rxdata, u32 len );
 
 // *****************************************************************************
 // UART subsection
@@ -238,6 +268,9 @@ int platform_s_uart_set_flow_control( unsigned id, int type );
 // The platform PWM functions
 int platform_pwm_exists( unsigned id );
 u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty );
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty );
+int platform_pwm_update( unsigned n, const u8 *ids, const u8 *duties );
+void platform_s_pwm_update( unsigned n, const u8 *ids, const u8 *duties );
 void platform_pwm_start( unsigned id );
 void platform_pwm_stop( unsigned id );
 u32 platform_pwm_set_clock( unsigned id, u32 data );
@@ -272,6 +305,13 @@ int  platform_adc_start_sequence(void);
 void platform_adc_stop( unsigned id );
 u32  platform_adc_set_clock( unsigned id, u32 frequency);
 int  platform_adc_check_timer_id( unsigned id, unsigned timer_id );
+// Continuous acquisition of the active sequence to the circular buffer 'buf' of
+// 'len' samples (two halves, each one an integer number of sequences), at the
+// rate set with platform_adc_set_clock. The platform must call
+// adc_stream_half_done() each time a half is filled. Only available on the
+// platforms that define PLATFORM_HAS_ADC_STREAM
+int  platform_adc_start_stream( u16 *buf, unsigned len );
+void platform_adc_stop_stream(void);
 
 // ADC Common Functions
 int  platform_adc_exists( unsigned id );
@@ -306,6 +346,13 @@ void platform_i2c_send_stop( unsigned id );
 int platform_i2c_send_address( unsigned id, u16 address, int direction );
 int platform_i2c_send_byte( unsigned id, u8 data );
 int platform_i2c_recv_byte( unsigned id, int ack );
+// Combined transaction: START, address (transmitter), 'txlen' bytes from 'txdata',
+// repeated START, address (receiver), 'rxlen' bytes to 'rxdata', STOP. Any of the
+// two parts is skipped if its length is 0. Returns the number of bytes received or
+// -1 if the slave didn't acknowledge its address or the data sent to it.
+// Platforms that implement it must define PLATFORM_HAS_I2C_TRANSFER, otherwise a
+// generic implementation in src/common.c uses the byte level functions above
+int platform_i2c_transfer( unsigned id, u16 address, const u8 *txdata, u32 txlen, u8 *rxdata, u32 rxlen );
 
 // *****************************************************************************
 // Ethernet specific functions
@@ -314,6 +361,15 @@ void platform_eth_send_packet( const void* src, u32 size );
 u32 platform_eth_get_packet_nb( void* buf, u32 maxlen );
 void platform_eth_force_interrupt(void);
 u32 platform_eth_get_elapsed_time(void);
+// Platforms without an Ethernet interrupt define PLATFORM_HAS_ETH_POLL and run
+// elua_uip_mainloop from this function, called while the net functions wait
+void platform_eth_poll(void);
+// Platforms whose Ethernet driver receives the packets in its own (DMA) buffers
+// define PLATFORM_HAS_ETH_RX_BUFFER and lend these buffers to uIP instead of
+// implementing platform_eth_get_packet_nb. The buffer returned by get (NULL if
+// there is no packet) is used until it is released; uIP builds its answer in it.
+void* platform_eth_get_rx_buffer( u32 *psize );
+void platform_eth_release_rx_buffer( void *buf );
 
 // *****************************************************************************
 // Internal flash erase/write functions
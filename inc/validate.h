@@ -73,6 +73,26 @@
   #endif
 #endif
 
+// Same for BUF_ENABLE_CAN and INT_CAN_RX
+#if defined( BUF_ENABLE_CAN )
+  #if !defined( BUILD_C_INT_HANDLERS )
+  #error "Buffering support on CAN needs C interrupt handlers support, define BUILD_C_INT_HANDLERS in your cpu, board headers"
+  #endif
+  #if !defined( INT_CAN_RX )
+  #error "Buffering support on CAN needs support for the INT_CAN_RX interrupt"
+  #endif
+#endif
+
+// Software timers need the INT_TMR_SW interrupt and a system timer
+#if SWTMR_NUM_TIMERS > 0
+  #if !defined( BUILD_INT_HANDLERS ) || !defined( INT_TMR_SW )
+  #error "Software timers need interrupt handlers support and the INT_TMR_SW interrupt"
+  #endif
+  #if !defined( PLATFORM_HAS_SYSTIMER )
+  #error "Software timers need system timer support. Ensure your platform has this implemented and PLATFORM_HAS_SYSTIMER is defined"
+  #endif
+#endif
+
 // Virtual UARTs need buffering and a few specific macros
 #if defined( BUILD_SERMUX )
   #if !defined( BUF_ENABLE_UART )
@@ -84,6 +104,10 @@
   #error "BUILD_MMCFS needs system timer support. Ensure your platform has this implemented and PLATFORM_HAS_SYSTIMER is defined"
 #endif
 
+#if defined( BUILD_ADC ) && defined( PLATFORM_HAS_ADC_STREAM ) && !defined( PLATFORM_HAS_SYSTIMER )
+  #error "Continuous ADC acquisition needs system timer support. Ensure your platform has this implemented and PLATFORM_HAS_SYSTIMER is defined"
+#endif
+
 // CON_BUF_SIZE needs BUF_ENABLE_UART and CON_UART_ID
 #if defined( CON_BUF_SIZE )
   #if !defined( BUF_ENABLE_UART )
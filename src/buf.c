@@ -3,7 +3,7 @@
 #include "platform_conf.h"
 #include <stdio.h>
 
-#if defined( BUF_ENABLE_UART ) || defined( BUF_ENABLE_ADC )
+#if defined( BUF_ENABLE_UART ) || defined( BUF_ENABLE_ADC ) || defined( BUF_ENABLE_CAN )
 #define BUF_ENABLE
 #endif
 
@@ -41,12 +41,19 @@
   static buf_desc buf_desc_adc [ 0 ];
 #endif
 
+#ifdef BUF_ENABLE_CAN
+  static buf_desc buf_desc_can [ NUM_CAN ];
+#else
+  static buf_desc buf_desc_can [ 0 ];
+#endif
+
 // NOTE: the order of descriptors here MUST match the order of the BUF_ID_xx
 // enum in inc/buf.h
 static const buf_desc* buf_desc_array[ BUF_ID_TOTAL ] = 
 {
   buf_desc_uart,
-  buf_desc_adc
+  buf_desc_adc,
+  buf_desc_can
 };
 
 // Helper macros
@@ -95,7 +102,8 @@ int buf_set( unsigned resid, unsigned resnum, u8 logsize, u8 logdsize )
   BUF_GETPTR( resid, resnum );
   
   pbuf->logdsize = logdsize;
-  pbuf->logsize = logsize + logdsize;
+  pbuf->logsize = logsize == BUF_SIZE_NONE ? BUF_SIZE_NONE : logsize + logdsize;
+  pbuf->rptr = pbuf->wptr = pbuf->count = 0;
   
   if( ( pbuf->buf = ( t_buf_data* )realloc( pbuf->buf, BUF_BYTESIZE( pbuf ) ) ) == NULL )
   {
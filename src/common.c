@@ -250,6 +250,59 @@ int platform_pio_get_num_pins( unsigned port )
 #endif
 }
 
+// Waveform engine. Steps are timed from the start of the waveform, so the time
+// spent on the pin operations doesn't accumulate over the steps.
+#if !defined( PLATFORM_HAS_PIO_WAVE ) && defined( PLATFORM_HAS_SYSTIMER ) && ( NUM_PIO > 0 )
+void platform_pio_wave_play( const pio_wave_step *steps, unsigned nsteps )
+{
+  timer_data_type start = platform_timer_read_sys(), target = 0;
+  unsigned port;
+
+  for( ; nsteps > 0; nsteps --, steps ++ )
+  {
+    port = PLATFORM_IO_GET_PORT( steps->port );
+    if( steps->mask & steps->value )
+      platform_pio_op( port, steps->mask & steps->value, PLATFORM_IO_PIN_SET );
+    if( steps->mask & ~steps->value )
+      platform_pio_op( port, steps->mask & ~steps->value, PLATFORM_IO_PIN_CLEAR );
+    target += steps->delay;
+    while( platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, start, platform_timer_read_sys() ) < target );
+  }
+}
+
+// Capture the changes of the pins in 'mask' of 'port' (a port code) for at
+// most 'timeout' microseconds. Each entry is a ( timestamp, value ) pair of
+// words in 'pdata', the first entry is the initial value of the pins at time 0.
+// Returns the number of entries.
+unsigned platform_pio_wave_capture( unsigned port, pio_type mask, u32 *pdata, unsigned maxentries, u32 timeout )
+{
+  timer_data_type start = platform_timer_read_sys(), crttime;
+  pio_type prev, crt;
+  unsigned n;
+
+  if( maxentries == 0 )
+    return 0;
+  port = PLATFORM_IO_GET_PORT( port );
+  prev = platform_pio_op( port, PLATFORM_IO_ALL_PINS, PLATFORM_IO_PORT_GET_VALUE ) & mask;
+  pdata[ 0 ] = 0;
+  pdata[ 1 ] = prev;
+  for( n = 1; n < maxentries; )
+  {
+    crt = platform_pio_op( port, PLATFORM_IO_ALL_PINS, PLATFORM_IO_PORT_GET_VALUE ) & mask;
+    crttime = platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, start, platform_timer_read_sys() );
+    if( crt != prev )
+    {
+      pdata[ 2 * n ] = ( u32 )crttime;
+      pdata[ 2 * n + 1 ] = prev = crt;
+      n ++;
+    }
+    else if( crttime >= timeout )
+      break;
+  }
+  return n;
+}
+#endif // #if !defined( PLATFORM_HAS_PIO_WAVE ) && defined( PLATFORM_HAS_SYSTIMER ) && ( NUM_PIO > 0 )
+
 // ****************************************************************************
 // CAN functions
 
@@ -267,6 +320,21 @@ int platform_spi_exists( unsigned id )
   return id < NUM_SPI;
 }
 
+#if !defined( PLATFORM_HAS_SPI_BLOCK ) && ( NUM_SPI > 0 )
+void platform_spi_send_recv_block( unsigned id, const u8 *txdata, u8 *rxdata, u32 len )
+{
+  spi_data_type data;
+  u32 i;
+
+  for( i = 0; i < len; i ++ )
+  {
+    data = platform_spi_send_recv( id, txdata ? txdata[ i ] : 0xFF );
+    if( rxdata )
+      rxdata[ i ] = ( u8 )data;
+  }
+}
+#endif // #if !defined( PLATFORM_HAS_SPI_BLOCK ) && ( NUM_SPI > 0 )
+
 // ****************************************************************************
 // PWM functions
 
@@ -383,6 +451,41 @@ int platform_i2c_exists( unsigned id )
 #endif
 }
 
+#if !defined( PLATFORM_HAS_I2C_TRANSFER ) && defined( NUM_I2C ) && ( NUM_I2C > 0 )
+int platform_i2c_transfer( unsigned id, u16 address, const u8 *txdata, u32 txlen, u8 *rxdata, u32 rxlen )
+{
+  int res = 0, data;
+  u32 i;
+
+  if( txlen > 0 || rxlen == 0 )
+  {
+    platform_i2c_send_start( id );
+    if( !platform_i2c_send_address( id, address, PLATFORM_I2C_DIRECTION_TRANSMITTER ) )
+      res = -1;
+    for( i = 0; i < txlen && res == 0; i ++ )
+      if( platform_i2c_send_byte( id, txdata[ i ] ) != 1 )
+        res = -1;
+  }
+  if( res == 0 && rxlen > 0 )
+  {
+    platform_i2c_send_start( id );
+    if( !platform_i2c_send_address( id, address, PLATFORM_I2C_DIRECTION_RECEIVER ) )
+      res = -1;
+    else
+    {
+      for( i = 0; i < rxlen; i ++ )
+        if( ( data = platform_i2c_recv_byte( id, i < rxlen - 1 ) ) == -1 )
+          break;
+        else
+          rxdata[ i ] = ( u8 )data;
+      res = ( int )i;
+    }
+  }
+  platform_i2c_send_stop( id );
+  return res;
+}
+#endif // #if !defined( PLATFORM_HAS_I2C_TRANSFER ) && defined( NUM_I2C ) && ( NUM_I2C > 0 )
+
 // ****************************************************************************
 // Interrupt support
 #ifdef BUILD_INT_HANDLERS
@@ -0,0 +1,176 @@
+// Common implementation: CAN functions (RX buffering and acceptance filters)
+
+#include "common.h"
+#include "platform_conf.h"
+#include <string.h>
+
+#if NUM_CAN > 0
+
+// ****************************************************************************
+// CAN functions
+
+// A CAN frame as stored in the RX buffer. Its size must match the element size
+// of the buffer (16 bytes, BUF_DSIZE_U128)
+typedef struct
+{
+  u32 canid;
+  u8 idtype;
+  u8 len;
+  u8 data[ PLATFORM_CAN_MAXLEN ];
+  u8 reserved[ 2 ];
+} cmn_can_frame;
+
+// Acceptance filter: a frame is accepted if its ID type matches the filter's ID
+// type and ( frame_id & mask ) == ( filter_id & mask )
+typedef struct
+{
+  u32 canid;
+  u32 mask;
+  u8 idtype;
+  u8 enabled;
+} cmn_can_filter;
+
+static cmn_can_filter can_filters[ NUM_CAN ][ PLATFORM_CAN_NUM_FILTERS ];
+static u8 can_num_filters[ NUM_CAN ];
+
+// Helper: check a frame against the acceptance filters of the interface
+// All the frames are accepted if no filter is enabled
+static int cmn_can_accept( unsigned id, u32 canid, u8 idtype )
+{
+  const cmn_can_filter *pf = can_filters[ id ];
+  unsigned i;
+
+  if( can_num_filters[ id ] == 0 )
+    return 1;
+  for( i = 0; i < PLATFORM_CAN_NUM_FILTERS; i ++, pf ++ )
+    if( pf->enabled && pf->idtype == idtype && ( ( canid ^ pf->canid ) & pf->mask ) == 0 )
+      return 1;
+  return 0;
+}
+
+// Helper: get the next accepted frame directly from the hardware
+static int cmn_can_recv_filtered( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+{
+  while( platform_s_can_recv( id, canid, idtype, len, data ) == PLATFORM_OK )
+    if( cmn_can_accept( id, *canid, *idtype ) )
+      return PLATFORM_OK;
+  return PLATFORM_UNDERFLOW;
+}
+
+int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+{
+#ifdef BUF_ENABLE_CAN
+  cmn_can_frame frame;
+
+  if( buf_is_enabled( BUF_ID_CAN, id ) )
+  {
+    if( buf_read( BUF_ID_CAN, id, ( t_buf_data* )&frame ) == PLATFORM_UNDERFLOW )
+      return PLATFORM_UNDERFLOW;
+    *canid = frame.canid;
+    *idtype = frame.idtype;
+    *len = frame.len;
+    memcpy( data, frame.data, frame.len );
+    return PLATFORM_OK;
+  }
+#endif // #ifdef BUF_ENABLE_CAN
+  return cmn_can_recv_filtered( id, canid, idtype, len, data );
+}
+
+#ifdef BUF_ENABLE_CAN
+static elua_int_c_handler prev_can_rx_handler;
+
+static void cmn_can_rx_inthandler( elua_int_resnum resnum )
+{
+  cmn_can_frame frame;
+
+  if( resnum < NUM_CAN && buf_is_enabled( BUF_ID_CAN, resnum ) )
+  {
+    // Drain the hardware FIFO, dropping the new frames if the buffer is full
+    while( cmn_can_recv_filtered( resnum, &frame.canid, &frame.idtype, &frame.len, frame.data ) == PLATFORM_OK )
+      if( buf_get_count( BUF_ID_CAN, resnum ) < buf_get_size( BUF_ID_CAN, resnum ) )
+        buf_write( BUF_ID_CAN, resnum, ( t_buf_data* )&frame );
+  }
+
+  // Chain to previous handler
+  if( prev_can_rx_handler != NULL )
+    prev_can_rx_handler( resnum );
+}
+#endif // #ifdef BUF_ENABLE_CAN
+
+int platform_can_set_buffer( unsigned id, unsigned log2size )
+{
+#ifdef BUF_ENABLE_CAN
+  unsigned i;
+
+  if( log2size == 0 )
+  {
+    // Disable the CAN RX interrupt if it was set
+    if( platform_cpu_get_interrupt( INT_CAN_RX, id ) == PLATFORM_CPU_ENABLE )
+      platform_cpu_set_interrupt( INT_CAN_RX, id, PLATFORM_CPU_DISABLE );
+
+    // Disable buffering
+    buf_set( BUF_ID_CAN, id, BUF_SIZE_NONE, BUF_DSIZE_U128 );
+
+    // Restore the previous C handler if no other interface is buffered
+    for( i = 0; i < NUM_CAN; i ++ )
+      if( buf_is_enabled( BUF_ID_CAN, i ) )
+        break;
+    if( i == NUM_CAN && elua_int_get_c_handler( INT_CAN_RX ) == cmn_can_rx_inthandler )
+      (void) elua_int_set_c_handler( INT_CAN_RX, prev_can_rx_handler );
+  }
+  else
+  {
+    // Enable buffering
+    if( buf_set( BUF_ID_CAN, id, log2size, BUF_DSIZE_U128 ) == PLATFORM_ERR )
+      return PLATFORM_ERR;
+    // Setup our C handler
+    if( elua_int_get_c_handler( INT_CAN_RX ) != cmn_can_rx_inthandler )
+      prev_can_rx_handler = elua_int_set_c_handler( INT_CAN_RX, cmn_can_rx_inthandler );
+
+    // Enable CAN RX interrupt
+    if( platform_cpu_set_interrupt( INT_CAN_RX, id, PLATFORM_CPU_ENABLE ) < 0 )
+      return PLATFORM_ERR;
+  }
+  return PLATFORM_OK;
+#else // #ifdef BUF_ENABLE_CAN
+  return PLATFORM_ERR;
+#endif // #ifdef BUF_ENABLE_CAN
+}
+
+// Helper: enable or disable an acceptance filter
+static int cmn_can_filter_op( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype, int enable )
+{
+  cmn_can_filter *pf;
+  int old_status;
+
+  if( idx >= PLATFORM_CAN_NUM_FILTERS )
+    return PLATFORM_ERR;
+#ifdef PLATFORM_HAS_CAN_HW_FILTERS
+  // The hardware filters must mirror the software ones, otherwise frames
+  // accepted by a software filter might never reach it
+  if( platform_s_can_set_filter( id, idx, canid, mask, idtype, enable ) != PLATFORM_OK )
+    return PLATFORM_ERR;
+#endif
+  pf = can_filters[ id ] + idx;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( pf->enabled != enable )
+    can_num_filters[ id ] += enable ? 1 : -1;
+  pf->canid = canid;
+  pf->mask = mask;
+  pf->idtype = idtype;
+  pf->enabled = enable;
+  platform_cpu_set_global_interrupts( old_status );
+  return PLATFORM_OK;
+}
+
+int platform_can_set_filter( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype )
+{
+  return cmn_can_filter_op( id, idx, canid, mask, idtype, 1 );
+}
+
+int platform_can_clear_filter( unsigned id, unsigned idx )
+{
+  return cmn_can_filter_op( id, idx, 0, 0, ELUA_CAN_ID_STD, 0 );
+}
+
+#endif // #if NUM_CAN > 0
@@ -0,0 +1,178 @@
+// Common implementation: PWM functions (synchronous updates and duty sequencer)
+
+#include "common.h"
+#include "platform_conf.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if NUM_PWM > 0
+
+// ****************************************************************************
+// PWM functions
+
+// The frequency given to platform_pwm_setup for each channel (0 if the channel
+// was never set up). Used to reprogram the channels on the platforms that can't
+// change only the duty cycle.
+static u32 pwm_freq[ NUM_PWM ];
+
+u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+{
+  u32 res = platform_s_pwm_setup( id, frequency, duty );
+
+  pwm_freq[ id ] = frequency;
+  return res;
+}
+
+// Helper: check that all the channels were set up
+static int cmn_pwm_check_ids( unsigned n, const u8 *ids )
+{
+  unsigned i;
+
+  for( i = 0; i < n; i ++ )
+    if( ids[ i ] >= NUM_PWM || pwm_freq[ ids[ i ] ] == 0 )
+      return PLATFORM_ERR;
+  return PLATFORM_OK;
+}
+
+// Helper: change the duty cycles, must be called with interrupts disabled
+static void cmn_pwm_apply( unsigned n, const u8 *ids, const u8 *duties )
+{
+#ifdef PLATFORM_HAS_PWM_UPDATE
+  platform_s_pwm_update( n, ids, duties );
+#else
+  unsigned i;
+
+  for( i = 0; i < n; i ++ )
+    platform_s_pwm_setup( ids[ i ], pwm_freq[ ids[ i ] ], duties[ i ] );
+#endif
+}
+
+// Change the duty cycles of 'n' channels at once. If the platform defines
+// PLATFORM_HAS_PWM_UPDATE, all the new duty cycles take effect at the start of
+// the same PWM period. Otherwise the channels are reprogrammed one after the
+// other with interrupts disabled, using the frequency given to platform_pwm_setup.
+int platform_pwm_update( unsigned n, const u8 *ids, const u8 *duties )
+{
+  int old_status;
+  unsigned i;
+
+  if( cmn_pwm_check_ids( n, ids ) != PLATFORM_OK )
+    return PLATFORM_ERR;
+  for( i = 0; i < n; i ++ )
+    if( duties[ i ] > 100 )
+      return PLATFORM_ERR;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  cmn_pwm_apply( n, ids, duties );
+  platform_cpu_set_global_interrupts( old_status );
+  return PLATFORM_OK;
+}
+
+// ****************************************************************************
+// Duty sequencer
+// Steps through a table of duty cycles ('nch' duty cycles for each step) from
+// the match interrupt of a timer, so waveforms can be generated without Lua
+
+#if defined( BUILD_C_INT_HANDLERS ) && defined( INT_TMR_MATCH ) && ( INT_TMR_MATCH != ELUA_INT_INVALID_INTERRUPT )
+
+typedef struct
+{
+  u8 *duties;
+  u8 ids[ NUM_PWM ];
+  unsigned nch;
+  unsigned nsteps;
+  unsigned step;
+  unsigned count;               // remaining repetitions, 0 to repeat forever
+  unsigned timer_id;
+  volatile u8 active;
+} cmn_pwm_seq_state;
+
+static cmn_pwm_seq_state pwm_seq;
+static elua_int_c_handler prev_pwm_tmr_handler;
+
+static void cmn_pwm_seq_inthandler( elua_int_resnum resnum )
+{
+  cmn_pwm_seq_state *ps = &pwm_seq;
+
+  if( ps->active && resnum == ps->timer_id )
+  {
+    if( ++ ps->step == ps->nsteps )
+    {
+      ps->step = 0;
+      // After the last repetition the last duty cycles are kept
+      if( ps->count > 0 && -- ps->count == 0 )
+      {
+        ps->active = 0;
+        platform_cpu_set_interrupt( INT_TMR_MATCH, resnum, PLATFORM_CPU_DISABLE );
+      }
+    }
+    if( ps->active )
+      cmn_pwm_apply( ps->nch, ps->ids, ps->duties + ps->step * ps->nch );
+  }
+
+  // Chain to previous handler
+  if( prev_pwm_tmr_handler != NULL )
+    prev_pwm_tmr_handler( resnum );
+}
+
+// Start playing 'nsteps' steps of 'nch' duty cycles (one for each channel in
+// 'ids'), one step every 'period_us' microseconds of timer 'timer_id'. The
+// sequence is played 'count' times (0 for forever). The duty cycles are copied,
+// the first step is applied right away.
+int cmn_pwm_seq_start( unsigned timer_id, timer_data_type period_us, unsigned nch, const u8 *ids, const u8 *duties, unsigned nsteps, unsigned count )
+{
+  cmn_pwm_seq_state *ps = &pwm_seq;
+  int res;
+
+  cmn_pwm_seq_stop();
+  if( nch == 0 || nch > NUM_PWM || nsteps == 0 || cmn_pwm_check_ids( nch, ids ) != PLATFORM_OK )
+    return CMN_PWM_SEQ_NOT_SETUP;
+  if( ( ps->duties = ( u8* )malloc( nsteps * nch ) ) == NULL )
+    return CMN_PWM_SEQ_NO_MEMORY;
+  memcpy( ps->duties, duties, nsteps * nch );
+  memcpy( ps->ids, ids, nch );
+  ps->nch = nch;
+  ps->nsteps = nsteps;
+  ps->step = 0;
+  ps->count = count;
+  ps->timer_id = timer_id;
+
+  // Setup our C handler
+  if( elua_int_get_c_handler( INT_TMR_MATCH ) != cmn_pwm_seq_inthandler )
+    prev_pwm_tmr_handler = elua_int_set_c_handler( INT_TMR_MATCH, cmn_pwm_seq_inthandler );
+
+  platform_pwm_update( nch, ids, ps->duties );
+  ps->active = 1;
+  if( ( res = platform_timer_set_match_int( timer_id, period_us, PLATFORM_TIMER_INT_CYCLIC ) ) != PLATFORM_TIMER_INT_OK )
+  {
+    cmn_pwm_seq_stop();
+    return res;
+  }
+  platform_cpu_set_interrupt( INT_TMR_MATCH, timer_id, PLATFORM_CPU_ENABLE );
+  return PLATFORM_TIMER_INT_OK;
+}
+
+// Stop the sequencer (if running) and release its timer. The channels keep
+// their current duty cycles.
+void cmn_pwm_seq_stop(void)
+{
+  cmn_pwm_seq_state *ps = &pwm_seq;
+
+  if( ps->duties == NULL )
+    return;
+  ps->active = 0;
+  platform_cpu_set_interrupt( INT_TMR_MATCH, ps->timer_id, PLATFORM_CPU_DISABLE );
+  platform_timer_set_match_int( ps->timer_id, 0, PLATFORM_TIMER_INT_CYCLIC );
+  if( elua_int_get_c_handler( INT_TMR_MATCH ) == cmn_pwm_seq_inthandler )
+    (void) elua_int_set_c_handler( INT_TMR_MATCH, prev_pwm_tmr_handler );
+  free( ps->duties );
+  ps->duties = NULL;
+}
+
+int cmn_pwm_seq_is_active(void)
+{
+  return pwm_seq.active;
+}
+
+#endif // #if defined( BUILD_C_INT_HANDLERS ) && defined( INT_TMR_MATCH ) ...
+
+#endif // #if NUM_PWM > 0
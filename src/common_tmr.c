@@ -59,7 +59,7 @@ void cmn_virtual_timer_cb(void)
     {
       vtmr_int_flag[ i >> 3 ] |= msk;
       if( vtmr_int_enabled[ i >> 3 ] & msk )      
-        elua_int_add( INT_TMR_MATCH, i + VTMR_FIRST_ID );
+        cmn_int_handler( INT_TMR_MATCH, i + VTMR_FIRST_ID );
       if( vtmr_int_periodic_flag[ i >> 3 ] & msk )
         vtmr_counters[ i ] = 0;
       else
@@ -394,6 +394,390 @@ int platform_timer_set_match_int( unsigned id, timer_data_type period_us, int ty
 
 #endif // #ifdef BUILD_INT_HANDLERS
 
+// ****************************************************************************
+// Software timers
+// A hierarchical timer wheel with SWTMR_WHEEL_LEVELS levels of SWTMR_WHEEL_SLOTS
+// slots each, advanced from the system timer. Inserting and removing a timer
+// are O(1); timers that are far in the future are cascaded to the lower levels
+// of the wheel as time passes. Expirations are reported as INT_TMR_SW
+// interrupts, the resource number is the handle of the timer.
+
+#if SWTMR_NUM_TIMERS > 0 && defined( BUILD_INT_HANDLERS ) && defined( INT_TMR_SW )
+#define CMN_SWTMR_SUPPORT
+#endif
+
+#ifdef CMN_SWTMR_SUPPORT
+
+#define SWTMR_WHEEL_BITS      6
+#define SWTMR_WHEEL_SLOTS     ( 1 << SWTMR_WHEEL_BITS )
+#define SWTMR_WHEEL_MASK      ( SWTMR_WHEEL_SLOTS - 1 )
+#define SWTMR_WHEEL_LEVELS    4
+#define SWTMR_MAX_TICKS       ( ( 1UL << ( SWTMR_WHEEL_BITS * SWTMR_WHEEL_LEVELS ) ) - 1 )
+#define SWTMR_NONE            0xFFFF
+#define SWTMR_EXPIRING        0xFF    // 'level' of the timers in swtmr_expiring
+
+// The allocation counter in the handle (see common.h) tells stale handles (and
+// stale interrupts) apart from the current user of the same timer
+#define SWTMR_GEN_MASK        ( 0xFFFF >> SWTMR_ID_BITS )
+#define SWTMR_HANDLE( idx )   ( ( swtmr_timers[ idx ].gen << SWTMR_ID_BITS ) | ( idx ) )
+
+// Timer flags
+#define SWTMR_F_ACTIVE        0x01    // allocated
+#define SWTMR_F_QUEUED        0x02    // in the wheel
+#define SWTMR_F_ENABLED       0x04    // interrupt enabled
+#define SWTMR_F_EXPIRED       0x08    // interrupt flag
+#define SWTMR_F_RETRY         0x10    // the interrupt couldn't be queued
+
+typedef struct
+{
+  u32 expires;
+  u32 period;
+  u16 next, prev;
+  u8 level, slot;
+  u8 gen;
+  u8 flags;
+} swtmr_timer;
+
+static swtmr_timer swtmr_timers[ SWTMR_NUM_TIMERS ];
+static u16 swtmr_wheel[ SWTMR_WHEEL_LEVELS ][ SWTMR_WHEEL_SLOTS ];
+static u16 swtmr_free, swtmr_expiring;
+static u32 swtmr_jiffies, swtmr_crt_tick;
+static timer_data_type swtmr_last_us;
+static u8 swtmr_running, swtmr_initialized;
+
+static void swtmr_init( void )
+{
+  unsigned i, j;
+
+  for( i = 0; i < SWTMR_WHEEL_LEVELS; i ++ )
+    for( j = 0; j < SWTMR_WHEEL_SLOTS; j ++ )
+      swtmr_wheel[ i ][ j ] = SWTMR_NONE;
+  for( i = 0; i < SWTMR_NUM_TIMERS; i ++ )
+    swtmr_timers[ i ].next = i == SWTMR_NUM_TIMERS - 1 ? SWTMR_NONE : i + 1;
+  swtmr_free = 0;
+  swtmr_last_us = platform_timer_read_sys();
+  swtmr_initialized = 1;
+}
+
+// Helper: return the timer index from a handle or -1 if the handle is not valid
+static int swtmr_get_index( unsigned handle )
+{
+  unsigned idx = SWTMR_GET_ID( handle );
+
+  if( idx >= SWTMR_NUM_TIMERS || !( swtmr_timers[ idx ].flags & SWTMR_F_ACTIVE ) )
+    return -1;
+  if( ( handle >> SWTMR_ID_BITS ) != swtmr_timers[ idx ].gen )
+    return -1;
+  return idx;
+}
+
+// Helper: add a timer to the wheel slot that corresponds to tick 'when'
+static void swtmr_insert( unsigned idx, u32 when )
+{
+  swtmr_timer *pt = swtmr_timers + idx;
+  u32 delta = when - swtmr_jiffies;
+  u16 *phead;
+  unsigned level;
+
+  if( ( s32 )delta < 0 )
+  {
+    // Already expired, run on the next processed tick
+    when = swtmr_jiffies;
+    delta = 0;
+  }
+  else if( delta > SWTMR_MAX_TICKS )
+  {
+    // Too far in the future, it will be cascaded again when this slot is reached
+    when = swtmr_jiffies + SWTMR_MAX_TICKS;
+    delta = SWTMR_MAX_TICKS;
+  }
+  for( level = 0; level < SWTMR_WHEEL_LEVELS - 1; level ++ )
+    if( delta < ( 1UL << ( SWTMR_WHEEL_BITS * ( level + 1 ) ) ) )
+      break;
+  pt->level = level;
+  pt->slot = ( when >> ( SWTMR_WHEEL_BITS * level ) ) & SWTMR_WHEEL_MASK;
+  phead = &swtmr_wheel[ level ][ pt->slot ];
+  pt->prev = SWTMR_NONE;
+  pt->next = *phead;
+  if( *phead != SWTMR_NONE )
+    swtmr_timers[ *phead ].prev = idx;
+  *phead = idx;
+  pt->flags |= SWTMR_F_QUEUED;
+}
+
+// Helper: remove a timer from the wheel
+static void swtmr_remove( unsigned idx )
+{
+  swtmr_timer *pt = swtmr_timers + idx;
+
+  if( !( pt->flags & SWTMR_F_QUEUED ) )
+    return;
+  if( pt->next != SWTMR_NONE )
+    swtmr_timers[ pt->next ].prev = pt->prev;
+  if( pt->prev != SWTMR_NONE )
+    swtmr_timers[ pt->prev ].next = pt->next;
+  else if( pt->level == SWTMR_EXPIRING )
+    swtmr_expiring = pt->next;
+  else
+    swtmr_wheel[ pt->level ][ pt->slot ] = pt->next;
+  pt->flags &= ( u8 )~SWTMR_F_QUEUED;
+}
+
+// Helper: move all the timers from a slot to the lower levels
+// Returns the slot index (the upper level must be cascaded too if this is 0)
+static unsigned swtmr_cascade( unsigned level, unsigned slot )
+{
+  u16 idx = swtmr_wheel[ level ][ slot ], next;
+
+  swtmr_wheel[ level ][ slot ] = SWTMR_NONE;
+  while( idx != SWTMR_NONE )
+  {
+    next = swtmr_timers[ idx ].next;
+    swtmr_insert( idx, swtmr_timers[ idx ].expires );
+    idx = next;
+  }
+  return slot;
+}
+
+// Helper: report the expiration of a timer, then rearm or stop it
+static void swtmr_expire( unsigned idx )
+{
+  swtmr_timer *pt = swtmr_timers + idx;
+  elua_int_resnum handle = SWTMR_HANDLE( idx );
+  u32 late;
+
+  if( pt->flags & SWTMR_F_ENABLED )
+  {
+    if( !( pt->flags & SWTMR_F_RETRY ) )
+    {
+#ifdef BUILD_C_INT_HANDLERS
+      elua_int_c_handler phnd = elua_int_get_c_handler( INT_TMR_SW );
+#endif
+
+      pt->flags |= SWTMR_F_EXPIRED;
+#ifdef BUILD_C_INT_HANDLERS
+      if( phnd )
+        phnd( handle );
+#endif
+    }
+#ifdef BUILD_LUA_INT_HANDLERS
+    // If the Lua interrupt queue is full try again on the next tick
+    if( elua_int_is_enabled( INT_TMR_SW ) && ( elua_int_is_full() || elua_int_add( INT_TMR_SW, handle ) != PLATFORM_OK ) )
+    {
+      pt->flags |= SWTMR_F_RETRY;
+      swtmr_insert( idx, swtmr_jiffies );
+      return;
+    }
+#endif
+  }
+  else
+    pt->flags |= SWTMR_F_EXPIRED;
+  pt->flags &= ( u8 )~SWTMR_F_RETRY;
+  if( pt->period )
+  {
+    pt->expires += pt->period;
+    // Skip the periods that were missed while the interrupt couldn't be queued
+    if( ( s32 )( late = swtmr_jiffies - pt->expires ) > 0 )
+      pt->expires += ( late / pt->period + 1 ) * pt->period;
+    swtmr_insert( idx, pt->expires );
+  }
+}
+
+// Helper: number of ticks elapsed since the last processed tick
+static u32 swtmr_pending_ticks( timer_data_type now )
+{
+  return platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, swtmr_last_us, now ) / SWTMR_TICK_US;
+}
+
+// Advance the wheel to the current system time
+// This is called from the system timer interrupt (cmn_systimer_periodic), but
+// platforms without a periodic system timer interrupt can call it directly
+void cmn_swtmr_run( void )
+{
+  timer_data_type now;
+  u64 last;
+  u32 ticks;
+  u16 idx;
+  unsigned slot;
+
+  if( !swtmr_initialized || swtmr_running )
+    return;
+  swtmr_running = 1;
+  now = platform_timer_read_sys();
+  ticks = swtmr_pending_ticks( now );
+  last = ( u64 )swtmr_last_us + ( u64 )ticks * SWTMR_TICK_US;
+  if( last > PLATFORM_TIMER_SYS_MAX )
+    last -= ( u64 )PLATFORM_TIMER_SYS_MAX + 1;
+  swtmr_last_us = ( timer_data_type )last;
+  swtmr_crt_tick += ticks;
+  // Process all the ticks up to (and including) the current one
+  while( ( s32 )( swtmr_crt_tick - swtmr_jiffies ) >= 0 )
+  {
+    slot = swtmr_jiffies & SWTMR_WHEEL_MASK;
+    if( slot == 0 &&
+        swtmr_cascade( 1, ( swtmr_jiffies >> SWTMR_WHEEL_BITS ) & SWTMR_WHEEL_MASK ) == 0 &&
+        swtmr_cascade( 2, ( swtmr_jiffies >> ( 2 * SWTMR_WHEEL_BITS ) ) & SWTMR_WHEEL_MASK ) == 0 )
+      swtmr_cascade( 3, ( swtmr_jiffies >> ( 3 * SWTMR_WHEEL_BITS ) ) & SWTMR_WHEEL_MASK );
+    // Move the slot to the expiring list first, expired timers might be
+    // inserted in it again and C handlers might stop other timers from it
+    swtmr_expiring = swtmr_wheel[ 0 ][ slot ];
+    swtmr_wheel[ 0 ][ slot ] = SWTMR_NONE;
+    for( idx = swtmr_expiring; idx != SWTMR_NONE; idx = swtmr_timers[ idx ].next )
+      swtmr_timers[ idx ].level = SWTMR_EXPIRING;
+    swtmr_jiffies ++;
+    while( ( idx = swtmr_expiring ) != SWTMR_NONE )
+    {
+      swtmr_remove( idx );
+      swtmr_expire( idx );
+    }
+  }
+  swtmr_running = 0;
+}
+
+// Start a software timer that expires after 'delay_us', then every 'period_us'
+// if 'period_us' is not 0. Returns the timer handle or -1 if no timer is available
+int cmn_swtmr_start( timer_data_type delay_us, timer_data_type period_us )
+{
+  swtmr_timer *pt;
+  timer_data_type now;
+  u32 delay, period;
+  int old_status, idx;
+
+  // Round up to whole ticks (without overflowing for the largest delays)
+  delay = delay_us / SWTMR_TICK_US + ( delay_us % SWTMR_TICK_US != 0 );
+  period = period_us / SWTMR_TICK_US + ( period_us % SWTMR_TICK_US != 0 );
+  if( delay == 0 )
+    delay = 1;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( !swtmr_initialized )
+    swtmr_init();
+  if( ( idx = swtmr_free ) == SWTMR_NONE )
+  {
+    platform_cpu_set_global_interrupts( old_status );
+    return -1;
+  }
+  pt = swtmr_timers + idx;
+  swtmr_free = pt->next;
+  if( ( pt->gen = ( pt->gen + 1 ) & SWTMR_GEN_MASK ) == 0 )
+    pt->gen = 1;
+  pt->flags = SWTMR_F_ACTIVE | SWTMR_F_ENABLED;
+  pt->period = period;
+  // The wheel might be behind the system timer (it is advanced only when the
+  // system timer interrupt runs), so count from the current time
+  now = platform_timer_read_sys();
+  pt->expires = swtmr_crt_tick + swtmr_pending_ticks( now ) + delay;
+  swtmr_insert( idx, pt->expires );
+  idx = SWTMR_HANDLE( idx );
+  platform_cpu_set_global_interrupts( old_status );
+  return idx;
+}
+
+// Stop a software timer and release it
+int cmn_swtmr_stop( unsigned handle )
+{
+  int old_status, idx, res = PLATFORM_ERR;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( swtmr_initialized && ( idx = swtmr_get_index( handle ) ) != -1 )
+  {
+    swtmr_remove( idx );
+    swtmr_timers[ idx ].flags = 0;
+    swtmr_timers[ idx ].next = swtmr_free;
+    swtmr_free = idx;
+    res = PLATFORM_OK;
+  }
+  platform_cpu_set_global_interrupts( old_status );
+  return res;
+}
+
+// Returns 1 if the timer is periodic, 0 if it is a one shot timer and -1 if
+// the handle is not valid (anymore)
+int cmn_swtmr_is_periodic( unsigned handle )
+{
+  int idx;
+
+  if( !swtmr_initialized || ( idx = swtmr_get_index( handle ) ) == -1 )
+    return -1;
+  return swtmr_timers[ idx ].period != 0;
+}
+
+#ifdef BUILD_INT_HANDLERS
+int cmn_swtmr_int_set_status( elua_int_resnum resnum, int status )
+{
+  int idx, prev;
+
+  if( !swtmr_initialized || ( idx = swtmr_get_index( resnum ) ) == -1 )
+    return PLATFORM_INT_BAD_RESNUM;
+  prev = ( swtmr_timers[ idx ].flags & SWTMR_F_ENABLED ) != 0;
+  if( status == PLATFORM_CPU_ENABLE )
+    swtmr_timers[ idx ].flags |= SWTMR_F_ENABLED;
+  else
+    swtmr_timers[ idx ].flags &= ( u8 )~SWTMR_F_ENABLED;
+  return prev;
+}
+
+int cmn_swtmr_int_get_status( elua_int_resnum resnum )
+{
+  int idx;
+
+  if( !swtmr_initialized || ( idx = swtmr_get_index( resnum ) ) == -1 )
+    return PLATFORM_INT_BAD_RESNUM;
+  return ( swtmr_timers[ idx ].flags & SWTMR_F_ENABLED ) != 0;
+}
+
+int cmn_swtmr_int_get_flag( elua_int_resnum resnum, int clear )
+{
+  int idx, flag;
+
+  if( !swtmr_initialized || ( idx = swtmr_get_index( resnum ) ) == -1 )
+    return PLATFORM_INT_BAD_RESNUM;
+  flag = ( swtmr_timers[ idx ].flags & SWTMR_F_EXPIRED ) != 0;
+  if( clear )
+    swtmr_timers[ idx ].flags &= ( u8 )~SWTMR_F_EXPIRED;
+  return flag;
+}
+#endif // #ifdef BUILD_INT_HANDLERS
+
+#else // #ifdef CMN_SWTMR_SUPPORT
+
+void cmn_swtmr_run( void )
+{
+}
+
+int cmn_swtmr_start( timer_data_type delay_us, timer_data_type period_us )
+{
+  return -1;
+}
+
+int cmn_swtmr_stop( unsigned handle )
+{
+  return PLATFORM_ERR;
+}
+
+int cmn_swtmr_is_periodic( unsigned handle )
+{
+  return -1;
+}
+
+#ifdef BUILD_INT_HANDLERS
+int cmn_swtmr_int_set_status( elua_int_resnum resnum, int status )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+
+int cmn_swtmr_int_get_status( elua_int_resnum resnum )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+
+int cmn_swtmr_int_get_flag( elua_int_resnum resnum, int clear )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+#endif // #ifdef BUILD_INT_HANDLERS
+
+#endif // #ifdef CMN_SWTMR_SUPPORT
+
 // ****************************************************************************
 // Generic system timer support
 
@@ -419,6 +803,7 @@ void cmn_systimer_set_interrupt_period_us( u32 period )
 void cmn_systimer_periodic(void)
 {
   cmn_systimer_counter += cmn_systimer_us_per_interrupt;
+  cmn_swtmr_run();
 }
 
 timer_data_type cmn_systimer_get(void)
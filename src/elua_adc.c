@@ -29,7 +29,7 @@ void adc_update_dev_sequence( unsigned dev_id  )
 {
   elua_adc_dev_state *d = adc_get_dev_state( dev_id );
   elua_adc_ch_state *s;
-  unsigned previd = d->ch_state[ d->seq_ctr ]->id;
+  unsigned previd = d->ch_state[ d->seq_ctr ] ? d->ch_state[ d->seq_ctr ]->id : NUM_ADC;
   unsigned id;
   u8 tmp_seq_ctr = 0;
   int old_status;  
@@ -268,6 +268,143 @@ u16 adc_get_processed_sample( unsigned id )
   return sample;
 }
 
+// Allocate a filter for channel 'id' with 'nstages' stages of the given types
+// and lengths (number of FIR taps or decimation factor, ignored for IIR stages).
+// The coefficients are zero and must be filled in before calling adc_set_filter
+elua_adc_filter *adc_alloc_filter( unsigned id, unsigned nstages, const u8 *types, const unsigned *lens )
+{
+  elua_adc_filter *f;
+  elua_adc_filter_stage *ps;
+  unsigned i, ncoefs = 0, nstate = 0;
+  s32 *pstate;
+  s16 *pcoefs;
+
+  if( nstages == 0 )
+    return NULL;
+  for( i = 0; i < nstages; i ++ )
+    if( types[ i ] == ADC_FILTER_FIR )
+    {
+      ncoefs += lens[ i ];
+      nstate += lens[ i ];
+    }
+    else if( types[ i ] == ADC_FILTER_IIR )
+    {
+      ncoefs += ADC_FILTER_IIR_NUM_COEFS;
+      nstate += 4;
+    }
+  // The stages, the state and the coefficients are allocated in a single block
+  i = sizeof( elua_adc_filter ) + ( nstages - 1 ) * sizeof( elua_adc_filter_stage );
+  if( ( f = ( elua_adc_filter* )calloc( 1, i + nstate * sizeof( s32 ) + ncoefs * sizeof( s16 ) ) ) == NULL )
+    return NULL;
+  pstate = ( s32* )( ( char* )f + i );
+  pcoefs = ( s16* )( pstate + nstate );
+  f->maxval = ( u16 )platform_adc_get_maxval( id );
+  f->nstages = nstages;
+  for( i = 0, ps = f->stages; i < nstages; i ++, ps ++ )
+  {
+    ps->type = types[ i ];
+    ps->len = lens[ i ];
+    if( ps->type == ADC_FILTER_FIR )
+    {
+      ps->coefs = pcoefs;
+      ps->state = pstate;
+      pcoefs += ps->len;
+      pstate += ps->len;
+    }
+    else if( ps->type == ADC_FILTER_IIR )
+    {
+      ps->coefs = pcoefs;
+      ps->state = pstate;
+      pcoefs += ADC_FILTER_IIR_NUM_COEFS;
+      pstate += 4;
+    }
+  }
+  return f;
+}
+
+// Set the filter of a channel (NULL to remove it). The old filter is freed.
+// If operations are pending, stop them. Buffered samples are discarded.
+int adc_set_filter( unsigned id, elua_adc_filter *filter )
+{
+  elua_adc_ch_state *s = adc_get_ch_state( id );
+  elua_adc_filter *old;
+  int old_status;
+
+  if ( s->op_pending == 1 )
+    platform_adc_stop( id );
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  old = s->filter;
+  s->filter = filter;
+  platform_cpu_set_global_interrupts( old_status );
+  free( old );
+
+  adc_flush_smoothing( id );
+#if defined( BUF_ENABLE_ADC )
+  buf_flush( BUF_ID_ADC, id );
+#endif
+
+  return PLATFORM_OK;
+}
+
+// Run a new sample (in s->value_ptr) through the filter stages of the channel,
+// called by the platform as samples arrive. The output replaces the sample.
+// Returns 1 if the filter produced an output, 0 if the sample was dropped by
+// a decimation stage.
+int adc_filter_sample( elua_adc_ch_state *s )
+{
+  elua_adc_filter *f = s->filter;
+  elua_adc_filter_stage *ps = f->stages;
+  s32 x = *( s->value_ptr ), *st;
+  const s16 *c;
+  s64 acc;
+  unsigned i, k, pos;
+
+  for( i = 0; i < f->nstages; i ++, ps ++ )
+  {
+    switch( ps->type )
+    {
+      case ADC_FILTER_FIR:
+        pos = ps->pos;
+        ps->state[ pos ] = x;
+        if( ++ ps->pos == ps->len )
+          ps->pos = 0;
+        // Don't compute an output that the next stage drops anyway
+        if( i + 1 < f->nstages && ps[ 1 ].type == ADC_FILTER_DECIMATE && ps[ 1 ].pos + 1 < ps[ 1 ].len )
+          break;
+        // The first coefficient applies to the newest sample
+        acc = 0;
+        c = ps->coefs;
+        st = ps->state;
+        for( k = pos + 1; k > 0; k -- )
+          acc += ( s64 )*c ++ * st[ k - 1 ];
+        for( k = ps->len; k > pos + 1; k -- )
+          acc += ( s64 )*c ++ * st[ k - 1 ];
+        x = ( s32 )( acc >> 15 );
+        break;
+
+      case ADC_FILTER_IIR:
+        // Direct form I biquad, state is x[n-1], x[n-2], y[n-1], y[n-2]
+        c = ps->coefs;
+        st = ps->state;
+        acc = ( s64 )c[ 0 ] * x + ( s64 )c[ 1 ] * st[ 0 ] + ( s64 )c[ 2 ] * st[ 1 ] - ( s64 )c[ 3 ] * st[ 2 ] - ( s64 )c[ 4 ] * st[ 3 ];
+        st[ 1 ] = st[ 0 ];
+        st[ 0 ] = x;
+        x = ( s32 )( acc >> 14 );
+        st[ 3 ] = st[ 2 ];
+        st[ 2 ] = x;
+        break;
+
+      case ADC_FILTER_DECIMATE:
+        if( ++ ps->pos < ps->len )
+          return 0;
+        ps->pos = 0;
+        break;
+    }
+  }
+  *( s->value_ptr ) = ( u16 )( x < 0 ? 0 : x > f->maxval ? f->maxval : x );
+  return 1;
+}
+
 // Zero out and reset smoothing buffer
 void adc_flush_smoothing( unsigned id )
 {
@@ -315,5 +452,125 @@ u16 adc_wait_samples( unsigned id, unsigned samples )
   return adc_samples_available( id );
 }
 
+#ifdef PLATFORM_HAS_ADC_STREAM
+// ****************************************************************************
+// Continuous acquisition
+
+static elua_adc_stream_state adc_stream_state;
+
+// Start the continuous acquisition of the channels in 'chmask' to a buffer of
+// two halves of 'frames' sequences each
+int adc_stream_start( u32 chmask, unsigned frames )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+  elua_adc_stream_state *st = &adc_stream_state;
+  unsigned id, nchans = 0;
+  u16 *buf;
+
+  if( d->running || st->active || chmask == 0 || frames == 0 || frames > ADC_STREAM_MAX_FRAMES )
+    return PLATFORM_ERR;
+  for( id = 0; id < NUM_ADC; id ++ )
+    if( chmask & ( ( u32 )1 << id ) )
+      nchans ++;
+  if( nchans == 0 || frames > ( ( size_t )-1 / ( 2 * sizeof( u16 ) ) ) / nchans )
+    return PLATFORM_ERR;
+  if( ( buf = ( u16* )realloc( st->buf, 2 * frames * nchans * sizeof( u16 ) ) ) == NULL )
+    return PLATFORM_ERR;
+  st->buf = buf;
+  st->half_len = frames * nchans;
+  st->halves = st->rd_halves = st->lost = 0;
+
+  // The samples are interleaved in the order of the sequence (channel ID)
+  d->ch_active = chmask;
+  adc_update_dev_sequence( 0 );
+  st->active = 1;
+  if( platform_adc_start_stream( buf, 2 * st->half_len ) != PLATFORM_OK )
+  {
+    adc_stream_stop();
+    return PLATFORM_ERR;
+  }
+  return PLATFORM_OK;
+}
+
+void adc_stream_stop( void )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+  elua_adc_stream_state *st = &adc_stream_state;
+
+  if( st->active )
+    platform_adc_stop_stream();
+  st->active = 0;
+  d->ch_active = 0;
+  free( st->buf );
+  st->buf = NULL;
+}
+
+int adc_stream_is_active( void )
+{
+  return adc_stream_state.active;
+}
+
+// Called by the platform (usually from an interrupt handler) when a half of
+// the buffer was filled
+void adc_stream_half_done( void )
+{
+  adc_stream_state.halves ++;
+}
+
+// Return the oldest filled half that wasn't read yet, waiting at most 'timeout'
+// us for it (NULL if there is none). The platform is already writing the other
+// half, so only the last filled half is still intact, older ones are skipped.
+// The half must be released with adc_stream_release_half after it was used.
+const u16 *adc_stream_get_half( timer_data_type timeout )
+{
+  elua_adc_stream_state *st = &adc_stream_state;
+  timer_data_type start = platform_timer_read_sys(), elapsed;
+  u32 halves;
+
+  while( ( halves = st->halves ) == st->rd_halves )
+  {
+    elapsed = platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, start, platform_timer_read_sys() );
+    if( !st->active || ( timeout != PLATFORM_TIMER_INF_TIMEOUT && elapsed >= timeout ) )
+      return NULL;
+  }
+  if( halves - st->rd_halves > 1 )
+  {
+    st->lost += halves - st->rd_halves - 1;
+    st->rd_halves = halves - 1;
+  }
+  return st->buf + ( st->rd_halves & 1 ) * st->half_len;
+}
+
+// Release the half returned by adc_stream_get_half. Returns PLATFORM_ERR if
+// the platform started to overwrite it in the meantime (the data is corrupted)
+int adc_stream_release_half( void )
+{
+  elua_adc_stream_state *st = &adc_stream_state;
+  int res = PLATFORM_OK;
+
+  if( st->halves - st->rd_halves > 1 )
+  {
+    st->lost ++;
+    res = PLATFORM_ERR;
+  }
+  st->rd_halves ++;
+  return res;
+}
+
+unsigned adc_stream_get_half_len( void )
+{
+  return adc_stream_state.half_len;
+}
+
+// Return (and reset) the number of halves lost because they weren't read in time
+u32 adc_stream_get_lost( void )
+{
+  u32 lost = adc_stream_state.lost;
+
+  adc_stream_state.lost = 0;
+  return lost;
+}
+#endif // #ifdef PLATFORM_HAS_ADC_STREAM
+
 #endif
 
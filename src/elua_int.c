@@ -87,6 +87,18 @@ int elua_int_add( elua_int_id inttype, elua_int_resnum resnum )
   return PLATFORM_OK;
 }
 
+// Returns 1 if there is no more room in the interrupt queue, 0 otherwise
+int elua_int_is_full()
+{
+  return elua_int_queue[ elua_int_write_idx ].id != ELUA_INT_EMPTY_SLOT;
+}
+
+// Returns 1 if there are no interrupts waiting in the queue, 0 otherwise
+int elua_int_is_empty()
+{
+  return elua_int_queue[ elua_int_read_idx ].id == ELUA_INT_EMPTY_SLOT;
+}
+
 // Enable the given interrupt
 void elua_int_enable( elua_int_id inttype )
 {
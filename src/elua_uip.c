@@ -13,11 +13,24 @@
 #include "uip-split.h"
 #include "dhcpc.h"
 #include "resolv.h"
+#include "common.h"
 #include <string.h>
+#include <stdlib.h>
 
 // UIP send buffer
 extern void* uip_sappdata;
 
+// Platforms without an Ethernet interrupt run the uIP main loop while the net
+// functions below wait for it
+#ifdef PLATFORM_HAS_ETH_POLL
+#define elua_uip_poll()         platform_eth_poll()
+#else
+#define elua_uip_poll()
+#endif
+
+// Waits with a timeout use a timer only if the timeout is finite
+#define ELUA_UIP_HAS_TIMEOUT( to_us )   ( ( to_us ) > 0 && ( to_us ) != PLATFORM_TIMER_INF_TIMEOUT )
+
 // Global "configured" flag
 static volatile u8 elua_uip_configured;
 
@@ -26,13 +39,25 @@ static volatile u8 elua_uip_configured;
 
 // Timers
 static u32 periodic_timer, arp_timer;
+#ifdef BUILD_CON_TCP
+// How long the console output waits in the send ring of the telnet socket (ms)
+static volatile u32 telnet_timer;
+#endif
+#ifdef BUILD_DNS
+static u32 dns_timer;
+#endif
 
 // Macro for accessing the Ethernet header information in the buffer.
 #define BUF                     ((struct uip_eth_hdr *)&uip_buf[0])
 
+#if UIP_UDP
+static void elua_uip_udp_sent( int udpno );
+#endif
+
 // UIP Timers (in ms)
 #define UIP_PERIODIC_TIMER_MS   500
 #define UIP_ARP_TIMER_MS        10000
+#define UIP_DNS_TIMER_MS        1000
 
 #define IP_TCP_HEADER_LENGTH 40
 #define TOTAL_HEADER_LENGTH (IP_TCP_HEADER_LENGTH+UIP_LLH_LEN)
@@ -42,6 +67,38 @@ static void device_driver_send()
   platform_eth_send_packet( uip_buf, uip_len );
 }
 
+// The driver lends its receive buffer to uIP, which points uip_buf to it (see
+// UIP_CONF_EXTERNAL_BUFFER), so the packet is not copied to uIP's buffer and the
+// payload is copied only once, to the socket
+#if defined( PLATFORM_HAS_ETH_RX_BUFFER ) && !UIP_EXTERNAL_BUFFER
+#error "PLATFORM_HAS_ETH_RX_BUFFER requires UIP_CONF_EXTERNAL_BUFFER in uip-conf.h"
+#endif
+
+// Get the next received packet in uip_buf, returns its size (0 if none)
+static u32 device_driver_get_packet()
+{
+#ifdef PLATFORM_HAS_ETH_RX_BUFFER
+  u32 size;
+  u8 *buf = ( u8* )platform_eth_get_rx_buffer( &size );
+
+  if( buf == NULL )
+    return 0;
+  uip_buf = buf;
+  return size;
+#else
+  return platform_eth_get_packet_nb( uip_buf, UIP_BUFSIZE + 2 );
+#endif
+}
+
+// Done with the received packet (and the answer to it)
+static void device_driver_release_packet()
+{
+#ifdef PLATFORM_HAS_ETH_RX_BUFFER
+  platform_eth_release_rx_buffer( uip_buf );
+  uip_buf = uip_bufmem;
+#endif
+}
+
 // This gets called on both Ethernet RX interrupts and timer requests,
 // but it's called only from the Ethernet interrupt handler
 void elua_uip_mainloop()
@@ -52,9 +109,15 @@ void elua_uip_mainloop()
   temp = platform_eth_get_elapsed_time();
   periodic_timer += temp;
   arp_timer += temp;  
+#ifdef BUILD_CON_TCP
+  telnet_timer += temp;
+#endif
+#ifdef BUILD_DNS
+  dns_timer += temp;
+#endif
 
   // Check for an RX packet and read it
-  if( ( packet_len = platform_eth_get_packet_nb( uip_buf, sizeof( uip_buf ) ) ) > 0 )
+  if( ( packet_len = device_driver_get_packet() ) > 0 )
   {
     // Set uip_len for uIP stack usage.
     uip_len = ( unsigned short )packet_len;
@@ -86,6 +149,7 @@ void elua_uip_mainloop()
       if( uip_len > 0 )
         device_driver_send();
     }
+    device_driver_release_packet();
   }
   
   // Process TCP/IP Periodic Timer here.
@@ -124,6 +188,7 @@ void elua_uip_mainloop()
         uip_arp_out();
         device_driver_send();
       }
+      elua_uip_udp_sent( temp );
     }
 #endif // UIP_UDP
   
@@ -133,6 +198,15 @@ void elua_uip_mainloop()
     arp_timer = 0;
     uip_arp_timer();
   }  
+
+#ifdef BUILD_DNS
+  // Expiration of the cached names
+  while( dns_timer >= UIP_DNS_TIMER_MS )
+  {
+    dns_timer -= UIP_DNS_TIMER_MS;
+    resolv_tick();
+  }
+#endif
 }
 
 // *****************************************************************************
@@ -162,6 +236,9 @@ void dhcpc_configured(const struct dhcpc_state *s)
 #ifdef BUILD_DNS
 volatile static int elua_resolv_req_done;
 static elua_net_ip elua_resolv_ip;
+// Lookups answered by the cache (with an address or as a name that doesn't
+// exist) and lookups that sent a query
+static u32 elua_resolv_hits, elua_resolv_neg_hits, elua_resolv_misses;
 
 void resolv_found( char *name, u16_t *ipaddr )
 {
@@ -189,9 +266,23 @@ void resolv_found( char *name, u16_t *ipaddr )
 #define TELNET_SE_CHAR         240
 #define TELNET_EOF             236
 
+// The console output is coalesced in the send ring of the telnet socket: full
+// segments are sent right away, a partial segment only when nothing is in
+// transit and the output was flushed (io.flush, or the console waits for
+// input) or waited for ELUA_NET_TELNET_DELAY_MS
+#ifndef ELUA_NET_TELNET_DELAY_MS
+#define ELUA_NET_TELNET_DELAY_MS      50
+#endif
+
 // The telnet socket number
 static int elua_uip_telnet_socket = -1;
 
+// Send the console output without waiting for more
+static volatile u8 elua_uip_telnet_flush;
+
+// Segments and bytes of console output sent on the telnet connection
+static volatile u32 elua_uip_telnet_segments, elua_uip_telnet_bytes;
+
 // Utility function for TELNET: parse input buffer, skipping over
 // TELNET specific sequences
 // Returns the length of the buffer after processing
@@ -231,41 +322,500 @@ static void elua_uip_telnet_handle_input( volatile struct elua_uip_state* s )
   }
 }
 
-// Utility function for TELNET: prepend all '\n' with '\r' in buffer
-// Returns actual len
-// It is assumed that the buffer is "sufficiently smaller" than the UIP
-// buffer (which is true for the default configuration: 128 bytes buffer
-// in Newlib for stdin/stdout, more than 1024 bytes UIP buffer)
-static elua_net_size elua_uip_telnet_prep_send( const char* src, elua_net_size size )
+// Utility function for TELNET: copy data to 'dest' (at most 'maxsize' bytes),
+// prepending all '\n' with '\r'
+// Returns the number of bytes used from 'src', '*pactsize' gets the number of
+// bytes written to 'dest'
+static elua_net_size elua_uip_telnet_prep_send( const char* src, elua_net_size size, char *dest, u16 maxsize, u16 *pactsize )
 {
-  elua_net_size actsize = size, i;
-  char* dest = ( char* )uip_sappdata;
-    
-  for( i = 0; i < size; i ++ )
+  elua_net_size i;
+  u16 actsize = 0;
+
+  for( i = 0; i < size && actsize < maxsize; i ++ )
   {
-    if( *src == '\n' )
+    if( src[ i ] == '\n' )
     {
-      *dest ++ = '\r';
-      actsize ++;
-    } 
-    *dest ++ = *src ++;
+      if( actsize + 2 > maxsize )
+        break;
+      dest[ actsize ++ ] = '\r';
+    }
+    dest[ actsize ++ ] = src[ i ];
   }
-  return actsize;
+  *pactsize = actsize;
+  return i;
 }
 
 #endif // #ifdef BUILD_CON_TCP
 
 // *****************************************************************************
-// eLua UIP application (used to implement the eLua TCP/IP services)
+// Socket buffers
+
+#if !UIP_TCP_RCV_WND
+#error "The eLua sockets need UIP_CONF_TCP_RCV_WND in uip-conf.h"
+#endif
+
+// Socket flags
+#define ELUA_UIP_F_BUFFERED     1     // the socket receives in its ring (all the sockets except telnet)
+#define ELUA_UIP_F_PENDING      2     // incoming connection not accepted yet
+#define ELUA_UIP_F_RESTART      4     // receive ring just attached, start the data flow
+
+// Size of the receive ring of a socket (ELUA_NET_RX_BUF_SIZE can be set in the
+// board configuration, 'rx_buf_size' of the 'tcpip' component). The window
+// advertised to the remote host is the free room in the ring, so it can send
+// several segments while the script doesn't read.
+#ifndef ELUA_NET_RX_BUF_SIZE
+#define ELUA_NET_RX_BUF_SIZE    UIP_RECEIVE_WINDOW
+#endif
+#define ELUA_UIP_RX_BUF_SIZE    ELUA_NET_RX_BUF_SIZE
+#if ELUA_UIP_RX_BUF_SIZE < UIP_RECEIVE_WINDOW || ELUA_UIP_RX_BUF_SIZE > 0xFFFF
+#error "ELUA_NET_RX_BUF_SIZE must be between UIP_RECEIVE_WINDOW and 65535"
+#endif
+
+// The window is enlarged only when the ring has room for a full segment (or
+// is half empty), to avoid receiving many small segments (RFC 1122 4.2.3.3)
+#define ELUA_UIP_RX_WND_STEP    UMIN( ELUA_UIP_RX_BUF_SIZE / 2, UIP_TCP_MSS )
+
+// Size of the send ring of a socket, which keeps the data until the remote host
+// acknowledges it. It limits the data in transit (see UIP_CONF_TCP_SND_WND).
+#ifndef ELUA_NET_TX_BUF_SIZE
+#if UIP_TCP_SND_WND
+#define ELUA_NET_TX_BUF_SIZE    UIP_TCP_SND_WND
+#else
+#define ELUA_NET_TX_BUF_SIZE    UIP_TCP_MSS
+#endif
+#endif
+#define ELUA_UIP_TX_BUF_SIZE    ELUA_NET_TX_BUF_SIZE
+
+// Buffered state of a socket. The receive ring is allocated when the socket is
+// created or accepted, the send ring the first time the socket sends data; both
+// are released by elua_net_close.
+typedef struct
+{
+  u8 *buf;                      // receive ring
+  u8 *txbuf;                    // send ring
+  const u8 *txext;              // data sent by elua_net_send_static instead of the send ring
+  volatile u16 rxstart, rxlen;  // first byte not read yet, bytes in the ring
+  volatile u16 txstart, txlen;  // first byte not acknowledged yet, bytes in the ring
+  volatile u32 rxbuffered;      // bytes received in the ring
+  volatile u32 rxdropped;       // bytes dropped because the ring was full (sent again by the remote host)
+  volatile u8 flags;
+  volatile u8 err;              // why the connection was closed
+} elua_uip_async_state;
+
+static elua_uip_async_state elua_uip_async[ UIP_CONNS ];
+
+// A receive ring kept ready by elua_accept for the next incoming connection, so
+// it can receive data before it is accepted
+static u8 *elua_uip_rx_spare;
+
+// The UDP sockets are numbered after the TCP sockets
+#if UIP_UDP
+#define ELUA_UIP_NUM_SOCKS      ( UIP_CONNS + UIP_UDP_CONNS )
+#else
+#define ELUA_UIP_NUM_SOCKS      UIP_CONNS
+#endif
+
+#if defined( BUILD_INT_HANDLERS ) && defined( INT_NET_EVENT )
+static volatile u8 elua_uip_int_enabled[ ( ELUA_UIP_NUM_SOCKS + 7 ) >> 3 ];
+static volatile u8 elua_uip_int_flag[ ( ELUA_UIP_NUM_SOCKS + 7 ) >> 3 ];
+#endif
+
+// Signal an event on a socket (new connection, data received, send finished or
+// connection closed) with the INT_NET_EVENT interrupt
+static void elua_uip_event( int sockno )
+{
+#if defined( BUILD_INT_HANDLERS ) && defined( INT_NET_EVENT )
+  u8 msk = 1 << ( sockno & 0x07 );
+
+  elua_uip_int_flag[ sockno >> 3 ] |= msk;
+  if( elua_uip_int_enabled[ sockno >> 3 ] & msk )
+    cmn_int_handler( INT_NET_EVENT, sockno );
+#endif
+}
+
+// Reset the buffered state of a socket (its buffers are kept)
+static void elua_uip_async_reset( int sockno, u8 flags )
+{
+  elua_uip_async_state *pa = elua_uip_async + sockno;
+
+  pa->rxstart = pa->rxlen = 0;
+  pa->txstart = pa->txlen = 0;
+  pa->txext = NULL;
+  pa->rxbuffered = pa->rxdropped = 0;
+  pa->flags = flags;
+  pa->err = ELUA_NET_ERR_OK;
+}
+
+// Make sure that a socket has a receive ring (allocating it if needed) and that
+// it receives in it. The send ring is allocated too if 'with_tx' is not 0.
+static elua_uip_async_state* elua_uip_async_enable( int sockno, int with_tx )
+{
+  elua_uip_async_state *pa = elua_uip_async + sockno;
+  int old_status;
+
+  if( with_tx && pa->txbuf == NULL && ( pa->txbuf = ( u8* )malloc( ELUA_UIP_TX_BUF_SIZE ) ) == NULL )
+    return NULL;
+  if( pa->flags & ELUA_UIP_F_BUFFERED )
+    return pa;
+  if( pa->buf == NULL && ( pa->buf = ( u8* )malloc( ELUA_UIP_RX_BUF_SIZE ) ) == NULL )
+    return NULL;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  pa->rxstart = pa->rxlen = 0;
+  pa->flags |= ELUA_UIP_F_BUFFERED | ELUA_UIP_F_RESTART;
+  platform_cpu_set_global_interrupts( old_status );
+  platform_eth_force_interrupt();
+  return pa;
+}
+
+// Release the buffers of a socket
+static void elua_uip_async_free( int sockno )
+{
+  elua_uip_async_state *pa = elua_uip_async + sockno;
+  int old_status;
+  u8 *buf, *txbuf;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  buf = pa->buf;
+  txbuf = pa->txbuf;
+  pa->buf = pa->txbuf = NULL;
+  elua_uip_async_reset( sockno, pa->flags & ELUA_UIP_F_PENDING );
+  platform_cpu_set_global_interrupts( old_status );
+  free( buf );
+  free( txbuf );
+}
+
+// Send 'len' bytes from the send ring (or from the data of elua_net_send_static),
+// starting 'offset' bytes after the first byte that was not acknowledged yet
+static void elua_uip_tx_send( elua_uip_async_state *pa, u16 offset, u16 len )
+{
+  u16 pos = ( pa->txstart + offset ) % ELUA_UIP_TX_BUF_SIZE;
+  u16 first = UMIN( len, ELUA_UIP_TX_BUF_SIZE - pos );
+
+  if( pa->txext )
+  {
+    uip_send( pa->txext + pa->txstart + offset, len );
+    return;
+  }
+  memcpy( uip_sappdata, pa->txbuf + pos, first );
+  memcpy( ( u8* )uip_sappdata + first, pa->txbuf, len - first );
+  uip_send( uip_sappdata, len );
+}
+
+// Copy data to the send ring of a socket, returns the number of bytes copied
+static u16 elua_uip_tx_put( elua_uip_async_state *pa, const u8 *data, u16 len )
+{
+  u16 pos, first, txlen;
+  int old_status;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  txlen = pa->txlen;
+  pos = ( pa->txstart + txlen ) % ELUA_UIP_TX_BUF_SIZE;
+  platform_cpu_set_global_interrupts( old_status );
+  // The ring can only get more room while copying
+  len = UMIN( len, ELUA_UIP_TX_BUF_SIZE - txlen );
+  first = UMIN( len, ELUA_UIP_TX_BUF_SIZE - pos );
+  memcpy( pa->txbuf + pos, data, first );
+  memcpy( pa->txbuf, data + first, len - first );
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  pa->txlen += len;
+  platform_cpu_set_global_interrupts( old_status );
+  return len;
+}
+
+// Copy the received data to the receive ring of a socket (called by uIP, so the
+// data always fits: the window is never larger than the room in the ring)
+static void elua_uip_rx_put( elua_uip_async_state *pa, const u8 *data, u16 len )
+{
+  u16 pos = ( pa->rxstart + pa->rxlen ) % ELUA_UIP_RX_BUF_SIZE;
+  u16 first = UMIN( len, ELUA_UIP_RX_BUF_SIZE - pos );
+
+  memcpy( pa->buf + pos, data, first );
+  memcpy( pa->buf, data + first, len - first );
+  pa->rxlen += len;
+  pa->rxbuffered += len;
+}
+
+// The uIP application for the sockets that use their buffers. Received data goes
+// to the receive ring of the socket, and the window advertised to the remote host
+// is the room left in the ring. Data is sent from the send ring, which can have
+// several segments in transit (see UIP_CONF_TCP_SND_WND); the acknowledged data
+// leaves the ring and a retransmission starts again from the first byte in the ring.
+static void elua_uip_async_appcall( volatile struct elua_uip_state *s, elua_uip_async_state *pa, int sockno )
+{
+  elua_net_size temp;
+  u16 unacked, room;
+  int event = 0;
+
+  if( uip_acked() && pa->txlen > 0 )
+  {
+    temp = UMIN( uip_ackedlen(), pa->txlen );
+    pa->txstart = pa->txext ? pa->txstart + temp : ( pa->txstart + temp ) % ELUA_UIP_TX_BUF_SIZE;
+    pa->txlen -= temp;
+    event = 1;
+  }
+
+  if( uip_newdata() )
+  {
+    pa->rxdropped += uip_rcvdropped();
+    if( uip_datalen() > 0 )
+    {
+      elua_uip_rx_put( pa, ( const u8* )uip_appdata, uip_datalen() );
+      uip_setrcvwnd( uip_rcvwnd() - uip_datalen() );
+      event = 1;
+    }
+  }
+
+  if( uip_aborted() || uip_timedout() || uip_closed() )
+  {
+    s->res = pa->err = uip_aborted() ? ELUA_NET_ERR_ABORTED : ( uip_timedout() ? ELUA_NET_ERR_TIMEDOUT : ELUA_NET_ERR_CLOSED );
+    s->state = ELUA_UIP_STATE_IDLE;
+    elua_uip_event( sockno );
+    return;
+  }
+
+  if( s->state == ELUA_UIP_STATE_CLOSE )
+  {
+    uip_close();
+    s->state = ELUA_UIP_STATE_IDLE;
+    return;
+  }
+
+  // Handle data send
+  unacked = uip_unacked();
+#if UIP_TCP_SND_WND
+  if( uip_rexmit() )
+#else
+  // Without UIP_TCP_SND_WND uIP doesn't know when the remote host accepts data
+  // again after closing its window, so the segment is sent again on each poll
+  if( unacked > 0 && ( uip_rexmit() || uip_poll() ) )
+#endif
+  {
+    if( unacked > 0 )
+      elua_uip_tx_send( pa, 0, UMIN( unacked, uip_mss() ) );
+  }
+  else if( pa->txlen > unacked && unacked < uip_sndwnd() )
+    elua_uip_tx_send( pa, unacked, UMIN( UMIN( pa->txlen - unacked, uip_mss() ), uip_sndwnd() - unacked ) );
+
+  // Advertise the room in the receive ring when it is large enough (or right
+  // away if the ring was just attached to the socket)
+  room = ELUA_UIP_RX_BUF_SIZE - pa->rxlen;
+  if( ( pa->flags & ELUA_UIP_F_RESTART ) || room >= uip_rcvwnd() + ELUA_UIP_RX_WND_STEP )
+  {
+    pa->flags &= ~ELUA_UIP_F_RESTART;
+    uip_setrcvwnd( room );
+    uip_restart();
+  }
+
+  if( event )
+    elua_uip_event( sockno );
+}
+
+#ifdef BUILD_CON_TCP
+// The uIP application for the output of the telnet socket (its input is still
+// received by elua_uip_appcall). The console output waits in the send ring
+// until it fills a segment, or until nothing is in transit and it was flushed
+// or waited long enough (Nagle's algorithm, RFC 896, with a timer), so the
+// output of consecutive writes shares the same segments.
+static void elua_uip_telnet_appcall( elua_uip_async_state *pa )
+{
+  u16 unacked, pending, len;
+
+  if( uip_acked() && pa->txlen > 0 )
+  {
+    len = UMIN( uip_ackedlen(), pa->txlen );
+    pa->txstart = ( pa->txstart + len ) % ELUA_UIP_TX_BUF_SIZE;
+    pa->txlen -= len;
+  }
+  if( uip_aborted() || uip_timedout() || uip_closed() )
+    return;
+  unacked = uip_unacked();
+  pending = pa->txlen - unacked;
+  if( pending == 0 )
+  {
+    telnet_timer = 0;
+    if( unacked == 0 )
+      elua_uip_telnet_flush = 0;
+  }
+#if UIP_TCP_SND_WND
+  if( uip_rexmit() )
+#else
+  if( unacked > 0 && ( uip_rexmit() || uip_poll() ) )
+#endif
+  {
+    if( unacked > 0 )
+      elua_uip_tx_send( pa, 0, UMIN( unacked, uip_mss() ) );
+  }
+  else if( pending > 0 && unacked < uip_sndwnd() )
+  {
+    len = UMIN( UMIN( pending, uip_mss() ), uip_sndwnd() - unacked );
+    if( len == uip_mss() || ( unacked == 0 && ( elua_uip_telnet_flush || telnet_timer >= ELUA_NET_TELNET_DELAY_MS ) ) )
+    {
+      elua_uip_tx_send( pa, unacked, len );
+      elua_uip_telnet_segments ++;
+      elua_uip_telnet_bytes += len;
+      telnet_timer = 0;
+    }
+  }
+}
+#endif
+
+// *****************************************************************************
+// UDP sockets support
+
+#if UIP_UDP
+
+// Size of the datagram queue of a UDP socket (the datagrams that don't fit are dropped)
+#ifndef ELUA_NET_UDP_QUEUE_SIZE
+#define ELUA_NET_UDP_QUEUE_SIZE ( 2 * UIP_BUFSIZE )
+#endif
+#define ELUA_UIP_UDP_QUEUE_SIZE ( ELUA_NET_UDP_QUEUE_SIZE & ~1 )
+
+// Largest datagram that fits in the uIP buffer
+#define ELUA_UIP_UDP_MAX_DATA   ( UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN )
+
+// Header of a datagram in the queue (followed by its data)
+typedef struct
+{
+  u16 len;
+  u16 port;
+  u16 ipwords[ 2 ];
+} elua_uip_udp_hdr;
+
+// Marks the end of the data in the queue, the next datagram is at the start
+#define ELUA_UIP_UDP_WRAP       0xFFFF
+
+// Space taken by a datagram in the queue
+#define ELUA_UIP_UDP_ENTRY_SIZE( len )  ( ( sizeof( elua_uip_udp_hdr ) + ( len ) + 1 ) & ~1 )
+
+#define UDPBUF                  ( ( struct uip_udpip_hdr* )&uip_buf[ UIP_LLH_LEN ] )
+
+typedef struct
+{
+  u8 *queue;                    // datagram queue, NULL if the socket is not used
+  volatile u16 rd, wr;          // the queue is empty if rd == wr
+  const void *txptr;            // datagram to send
+  volatile elua_net_size txlen;
+  uip_ipaddr_t txaddr;
+  u16 txport;
+  volatile u8 res;
+} elua_uip_udp_state;
+
+static elua_uip_udp_state elua_uip_udp[ UIP_UDP_CONNS ];
+
+#define ELUA_UIP_IS_UDP_SOCK( s ) ( elua_uip_configured && s >= UIP_CONNS && s < UIP_CONNS + UIP_UDP_CONNS && elua_uip_udp[ s - UIP_CONNS ].queue != NULL )
+
+// Add the received datagram to the queue of the socket, returns 0 if it doesn't fit
+static int elua_uip_udp_put( elua_uip_udp_state *pu )
+{
+  u16 wr = pu->wr, rd = pu->rd, len = uip_datalen();
+  u16 need = ELUA_UIP_UDP_ENTRY_SIZE( len );
+  elua_uip_udp_hdr *ph;
+
+  if( wr >= rd )
+  {
+    // Room at the end of the queue? (wr can reach the end only if rd > 0)
+    if( ELUA_UIP_UDP_QUEUE_SIZE - wr < need || ( ELUA_UIP_UDP_QUEUE_SIZE - wr == need && rd == 0 ) )
+    {
+      // No, continue at the start
+      if( rd <= need )
+        return 0;
+      ( ( elua_uip_udp_hdr* )( pu->queue + wr ) )->len = ELUA_UIP_UDP_WRAP;
+      wr = 0;
+    }
+  }
+  else if( rd - wr <= need )
+    return 0;
+  ph = ( elua_uip_udp_hdr* )( pu->queue + wr );
+  ph->len = len;
+  ph->port = UDPBUF->srcport;
+  ph->ipwords[ 0 ] = UDPBUF->srcipaddr[ 0 ];
+  ph->ipwords[ 1 ] = UDPBUF->srcipaddr[ 1 ];
+  memcpy( ph + 1, uip_appdata, len );
+  wr += need;
+  pu->wr = wr == ELUA_UIP_UDP_QUEUE_SIZE ? 0 : wr;
+  return 1;
+}
+
+// Return the first datagram in the queue of the socket (NULL if the queue is empty)
+static elua_uip_udp_hdr* elua_uip_udp_peek( elua_uip_udp_state *pu )
+{
+  elua_uip_udp_hdr *ph;
+
+  if( pu->rd == pu->wr )
+    return NULL;
+  ph = ( elua_uip_udp_hdr* )( pu->queue + pu->rd );
+  if( ph->len == ELUA_UIP_UDP_WRAP )
+  {
+    pu->rd = 0;
+    ph = ( elua_uip_udp_hdr* )pu->queue;
+  }
+  return ph;
+}
+
+// Remove the first datagram from the queue of the socket. An empty queue
+// starts again at the beginning of the buffer.
+static void elua_uip_udp_pop( elua_uip_udp_state *pu, elua_uip_udp_hdr *ph )
+{
+  u16 rd = pu->rd + ELUA_UIP_UDP_ENTRY_SIZE( ph->len );
+  int old_status;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( rd == pu->wr )
+    pu->rd = pu->wr = 0;
+  else
+    pu->rd = rd == ELUA_UIP_UDP_QUEUE_SIZE ? 0 : rd;
+  platform_cpu_set_global_interrupts( old_status );
+}
+
+// The uIP application for the UDP sockets. Returns 0 if the connection is not
+// a UDP socket (so it belongs to the DHCP client or the DNS resolver)
+static int elua_uip_udp_sock_appcall()
+{
+  int udpno = uip_udp_conn - uip_udp_conns;
+  elua_uip_udp_state *pu = elua_uip_udp + udpno;
+
+  if( pu->queue == NULL )
+    return 0;
+  if( uip_newdata() )
+  {
+    if( elua_uip_udp_put( pu ) )
+      elua_uip_event( UIP_CONNS + udpno );
+  }
+  else if( uip_poll() && pu->txlen > 0 )
+  {
+    // The remote address is set only for this datagram (see elua_uip_udp_sent),
+    // so the socket keeps receiving datagrams from any host
+    uip_ipaddr_copy( uip_udp_conn->ripaddr, pu->txaddr );
+    uip_udp_conn->rport = pu->txport;
+    memcpy( uip_appdata, pu->txptr, pu->txlen );
+    uip_udp_send( pu->txlen );
+    pu->txlen = 0;
+    elua_uip_event( UIP_CONNS + udpno );
+  }
+  return 1;
+}
+
+// Called after a UDP connection was polled (from the main loop)
+static void elua_uip_udp_sent( int udpno )
+{
+  struct uip_udp_conn *pconn = uip_udp_conns + udpno;
+
+  if( elua_uip_udp[ udpno ].queue != NULL && pconn->rport != 0 )
+  {
+    uip_ipaddr( pconn->ripaddr, 0, 0, 0, 0 );
+    pconn->rport = 0;
+  }
+}
+
+#endif // #if UIP_UDP
 
-// Special handling for "accept"
-volatile static u8 elua_uip_accept_request;
-volatile static int elua_uip_accept_sock;
-volatile static elua_net_ip elua_uip_accept_remote;
+// *****************************************************************************
+// eLua UIP application (used to implement the eLua TCP/IP services)
 
 void elua_uip_appcall()
 {
   volatile struct elua_uip_state *s;
+  elua_uip_async_state *pa;
   elua_net_size temp;
   int sockno;
   
@@ -279,6 +829,7 @@ void elua_uip_appcall()
     if( uip_conns + temp == uip_conn )
       break;
   sockno = ( int )temp;
+  pa = elua_uip_async + sockno;
 
   if( uip_connected() )
   {
@@ -291,23 +842,53 @@ void elua_uip_appcall()
         return;
       }
       else
+      {
         elua_uip_telnet_socket = sockno;
+        elua_uip_async_reset( sockno, 0 );
+        elua_uip_telnet_flush = 0;
+        elua_uip_telnet_segments = elua_uip_telnet_bytes = 0;
+      }
     }
     else
 #endif
-    if( elua_uip_accept_request )
+    if( s->state == ELUA_UIP_STATE_CONNECT )
+      s->state = ELUA_UIP_STATE_IDLE;
+    else
     {
-      elua_uip_accept_sock = sockno;
-      elua_uip_accept_remote.ipwords[ 0 ] = uip_conn->ripaddr[ 0 ];
-      elua_uip_accept_remote.ipwords[ 1 ] = uip_conn->ripaddr[ 1 ];      
-      elua_uip_accept_request = 0;
-    }
-    else if( s->state == ELUA_UIP_STATE_CONNECT )
+      // Incoming connection, keep it until it is accepted. It receives in the
+      // spare ring if there is one, otherwise the data flow is stopped until
+      // it is accepted.
+      s->res = ELUA_NET_ERR_OK;
       s->state = ELUA_UIP_STATE_IDLE;
-    uip_stop();
+      elua_uip_async_reset( sockno, ELUA_UIP_F_PENDING );
+      if( pa->buf == NULL )
+      {
+        pa->buf = elua_uip_rx_spare;
+        elua_uip_rx_spare = NULL;
+      }
+      if( pa->buf != NULL )
+        pa->flags |= ELUA_UIP_F_BUFFERED;
+      elua_uip_event( sockno );
+    }
+    if( !( pa->flags & ELUA_UIP_F_BUFFERED ) )
+    {
+      uip_stop();
+      return;
+    }
+    uip_setrcvwnd( ELUA_UIP_RX_BUF_SIZE );
+  }
+
+  if( pa->flags & ELUA_UIP_F_BUFFERED )
+  {
+    elua_uip_async_appcall( s, pa, sockno );
     return;
   }
 
+#ifdef BUILD_CON_TCP
+  if( sockno == elua_uip_telnet_socket )
+    elua_uip_telnet_appcall( pa );
+#endif
+
   if( s->state == ELUA_UIP_STATE_IDLE )
     return;
     
@@ -331,34 +912,6 @@ void elua_uip_appcall()
     s->state = ELUA_UIP_STATE_IDLE;
     return;
   }
-       
-  // Handle data send  
-  if( ( uip_acked() || uip_rexmit() || uip_poll() ) && ( s->state == ELUA_UIP_STATE_SEND ) )
-  {
-    // Special translation for TELNET: prepend all '\n' with '\r'
-    // We write directly in UIP's buffer 
-    if( uip_acked() )
-    {
-      elua_net_size minlen = UMIN( s->len, uip_mss() );    
-      s->len -= minlen;
-      s->ptr += minlen;
-      if( s->len == 0 )
-        s->state = ELUA_UIP_STATE_IDLE;
-    }
-    if( s->len > 0 ) // need to (re)transmit?
-    {
-#ifdef BUILD_CON_TCP
-      if( sockno == elua_uip_telnet_socket )
-      {
-        temp = elua_uip_telnet_prep_send( s->ptr, s->len );
-        uip_send( uip_sappdata, temp );
-      }
-      else
-#endif      
-        uip_send( s->ptr, UMIN( s->len, uip_mss() ) );
-    }
-    return;
-  }
   
   // Handle close
   if( s->state == ELUA_UIP_STATE_CLOSE )
@@ -368,76 +921,18 @@ void elua_uip_appcall()
     return;
   }
           
-  // Handle data receive  
+  // Handle data receive (only the telnet socket receives this way, the other
+  // sockets use their receive ring)
   if( uip_newdata() )
   {
-    if( s->state == ELUA_UIP_STATE_RECV_2 )
+#ifdef BUILD_CON_TCP
+    if( s->state == ELUA_UIP_STATE_RECV_2 && sockno == elua_uip_telnet_socket )
     {
-#ifdef BUILD_CON_TCP      
-      if( sockno == elua_uip_telnet_socket )
-      {
-        elua_uip_telnet_handle_input( s );
-        return;
-      }
-#endif   
-      int lastfound = 0;
-      
-      // Check end of transmission
-      if( uip_datalen() < UIP_RECEIVE_WINDOW )
-        lastfound = 1;
-      // Check overflow
-      if( s->len < uip_datalen() )
-      {
-        s->res = ELUA_NET_ERR_OVERFLOW;   
-        temp = s->len;
-      }
-      else
-        temp = uip_datalen();
-      
-      if( s->readto != ELUA_NET_NO_LASTCHAR )
-      {
-        char *tptr = ( char* )uip_appdata;
-        char *last = ( char* )uip_appdata + temp - 1;
-        luaL_Buffer *pbuf = ( luaL_Buffer* )s->ptr;
-        char* dest = ( char* )s->ptr;
-        
-        while( tptr <= last )
-        {
-          if( *tptr == s->readto )
-          {
-            lastfound = 1;
-            break;
-          }
-          if( *tptr != '\r' )
-          {
-            if( s->res )
-              luaL_addchar( pbuf, *tptr );
-            else
-              *dest ++ = *tptr;
-            s->len --;
-          }
-          tptr ++;
-        }
-      }
-      else
-      {
-        if( s->res )
-          luaL_addlstring( ( luaL_Buffer* )s->ptr, ( const char* )uip_appdata, temp );        
-        else
-          memcpy( ( char* )s->ptr, ( const char* )uip_appdata, temp );
-        s->len -= temp;
-      }
-        
-      // Do we need to read another packet?
-      if( s->len == 0 || lastfound )
-      {
-        uip_stop();
-        s->res = ELUA_NET_ERR_OK;
-        s->state = ELUA_UIP_STATE_IDLE;
-      }
+      elua_uip_telnet_handle_input( s );
+      return;
     }
-    else
-      uip_stop();
+#endif
+    uip_stop();
   }
 }
 
@@ -484,6 +979,10 @@ void elua_uip_init( const struct uip_eth_addr *paddr )
 
 void elua_uip_udp_appcall()
 {
+#if UIP_UDP
+  if( elua_uip_udp_sock_appcall() )
+    return;
+#endif
   resolv_appcall();
   dhcpc_appcall();
 }
@@ -502,15 +1001,49 @@ static void elua_prep_socket_state( volatile struct elua_uip_state *pstate, void
   pstate->state = state;
 }
 
+#if UIP_UDP
+// Create a UDP socket (with a local port chosen by uIP)
+static int elua_net_socket_udp()
+{
+  struct uip_udp_conn *pconn;
+  elua_uip_udp_state *pu;
+  u8 *queue;
+  int old_status, udpno = -1;
+
+  if( ( queue = ( u8* )malloc( ELUA_UIP_UDP_QUEUE_SIZE ) ) == NULL )
+    return -1;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( ( pconn = uip_udp_new( NULL, 0 ) ) != NULL )
+  {
+    udpno = pconn - uip_udp_conns;
+    pu = elua_uip_udp + udpno;
+    pu->queue = queue;
+    pu->rd = pu->wr = 0;
+    pu->txlen = 0;
+    pu->res = ELUA_NET_ERR_OK;
+  }
+  platform_cpu_set_global_interrupts( old_status );
+  if( udpno == -1 )
+  {
+    free( queue );
+    return -1;
+  }
+  return UIP_CONNS + udpno;
+}
+#endif
+
 int elua_net_socket( int type )
 {
   int i;
   struct uip_conn* pconn;
   int old_status;
   
-  // [TODO] add UDP support at some point.
   if( type == ELUA_NET_SOCK_DGRAM )
+#if UIP_UDP
+    return elua_uip_configured ? elua_net_socket_udp() : -1;
+#else
     return -1;
+#endif
   
   old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
   // Iterate through the list of connections, looking for a free one
@@ -521,26 +1054,248 @@ int elua_net_socket( int type )
     { 
       // Found a free connection, reserve it for later use
       uip_conn_reserve( i );
+      elua_uip_async_reset( i, 0 );
       break;
     }
   }
   platform_cpu_set_global_interrupts( old_status );
-  return i == UIP_CONNS ? -1 : i;
+  if( i == UIP_CONNS )
+    return -1;
+  // Allocate the receive ring now, so the socket never loses data
+  if( elua_uip_async_enable( i, 0 ) == NULL )
+  {
+    uip_conns[ i ].tcpstateflags = UIP_CLOSED;
+    return -1;
+  }
+  return i;
+}
+
+#ifdef BUILD_CON_TCP
+// Copy console output to the send ring of the telnet socket, adding a '\r'
+// before each '\n'. The function waits only while the ring is full, the
+// output is sent by elua_uip_telnet_appcall.
+static elua_net_size elua_uip_telnet_send( int s, const char* buf, elua_net_size len )
+{
+  elua_uip_async_state *pa = elua_uip_async + s;
+  char temp[ 64 ];
+  elua_net_size done = 0, used;
+  u16 n, put;
+
+  if( pa->txbuf == NULL && ( pa->txbuf = ( u8* )malloc( ELUA_UIP_TX_BUF_SIZE ) ) == NULL )
+    return -1;
+  while( done < len )
+  {
+    used = elua_uip_telnet_prep_send( buf + done, len - done, temp, sizeof( temp ), &n );
+    for( put = 0; put < n; )
+    {
+      put += elua_uip_tx_put( pa, ( const u8* )temp + put, n - put );
+      if( put < n )
+      {
+        platform_eth_force_interrupt();
+        elua_uip_poll();
+        if( !uip_conn_active( s ) )
+          return done;
+      }
+    }
+    done += used;
+  }
+  // Send the full segments right away
+  if( pa->txlen >= uip_conns[ s ].mss )
+    platform_eth_force_interrupt();
+  return len;
 }
+#endif
 
-// Send data
+// Send data. The function returns when all the data was copied to the send
+// ring of the socket, the data is sent while the caller does something else.
 elua_net_size elua_net_send( int s, const void* buf, elua_net_size len )
 {
-  volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );
-  
   if( !ELUA_UIP_IS_SOCK_OK( s ) || !uip_conn_active( s ) )
     return -1;
   if( len == 0 )
     return 0;
-  elua_prep_socket_state( pstate, ( void* )buf, len, ELUA_NET_NO_LASTCHAR, ELUA_NET_ERR_OK, ELUA_UIP_STATE_SEND );
-  platform_eth_force_interrupt();
-  while( pstate->state != ELUA_UIP_STATE_IDLE );
-  return len - pstate->len;
+#ifdef BUILD_CON_TCP
+  if( s == elua_uip_telnet_socket )
+    return elua_uip_telnet_send( s, ( const char* )buf, len );
+#endif
+  return elua_net_send_buffered( s, buf, len, PLATFORM_TIMER_SYS_ID, PLATFORM_TIMER_INF_TIMEOUT );
+}
+
+// Send data through the send ring of the socket, waiting at most 'to_us' for
+// room in the ring. Returns the number of bytes queued (only the data that
+// was queued is sent if the timeout expires). A timeout of 0 never waits.
+elua_net_size elua_net_send_buffered( int s, const void* buf, elua_net_size len, unsigned timer_id, timer_data_type to_us )
+{
+  volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );
+  elua_uip_async_state *pa;
+  timer_data_type tmrstart = 0;
+  elua_net_size total = 0, temp;
+
+  if( !ELUA_UIP_IS_SOCK_OK( s ) || !uip_conn_active( s ) )
+    return -1;
+  if( ( pa = elua_uip_async_enable( s, 1 ) ) == NULL )
+    return -1;
+  pstate->res = ELUA_NET_ERR_OK;
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
+    tmrstart = platform_timer_start( timer_id );
+  while( total < len )
+  {
+    if( ( temp = elua_uip_tx_put( pa, ( const u8* )buf + total, UMIN( len - total, ELUA_UIP_TX_BUF_SIZE ) ) ) > 0 )
+    {
+      total += temp;
+      platform_eth_force_interrupt();
+      continue;
+    }
+    if( to_us == 0 || ( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us ) )
+    {
+      if( total == 0 )
+        pstate->res = ELUA_NET_ERR_TIMEDOUT;
+      break;
+    }
+    elua_uip_poll();
+    if( !uip_conn_active( s ) )
+      break;
+  }
+  return total;
+}
+
+// Send data straight from the caller's buffer (uIP copies it only to the packet
+// it sends), for data that doesn't change, such as the files in ROMFS. The data
+// already in the send ring is sent first. The function returns when all the
+// data is acknowledged (or the connection is closed), returning the number of
+// bytes acknowledged.
+s32 elua_net_send_static( int s, const void* buf, u32 len )
+{
+  volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );
+  elua_uip_async_state *pa;
+  u32 total = 0;
+  u16 chunk;
+  int old_status;
+
+  if( !ELUA_UIP_IS_SOCK_OK( s ) || !uip_conn_active( s ) )
+    return -1;
+  if( ( pa = elua_uip_async_enable( s, 0 ) ) == NULL )
+    return -1;
+  pstate->res = ELUA_NET_ERR_OK;
+  while( pa->txlen > 0 && uip_conn_active( s ) )
+    elua_uip_poll();
+  while( total < len && uip_conn_active( s ) )
+  {
+    chunk = UMIN( len - total, 0x8000 );
+    old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+    pa->txext = ( const u8* )buf + total;
+    pa->txstart = 0;
+    pa->txlen = chunk;
+    platform_cpu_set_global_interrupts( old_status );
+    platform_eth_force_interrupt();
+    while( pa->txlen > 0 && uip_conn_active( s ) )
+      elua_uip_poll();
+    old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+    total += chunk - pa->txlen;
+    pa->txext = NULL;
+    pa->txstart = pa->txlen = 0;
+    platform_cpu_set_global_interrupts( old_status );
+  }
+  if( total < len )
+    pstate->res = pa->err != ELUA_NET_ERR_OK ? pa->err : ELUA_NET_ERR_CLOSED;
+  return total;
+}
+
+// Remove 'len' bytes that were read from the receive ring of a socket, and let
+// uIP enlarge the window if the ring has enough room again
+static void elua_uip_rx_consume( int s, elua_uip_async_state *pa, u16 len )
+{
+  int old_status;
+  u16 room;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  pa->rxstart = ( pa->rxstart + len ) % ELUA_UIP_RX_BUF_SIZE;
+  pa->rxlen -= len;
+  room = ELUA_UIP_RX_BUF_SIZE - pa->rxlen;
+  platform_cpu_set_global_interrupts( old_status );
+  if( room >= uip_conns[ s ].rcv_wnd + ELUA_UIP_RX_WND_STEP )
+    platform_eth_force_interrupt();
+}
+
+// "read" from the receive ring of a socket
+static elua_net_size elua_net_recv_buffered( int s, void* buf, elua_net_size maxsize, s16 readto, unsigned timer_id, timer_data_type to_us, int with_buffer )
+{
+  volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );
+  elua_uip_async_state *pa;
+  timer_data_type tmrstart = 0;
+  elua_net_size total = 0, temp;
+  u16 rxlen, pos, used;
+  int lastfound = 0;
+  char c;
+
+  if( ( pa = elua_uip_async_enable( s, 0 ) ) == NULL )
+    return -1;
+  pstate->res = ELUA_NET_ERR_OK;
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
+    tmrstart = platform_timer_start( timer_id );
+  while( 1 )
+  {
+    // The data already in the ring is returned right away
+    if( pa->rxlen == 0 )
+      elua_uip_poll();
+    // uIP only adds data to the ring, so this part can be read without
+    // disabling the interrupts
+    rxlen = pa->rxlen;
+    pos = pa->rxstart;
+    used = 0;
+    if( readto == ELUA_NET_NO_LASTCHAR )
+    {
+      used = UMIN( rxlen, maxsize - total );
+      temp = UMIN( used, ELUA_UIP_RX_BUF_SIZE - pos );
+      if( with_buffer )
+      {
+        luaL_addlstring( ( luaL_Buffer* )buf, ( const char* )pa->buf + pos, temp );
+        luaL_addlstring( ( luaL_Buffer* )buf, ( const char* )pa->buf, used - temp );
+      }
+      else
+      {
+        memcpy( ( char* )buf + total, pa->buf + pos, temp );
+        memcpy( ( char* )buf + total + temp, pa->buf, used - temp );
+      }
+      total += used;
+    }
+    else
+      while( used < rxlen && total < maxsize )
+      {
+        c = pa->buf[ pos ];
+        pos = pos == ELUA_UIP_RX_BUF_SIZE - 1 ? 0 : pos + 1;
+        used ++;
+        if( c == readto )
+        {
+          lastfound = 1;
+          break;
+        }
+        if( c == '\r' )
+          continue;
+        if( with_buffer )
+          luaL_addchar( ( luaL_Buffer* )buf, c );
+        else
+          ( ( char* )buf )[ total ] = c;
+        total ++;
+      }
+    if( used > 0 )
+      elua_uip_rx_consume( s, pa, used );
+    // Like the blocking "read", return as soon as some data is available,
+    // unless reading up to a given char
+    if( total == maxsize || lastfound || ( total > 0 && readto == ELUA_NET_NO_LASTCHAR ) )
+      break;
+    if( !uip_conn_active( s ) && pa->rxlen == 0 )
+    {
+      pstate->res = pa->err != ELUA_NET_ERR_OK ? pa->err : ELUA_NET_ERR_CLOSED;
+      break;
+    }
+    if( to_us == 0 || ( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us ) )
+    {
+      pstate->res = ELUA_NET_ERR_TIMEDOUT;
+      break;
+    }
+  }
+  return total;
 }
 
 // Internal "read" function
@@ -550,18 +1305,26 @@ static elua_net_size elua_net_recv_internal( int s, void* buf, elua_net_size max
   timer_data_type tmrstart = 0;
   int old_status;
   
-  if( !ELUA_UIP_IS_SOCK_OK( s ) || !uip_conn_active( s ) )
+  if( !ELUA_UIP_IS_SOCK_OK( s ) )
     return -1;
   if( maxsize == 0 )
     return 0;
+  // All the sockets read from their receive ring, except the telnet socket
+#ifdef BUILD_CON_TCP
+  if( s != elua_uip_telnet_socket )
+#endif
+    return elua_net_recv_buffered( s, buf, maxsize, readto, timer_id, to_us, with_buffer );
+  if( !uip_conn_active( s ) )
+    return -1;
   elua_prep_socket_state( pstate, buf, maxsize, readto, with_buffer, ELUA_UIP_STATE_RECV );
-  if( to_us > 0 )
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
     tmrstart = platform_timer_start( timer_id );
   while( 1 )
   {
+    elua_uip_poll();
     if( pstate->state == ELUA_UIP_STATE_IDLE )
       break;
-    if( to_us > 0 && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us )
+    if( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us )
     {
       old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
       if( pstate->state != ELUA_UIP_STATE_IDLE )
@@ -602,16 +1365,81 @@ int elua_net_get_telnet_socket()
   return res;
 }
 
+// Send the console output that waits in the send ring of the telnet socket
+// without waiting for more output (see elua_uip_telnet_appcall)
+void elua_net_telnet_flush()
+{
+#ifdef BUILD_CON_TCP
+  int s = elua_uip_telnet_socket;
+
+  if( s != -1 && elua_uip_async[ s ].txlen > 0 )
+  {
+    elua_uip_telnet_flush = 1;
+    platform_eth_force_interrupt();
+  }
+#endif
+}
+
+// Get the number of segments and bytes of console output sent on the telnet
+// connection. Returns -1 if there is no console over TCP.
+int elua_net_telnet_stats( u32 *psegments, u32 *pbytes, int reset )
+{
+#ifdef BUILD_CON_TCP
+  int old_status;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  *psegments = elua_uip_telnet_segments;
+  *pbytes = elua_uip_telnet_bytes;
+  if( reset )
+    elua_uip_telnet_segments = elua_uip_telnet_bytes = 0;
+  platform_cpu_set_global_interrupts( old_status );
+  return 0;
+#else
+  return -1;
+#endif
+}
+
 // Close socket
 int elua_net_close( int s )
 {
   volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );  
   
-  if( !ELUA_UIP_IS_SOCK_OK( s ) || !uip_conn_active( s ) )
+#if UIP_UDP
+  if( ELUA_UIP_IS_UDP_SOCK( s ) )
+  {
+    elua_uip_udp_state *pu = elua_uip_udp + s - UIP_CONNS;
+    int old_status;
+    u8 *queue;
+
+    old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+    uip_udp_remove( uip_udp_conns + s - UIP_CONNS );
+    queue = pu->queue;
+    pu->queue = NULL;
+    platform_cpu_set_global_interrupts( old_status );
+    free( queue );
+    return 0;
+  }
+#endif
+  if( !ELUA_UIP_IS_SOCK_OK( s ) )
     return -1;
+  if( !uip_conn_active( s ) )
+  {
+    elua_uip_async_free( s );
+    return -1;
+  }
+  // Wait until all the data in the send ring is acknowledged
+#ifdef BUILD_CON_TCP
+  if( s == elua_uip_telnet_socket )
+    elua_net_telnet_flush();
+#endif
+  while( elua_uip_async[ s ].txlen > 0 && uip_conn_active( s ) )
+    elua_uip_poll();
   elua_prep_socket_state( pstate, NULL, 0, ELUA_NET_NO_LASTCHAR, ELUA_NET_ERR_OK, ELUA_UIP_STATE_CLOSE );
   platform_eth_force_interrupt();
-  while( pstate->state != ELUA_UIP_STATE_IDLE );
+  // uIP finishes by itself the connections closed by the remote host
+  while( pstate->state != ELUA_UIP_STATE_IDLE && ( uip_conns[ s ].tcpstateflags & UIP_TS_MASK ) == UIP_ESTABLISHED )
+    elua_uip_poll();
+  elua_uip_async_free( s );
   return pstate->res == ELUA_NET_ERR_OK ? 0 : -1;
 }
 
@@ -620,43 +1448,98 @@ int elua_net_get_last_err( int s )
 {
   volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );  
   
+#if UIP_UDP
+  if( ELUA_UIP_IS_UDP_SOCK( s ) )
+    return elua_uip_udp[ s - UIP_CONNS ].res;
+#endif
   if( !ELUA_UIP_IS_SOCK_OK( s ) )
     return -1;
   return pstate->res;
 }
 
+// Get the receive statistics of a TCP socket: the bytes waiting in its receive
+// ring, the bytes received in the ring and the bytes dropped because the ring
+// was full. The last two are cleared if 'reset' is not 0.
+int elua_net_rxstats( int s, u32 *pqueued, u32 *pbuffered, u32 *pdropped, int reset )
+{
+  elua_uip_async_state *pa = elua_uip_async + s;
+  int old_status;
+
+  if( !ELUA_UIP_IS_SOCK_OK( s ) )
+    return -1;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  *pqueued = pa->rxlen;
+  *pbuffered = pa->rxbuffered;
+  *pdropped = pa->rxdropped;
+  if( reset )
+    pa->rxbuffered = pa->rxdropped = 0;
+  platform_cpu_set_global_interrupts( old_status );
+  return 0;
+}
+
+// Helper: return (and remove from the pending list) a connection on the given
+// port (in network order) that wasn't accepted yet, or -1 if there isn't one
+static int elua_uip_get_pending( u16 port )
+{
+  int i, old_status, res = -1;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  for( i = 0; i < UIP_CONNS; i ++ )
+    if( ( elua_uip_async[ i ].flags & ELUA_UIP_F_PENDING ) && uip_conn_active( i ) && uip_conns[ i ].lport == port )
+    {
+      elua_uip_async[ i ].flags &= ~ELUA_UIP_F_PENDING;
+      res = i;
+      break;
+    }
+  platform_cpu_set_global_interrupts( old_status );
+  return res;
+}
+
 // Accept a connection on the given port, return its socket id (and the IP of the remote host by side effect)
+// The port keeps listening after this call, so the connections received until
+// the next call are not lost. A timeout of 0 never waits.
 int elua_accept( u16 port, unsigned timer_id, timer_data_type to_us, elua_net_ip* pfrom )
 {
   timer_data_type tmrstart = 0;
-  int old_status;
+  int old_status, sock;
+  u8 *spare = NULL;
   
+  pfrom->ipaddr = 0;
   if( !elua_uip_configured )
     return -1;
 #ifdef BUILD_CON_TCP
   if( port == ELUA_NET_TELNET_PORT )
     return -1;
 #endif  
+  // Keep a receive ring ready for the next incoming connection
+  if( elua_uip_rx_spare == NULL && ( spare = ( u8* )malloc( ELUA_UIP_RX_BUF_SIZE ) ) == NULL )
+    return -1;
   old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  if( elua_uip_rx_spare == NULL )
+    elua_uip_rx_spare = spare;
   uip_unlisten( htons( port ) );
   uip_listen( htons( port ) );
   platform_cpu_set_global_interrupts( old_status );
-  elua_uip_accept_sock = -1;
-  elua_uip_accept_request = 1;
-  if( to_us > 0 )
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
     tmrstart = platform_timer_start( timer_id );
   while( 1 )
   {
-    if( elua_uip_accept_request == 0 )
+    elua_uip_poll();
+    if( ( sock = elua_uip_get_pending( htons( port ) ) ) != -1 )
       break;
-    if( to_us > 0 && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us )
-    {
-      elua_uip_accept_request = 0;
-      break;
-    }
+    if( to_us == 0 || ( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us ) )
+      return -1;
   }  
-  *pfrom = elua_uip_accept_remote;
-  return elua_uip_accept_sock;
+  // The connection has its receive ring already, unless there was no spare
+  // ring when it came
+  if( elua_uip_async_enable( sock, 0 ) == NULL )
+  {
+    elua_net_close( sock );
+    return -1;
+  }
+  pfrom->ipwords[ 0 ] = uip_conns[ sock ].ripaddr[ 0 ];
+  pfrom->ipwords[ 1 ] = uip_conns[ sock ].ripaddr[ 1 ];
+  return sock;
 }
 
 // Connect to a specified machine
@@ -664,22 +1547,210 @@ int elua_net_connect( int s, elua_net_ip addr, u16 port )
 {
   volatile struct elua_uip_state *pstate = ( volatile struct elua_uip_state* )&( uip_conns[ s ].appstate );
   uip_ipaddr_t ipaddr;
+  int old_status;
   
   if( !ELUA_UIP_IS_SOCK_OK( s ) )
     return -1;
   // The socket should have been reserved by a previous call to "elua_net_socket"
   if( !uip_conn_is_reserved( s ) )
     return -1;
+  if( elua_uip_async_enable( s, 0 ) == NULL )
+    return -1;
   // Initiate the connect call  
   uip_ipaddr( ipaddr, addr.ipbytes[ 0 ], addr.ipbytes[ 1 ], addr.ipbytes[ 2 ], addr.ipbytes[ 3 ] );
   elua_prep_socket_state( pstate, NULL, 0, ELUA_NET_NO_LASTCHAR, ELUA_NET_ERR_OK, ELUA_UIP_STATE_CONNECT );  
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
   if( uip_connect_socket( s, &ipaddr, htons( port ) ) == NULL )
+  {
+    platform_cpu_set_global_interrupts( old_status );
     return -1;
+  }
+  // The SYN advertises the whole receive ring
+  uip_conns[ s ].rcv_wnd = ELUA_UIP_RX_BUF_SIZE;
+  platform_cpu_set_global_interrupts( old_status );
   // And wait for it to finish
-  while( pstate->state != ELUA_UIP_STATE_IDLE );
+  while( pstate->state != ELUA_UIP_STATE_IDLE )
+    elua_uip_poll();
   return pstate->res == ELUA_NET_ERR_OK ? 0 : -1;
 }
 
+#if UIP_UDP
+
+// Set the local port of a UDP socket
+int elua_net_bind( int s, u16 port )
+{
+  struct uip_udp_conn *pconn = uip_udp_conns + s - UIP_CONNS;
+  int i, old_status, res = 0;
+
+  if( !ELUA_UIP_IS_UDP_SOCK( s ) || port == 0 )
+    return -1;
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  for( i = 0; i < UIP_UDP_CONNS; i ++ )
+    if( uip_udp_conns + i != pconn && uip_udp_conns[ i ].lport == htons( port ) )
+      res = -1;
+  if( res == 0 )
+    uip_udp_bind( pconn, htons( port ) );
+  platform_cpu_set_global_interrupts( old_status );
+  return res;
+}
+
+// Send a datagram to the given address and port. The function returns after
+// the datagram was given to the Ethernet driver.
+// NOTE: like with any uIP connection, if the Ethernet address of the remote
+// host isn't known yet the datagram is replaced by an ARP request, so it's lost
+elua_net_size elua_net_sendto( int s, const void* buf, elua_net_size len, elua_net_ip addr, u16 port )
+{
+  elua_uip_udp_state *pu = elua_uip_udp + s - UIP_CONNS;
+
+  if( !ELUA_UIP_IS_UDP_SOCK( s ) || len < 0 || len > ELUA_UIP_UDP_MAX_DATA )
+    return -1;
+  pu->res = ELUA_NET_ERR_OK;
+  if( len == 0 )
+    return 0;
+  uip_ipaddr( pu->txaddr, addr.ipbytes[ 0 ], addr.ipbytes[ 1 ], addr.ipbytes[ 2 ], addr.ipbytes[ 3 ] );
+  pu->txport = htons( port );
+  pu->txptr = buf;
+  pu->txlen = len;
+  platform_eth_force_interrupt();
+  while( pu->txlen > 0 )
+    elua_uip_poll();
+  return len;
+}
+
+// Internal "recvfrom" function
+static elua_net_size elua_net_recvfrom_internal( int s, void *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us, int with_buffer )
+{
+  elua_uip_udp_state *pu = elua_uip_udp + s - UIP_CONNS;
+  timer_data_type tmrstart = 0;
+  elua_uip_udp_hdr *ph;
+  elua_net_size len;
+
+  pfrom->ipaddr = 0;
+  *pport = 0;
+  if( !ELUA_UIP_IS_UDP_SOCK( s ) || maxsize < 0 )
+    return -1;
+  pu->res = ELUA_NET_ERR_OK;
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
+    tmrstart = platform_timer_start( timer_id );
+  while( ( ph = elua_uip_udp_peek( pu ) ) == NULL )
+  {
+    if( to_us == 0 || ( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us ) )
+    {
+      pu->res = ELUA_NET_ERR_TIMEDOUT;
+      return 0;
+    }
+    elua_uip_poll();
+  }
+  // The part of the datagram that doesn't fit in the buffer is discarded
+  len = ph->len;
+  if( len > maxsize )
+  {
+    len = maxsize;
+    pu->res = ELUA_NET_ERR_OVERFLOW;
+  }
+  if( with_buffer )
+    luaL_addlstring( ( luaL_Buffer* )buf, ( const char* )( ph + 1 ), len );
+  else
+    memcpy( buf, ph + 1, len );
+  pfrom->ipwords[ 0 ] = ph->ipwords[ 0 ];
+  pfrom->ipwords[ 1 ] = ph->ipwords[ 1 ];
+  *pport = htons( ph->port );
+  elua_uip_udp_pop( pu, ph );
+  return len;
+}
+
+// Receive a datagram (upto 'maxsize' bytes) and the address and port of its sender
+elua_net_size elua_net_recvfrom( int s, void *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us )
+{
+  return elua_net_recvfrom_internal( s, buf, maxsize, pfrom, pport, timer_id, to_us, 0 );
+}
+
+// Same thing, but with a Lua buffer as argument
+elua_net_size elua_net_recvfrombuf( int s, luaL_Buffer *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us )
+{
+  return elua_net_recvfrom_internal( s, buf, maxsize, pfrom, pport, timer_id, to_us, 1 );
+}
+
+#define elua_uip_udp_readable( s )  ( elua_uip_udp_peek( elua_uip_udp + ( s ) - UIP_CONNS ) != NULL )
+#define elua_uip_udp_writable( s )  ( elua_uip_udp[ ( s ) - UIP_CONNS ].txlen == 0 )
+
+#else // #if UIP_UDP
+
+int elua_net_bind( int s, u16 port )
+{
+  return -1;
+}
+
+elua_net_size elua_net_sendto( int s, const void* buf, elua_net_size len, elua_net_ip addr, u16 port )
+{
+  return -1;
+}
+
+elua_net_size elua_net_recvfrom( int s, void *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us )
+{
+  return -1;
+}
+
+elua_net_size elua_net_recvfrombuf( int s, luaL_Buffer *buf, elua_net_size maxsize, elua_net_ip *pfrom, u16 *pport, unsigned timer_id, timer_data_type to_us )
+{
+  return -1;
+}
+
+#define ELUA_UIP_IS_UDP_SOCK( s )   0
+#define elua_uip_udp_readable( s )  0
+#define elua_uip_udp_writable( s )  0
+
+#endif // #if UIP_UDP
+
+// Wait until at least one of the sockets in 'rsocks' has data to read (or was
+// closed) or one of the sockets in 'wsocks' can send more data, for at most
+// 'to_us' (0 to only check the sockets). The wait also ends if there are Lua
+// interrupts to handle. On return the first *pnr entries of 'rsocks' and the
+// first *pnw entries of 'wsocks' are the sockets that are ready.
+// Returns the number of ready sockets or -1 for error.
+int elua_net_select( int *rsocks, unsigned *pnr, int *wsocks, unsigned *pnw, unsigned timer_id, timer_data_type to_us )
+{
+  timer_data_type tmrstart = 0;
+  unsigned i, nr, nw;
+  int s;
+
+  for( i = 0; i < *pnr; i ++ )
+    if( !ELUA_UIP_IS_UDP_SOCK( rsocks[ i ] ) && ( !ELUA_UIP_IS_SOCK_OK( rsocks[ i ] ) || elua_uip_async_enable( rsocks[ i ], 0 ) == NULL ) )
+      return -1;
+  for( i = 0; i < *pnw; i ++ )
+    if( !ELUA_UIP_IS_UDP_SOCK( wsocks[ i ] ) && !ELUA_UIP_IS_SOCK_OK( wsocks[ i ] ) )
+      return -1;
+  if( ELUA_UIP_HAS_TIMEOUT( to_us ) )
+    tmrstart = platform_timer_start( timer_id );
+  while( 1 )
+  {
+    elua_uip_poll();
+    for( i = nr = 0; i < *pnr; i ++ )
+    {
+      s = rsocks[ i ];
+      if( s >= UIP_CONNS ? elua_uip_udp_readable( s ) : ( elua_uip_async[ s ].rxlen > 0 || !uip_conn_active( s ) ) )
+        rsocks[ nr ++ ] = s;
+    }
+    for( i = nw = 0; i < *pnw; i ++ )
+    {
+      s = wsocks[ i ];
+      if( s >= UIP_CONNS ? elua_uip_udp_writable( s ) : ( ( uip_conns[ s ].appstate.state == ELUA_UIP_STATE_IDLE && elua_uip_async[ s ].txlen < ELUA_UIP_TX_BUF_SIZE ) || !uip_conn_active( s ) ) )
+        wsocks[ nw ++ ] = s;
+    }
+    if( nr + nw > 0 || to_us == 0 )
+      break;
+#ifdef BUILD_LUA_INT_HANDLERS
+    if( !elua_int_is_empty() )
+      break;
+#endif
+    if( ELUA_UIP_HAS_TIMEOUT( to_us ) && platform_timer_get_diff_crt( timer_id, tmrstart ) >= to_us )
+      break;
+  }
+  *pnr = nr;
+  *pnw = nw;
+  return nr + nw;
+}
+
 // Hostname lookup (resolver)
 elua_net_ip elua_net_lookup( const char* hostname )
 {
@@ -688,24 +1759,136 @@ elua_net_ip elua_net_lookup( const char* hostname )
   res.ipaddr = 0; 
 #ifdef BUILD_DNS
   u16_t *data;
+  int old_status;
   
+  // The cache is also changed by the answers (in the main loop)
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
   if( ( data = resolv_lookup( ( char* )hostname ) ) != NULL )
   {
-    // Name already saved locally
+    // Name already saved locally (the address is 0 if the name doesn't exist)
     res.ipwords[ 0 ] = data[ 0 ];
     res.ipwords[ 1 ] = data[ 1 ];
+    if( res.ipaddr )
+      elua_resolv_hits ++;
+    else
+      elua_resolv_neg_hits ++;
+    platform_cpu_set_global_interrupts( old_status );
   }
   else
   {
     // Name not saved locally, must make request
+    elua_resolv_misses ++;
     elua_resolv_req_done = 0;
     resolv_query( ( char* )hostname );
+    platform_cpu_set_global_interrupts( old_status );
     platform_eth_force_interrupt();
-    while( elua_resolv_req_done == 0 );
+    while( elua_resolv_req_done == 0 )
+      elua_uip_poll();
     res = elua_resolv_ip;
   }
 #endif
   return res;  
 }
 
+// Statistics of the resolver cache, returns -1 if there is no resolver
+int elua_net_dnsstats( u32 *phits, u32 *pneg, u32 *pmisses, int reset )
+{
+#ifdef BUILD_DNS
+  int old_status;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  *phits = elua_resolv_hits;
+  *pneg = elua_resolv_neg_hits;
+  *pmisses = elua_resolv_misses;
+  if( reset )
+    elua_resolv_hits = elua_resolv_neg_hits = elua_resolv_misses = 0;
+  platform_cpu_set_global_interrupts( old_status );
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+// Statistics of the ARP table (lookups for the outgoing IP packets)
+void elua_net_arpstats( u32 *phits, u32 *pmisses, int reset )
+{
+  int old_status;
+
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  *phits = uip_arp_stat.hits;
+  *pmisses = uip_arp_stat.misses;
+  if( reset )
+    uip_arp_stat.hits = uip_arp_stat.misses = 0;
+  platform_cpu_set_global_interrupts( old_status );
+}
+
+// Internet checksum (as in the IP, UDP and TCP headers) of a buffer
+u16 elua_net_chksum( const void* buf, u16 len )
+{
+  return ( u16 )~ntohs( uip_chksum( ( u16_t* )buf, len ) );
+}
+
+// *****************************************************************************
+// INT_NET_EVENT interrupt support
+
+#if defined( BUILD_INT_HANDLERS ) && defined( INT_NET_EVENT )
+
+int elua_net_int_set_status( elua_int_resnum resnum, int status )
+{
+  u8 msk = 1 << ( resnum & 0x07 );
+  int prev;
+
+  if( resnum >= ELUA_UIP_NUM_SOCKS )
+    return PLATFORM_INT_BAD_RESNUM;
+  prev = ( elua_uip_int_enabled[ resnum >> 3 ] & msk ) != 0;
+  if( status == PLATFORM_CPU_ENABLE )
+    elua_uip_int_enabled[ resnum >> 3 ] |= msk;
+  else
+    elua_uip_int_enabled[ resnum >> 3 ] &= ( u8 )~msk;
+  return prev;
+}
+
+int elua_net_int_get_status( elua_int_resnum resnum )
+{
+  if( resnum >= ELUA_UIP_NUM_SOCKS )
+    return PLATFORM_INT_BAD_RESNUM;
+  return ( elua_uip_int_enabled[ resnum >> 3 ] & ( 1 << ( resnum & 0x07 ) ) ) != 0;
+}
+
+int elua_net_int_get_flag( elua_int_resnum resnum, int clear )
+{
+  u8 msk = 1 << ( resnum & 0x07 );
+  int flag;
+
+  if( resnum >= ELUA_UIP_NUM_SOCKS )
+    return PLATFORM_INT_BAD_RESNUM;
+  flag = ( elua_uip_int_flag[ resnum >> 3 ] & msk ) != 0;
+  if( clear )
+    elua_uip_int_flag[ resnum >> 3 ] &= ( u8 )~msk;
+  return flag;
+}
+
+#endif // #if defined( BUILD_INT_HANDLERS ) && defined( INT_NET_EVENT )
+
+#else // #ifdef BUILD_UIP
+
+#include "elua_net.h"
+
+// Without TCP/IP support the INT_NET_EVENT interrupt never happens
+
+int elua_net_int_set_status( elua_int_resnum resnum, int status )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+
+int elua_net_int_get_status( elua_int_resnum resnum )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+
+int elua_net_int_get_flag( elua_int_resnum resnum, int clear )
+{
+  return PLATFORM_INT_NOT_HANDLED;
+}
+
 #endif // #ifdef BUILD_UIP
@@ -29,6 +29,9 @@
 #include "lundump.h"
 #include "lvm.h"
 #include "lrotable.h"
+#ifndef LUA_CROSS_COMPILER
+#include "platform_conf.h"
+#endif
 
 
 const char lua_ident[] =
@@ -328,7 +331,9 @@ LUA_API lua_Number lua_tonumber (lua_State *L, int idx) {
 LUA_API lua_Integer lua_tointeger (lua_State *L, int idx) {
   TValue n;
   const TValue *o = index2adr(L, idx);
-  if (tonumber(o, &n)) {
+  if (ttisint(o))
+    return ivalue(o);
+  else if (tonumber(o, &n)) {
     lua_Integer res;
     lua_Number num = nvalue(o);
     lua_number2integer(res, num);
@@ -437,7 +442,7 @@ LUA_API void lua_pushnil (lua_State *L) {
 
 LUA_API void lua_pushnumber (lua_State *L, lua_Number n) {
   lua_lock(L);
-  setnvalue(L->top, n);
+  luaO_setnum(L->top, n);
   api_incr_top(L);
   lua_unlock(L);
 }
@@ -445,7 +450,15 @@ LUA_API void lua_pushnumber (lua_State *L, lua_Number n) {
 
 LUA_API void lua_pushinteger (lua_State *L, lua_Integer n) {
   lua_lock(L);
-  setnvalue(L->top, cast_num(n));
+#ifdef LUA_NUMBER_HYBRID
+  if (cast(lua_Integer, cast_int(n)) == n) {
+    setivalue(L->top, cast_int(n));
+  }
+  else
+#endif
+  {
+    setnvalue(L->top, cast_num(n));
+  }
   api_incr_top(L);
   lua_unlock(L);
 }
@@ -1029,6 +1042,48 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
 }
 
 
+#ifdef BUILD_GC_STATS
+
+static void pushtimestats (lua_State *L, const GCTimeStats *ts, const char *name) {
+  int i;
+  lua_createtable(L, 0, 4);
+  lua_pushnumber(L, ts->count);
+  lua_setfield(L, -2, "count");
+  lua_pushnumber(L, ts->maxus);
+  lua_setfield(L, -2, "max");
+  lua_pushnumber(L, ts->totalus);
+  lua_setfield(L, -2, "total");
+  lua_createtable(L, GCSTATS_BUCKETS, 0);
+  for (i=0; i<GCSTATS_BUCKETS; i++) {
+    lua_pushnumber(L, ts->hist[i]);
+    lua_rawseti(L, -2, i + 1);
+  }
+  lua_setfield(L, -2, "hist");
+  lua_setfield(L, -2, name);
+}
+
+/*
+** push a table with the GC timing statistics; clear them if `reset' != 0
+*/
+LUA_API void lua_getgcstats (lua_State *L, int reset) {
+  static const char *const phases[] = {"pause", "propagate", "sweepstring",
+    "sweep", "finalize"};
+  GCStats *st = luaC_getstats();
+  int i;
+  lua_createtable(L, 0, 8);
+  for (i=0; i<=GCSfinalize; i++)
+    pushtimestats(L, &st->phase[i], phases[i]);
+  pushtimestats(L, &st->step, "step");
+  pushtimestats(L, &st->full, "full");
+  lua_pushnumber(L, st->cycles);
+  lua_setfield(L, -2, "cycles");
+  if (reset)
+    luaC_resetstats();
+}
+
+#endif // #ifdef BUILD_GC_STATS
+
+
 
 /*
 ** miscellaneous functions
@@ -198,9 +198,16 @@ static int luaB_collectgarbage (lua_State *L) {
   static const int optsnum[] = {LUA_GCSTOP, LUA_GCRESTART, LUA_GCCOLLECT,
     LUA_GCCOUNT, LUA_GCSTEP, LUA_GCSETPAUSE, LUA_GCSETSTEPMUL,
 		LUA_GCSETMEMLIMIT,LUA_GCGETMEMLIMIT};
-  int o = luaL_checkoption(L, 1, "collect", opts);
-  int ex = luaL_optint(L, 2, 0);
-  int res = lua_gc(L, optsnum[o], ex);
+  int o, ex, res;
+#ifdef BUILD_GC_STATS
+  if (lua_isstring(L, 1) && !strcmp(lua_tostring(L, 1), "stats")) {
+    lua_getgcstats(L, luaL_optint(L, 2, 0));
+    return 1;
+  }
+#endif
+  o = luaL_checkoption(L, 1, "collect", opts);
+  ex = luaL_optint(L, 2, 0);
+  res = lua_gc(L, optsnum[o], ex);
   switch (optsnum[o]) {
     case LUA_GCCOUNT: {
       int b = lua_gc(L, LUA_GCCOUNTB, 0);
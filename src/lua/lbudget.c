@@ -0,0 +1,150 @@
+// Lua per-thread memory budgets
+// Every block allocated through luaM_realloc_ is prefixed by a small header
+// that records the budget it was charged to, so it can be credited back to
+// the same budget when it is freed, no matter which thread frees it.
+
+#define LUA_CORE
+
+#include "lua.h"
+#include "lbudget.h"
+#include "lstate.h"
+#include "lgc.h"
+#include "ldo.h"
+#include "ltable.h"
+#include "lobject.h"
+
+#ifdef BUILD_MEM_BUDGETS
+
+#define LBUDGET_HDRSIZE       sizeof( L_Umaxalign )
+
+static lbudget budgets[ LBUDGET_MAX ];
+lu_byte lbudget_pending;
+
+// Return true if 'b' can grow from 'osize' to 'nsize' without going over
+// its hard limit
+static int lbudget_fits( const lbudget *b, size_t osize, size_t nsize )
+{
+  return b->hard == 0 || nsize <= osize || b->used - osize + nsize <= b->hard;
+}
+
+// Update the soft limit state of 'b' after its usage changed
+static void lbudget_update( lbudget *b )
+{
+  if( b->soft == 0 )
+    return;
+  if( b->used > b->soft && !b->over )
+  {
+    b->over = b->notify = 1;
+    lbudget_pending = 1;
+  }
+  else if( b->used <= b->soft && b->over )
+    b->over = 0;
+}
+
+void *lbudget_realloc( lua_State *L, void *block, size_t osize, size_t nsize )
+{
+  global_State *g = G( L );
+  lbudget *b = budgets + L->budget;
+  lbudget *ob = NULL;
+  char *raw = NULL;
+  size_t charged;
+
+  if( block )
+  {
+    raw = ( char* )block - LBUDGET_HDRSIZE;
+    ob = budgets + *( lu_byte* )raw;
+  }
+  if( nsize > 0 )
+  {
+    charged = ob == b ? osize : 0;
+    // Give the collector one chance to bring the budget back under its limit
+    if( !lbudget_fits( b, charged, nsize ) && !is_block_gc( L ) )
+      luaC_fullgc( L );
+    if( !lbudget_fits( b, charged, nsize ) )
+    {
+      b->failures ++;
+      return NULL;
+    }
+  }
+  raw = ( *g->frealloc )( g->ud, raw, block ? osize + LBUDGET_HDRSIZE : 0, nsize ? nsize + LBUDGET_HDRSIZE : 0 );
+  if( raw == NULL && nsize > 0 )
+    return NULL;
+  if( ob )
+  {
+    ob->used -= osize;
+    lbudget_update( ob );
+  }
+  if( nsize == 0 )
+    return NULL;
+  *( lu_byte* )raw = L->budget;
+  b->used += nsize;
+  if( b->used > b->peak )
+    b->peak = b->used;
+  lbudget_update( b );
+  return raw + LBUDGET_HDRSIZE;
+}
+
+// Call the soft limit callback of the budget of 'L' if it went over its soft
+// limit. This runs at the same points where a GC step can run and only in a
+// thread charged to that budget, so an error raised by the callback aborts
+// the thread that went over the limit. Notifications for other budgets stay
+// pending until one of their threads runs again.
+void lbudget_notify( lua_State *L )
+{
+  lbudget *b = budgets + L->budget;
+  const TValue *cbs, *cb;
+  int id;
+
+  if( !b->notify || is_block_gc( L ) )
+    return;
+  b->notify = 0;
+  for( id = 0, lbudget_pending = 0; id < LBUDGET_MAX; id ++ )
+    lbudget_pending |= budgets[ id ].notify;
+  cbs = luaH_getnum( hvalue( registry( L ) ), LBUDGET_CB_KEY );
+  if( !ttistable( cbs ) )
+    return;
+  cb = luaH_getnum( hvalue( cbs ), L->budget );
+  if( !ttisfunction( cb ) )
+    return;
+  setobj2s( L, L->top, cb );
+  setnvalue( L->top + 1, cast_num( L->budget ) );
+  setnvalue( L->top + 2, cast_num( b->used ) );
+  L->top += 3;
+  luaD_call( L, L->top - 3, 0 );
+}
+
+int lbudget_new( lu_mem soft, lu_mem hard )
+{
+  int id;
+
+  for( id = LBUDGET_DEFAULT + 1; id < LBUDGET_MAX; id ++ )
+    // A released budget can't be reused until all its blocks are freed
+    if( !budgets[ id ].inuse && budgets[ id ].used == 0 )
+    {
+      lbudget *b = budgets + id;
+
+      b->peak = b->failures = 0;
+      b->soft = soft;
+      b->hard = hard;
+      b->over = b->notify = 0;
+      b->inuse = 1;
+      return id;
+    }
+  return -1;
+}
+
+void lbudget_free( int id )
+{
+  lbudget *b = budgets + id;
+
+  b->inuse = 0;
+  b->soft = b->hard = 0;
+  b->over = b->notify = 0;
+}
+
+lbudget *lbudget_get( int id )
+{
+  return id >= 0 && id < LBUDGET_MAX ? budgets + id : NULL;
+}
+
+#endif // #ifdef BUILD_MEM_BUDGETS
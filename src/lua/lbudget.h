@@ -0,0 +1,34 @@
+// Lua per-thread memory budgets
+
+#ifndef __LBUDGET_H__
+#define __LBUDGET_H__
+
+#include "lstate.h"
+#include "lgc.h"
+
+// Budget 0 is the default budget: it accounts for everything not
+// explicitly assigned elsewhere and never has limits
+#define LBUDGET_DEFAULT       0
+#define LBUDGET_MAX           8
+
+// Registry key of the table holding the soft limit callbacks
+#define LBUDGET_CB_KEY        ( ( int )&lbudget_notify )
+
+typedef struct lbudget
+{
+  lu_mem used;                // bytes currently charged to this budget
+  lu_mem peak;                // highest value of 'used'
+  lu_mem soft;                // soft limit (0 for none)
+  lu_mem hard;                // hard limit (0 for none)
+  lu_int32 failures;          // allocations refused because of 'hard'
+  lu_byte inuse;              // allocated with lbudget_new
+  lu_byte over;               // 'used' is above 'soft'
+  lu_byte notify;             // soft limit callback not yet called
+} lbudget;
+
+void *lbudget_realloc( lua_State *L, void *block, size_t osize, size_t nsize );
+int lbudget_new( lu_mem soft, lu_mem hard );
+void lbudget_free( int id );
+lbudget *lbudget_get( int id );
+
+#endif
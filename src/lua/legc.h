@@ -3,7 +3,7 @@
 #ifndef __LEGC_H__
 #define __LEGC_H__
 
-#include "lstate.h"
+#include "lua.h"
 
 // EGC operations modes
 #define EGC_NOT_ACTIVE        0   // EGC disabled
@@ -22,6 +22,9 @@
 #include "ltable.h"
 #include "ltm.h"
 #include "lrotable.h"
+#ifndef LUA_CROSS_COMPILER
+#include "platform_conf.h"
+#endif
 
 #define GCSTEPSIZE	1024u
 #define GCSWEEPMAX	40
@@ -59,6 +62,42 @@
 #define setthreshold(g)  (g->GCthreshold = (g->estimate/100) * g->gcpause)
 
 
+/*
+** GC timing statistics: every `singlestep' is timestamped with the
+** system timer and accounted to the phase it ran in
+*/
+#ifdef BUILD_GC_STATS
+
+static GCStats gcstats;
+
+#define gcstats_now()   platform_timer_read_sys()
+
+static void gcstats_add (GCTimeStats *ts, timer_data_type start) {
+  lu_int32 us = cast(lu_int32, platform_timer_get_diff_us(PLATFORM_TIMER_SYS_ID,
+                                                         start, gcstats_now()));
+  lu_int32 v = us;
+  int b = 0;
+  while (v >= 2 && b < GCSTATS_BUCKETS - 1) {  /* log2 bucket */
+    v >>= 1;
+    b++;
+  }
+  ts->hist[b]++;
+  ts->count++;
+  ts->totalus += us;
+  if (us > ts->maxus) ts->maxus = us;
+}
+
+GCStats *luaC_getstats (void) {
+  return &gcstats;
+}
+
+void luaC_resetstats (void) {
+  memset(&gcstats, 0, sizeof(gcstats));
+}
+
+#endif // #ifdef BUILD_GC_STATS
+
+
 static void removeentry (Node *n) {
   lua_assert(ttisnil(gval(n)));
   if (iscollectable(gkey(n)))
@@ -433,9 +472,7 @@ static GCObject **sweeplist (lua_State *L, GCObject **p, lu_mem count) {
 static void checkSizes (lua_State *L) {
   global_State *g = G(L);
   /* check size of string hash */
-  if (g->strt.nuse < cast(lu_int32, g->strt.size/4) &&
-      g->strt.size > MINSTRTABSIZE*2)
-    luaS_resize(L, g->strt.size/2);  /* table is too big */
+  luaS_shrink(L);  /* merge some buckets if the table is too big */
   /* it is not safe to re-size the buffer if it is in use. */
   if (luaZ_bufflen(&g->buff) > 0) return;
   /* check size of buffer */
@@ -490,7 +527,7 @@ void luaC_freeall (lua_State *L) {
   g->currentwhite = WHITEBITS | bitmask(SFIXEDBIT);  /* mask to collect all elements */
   sweepwholelist(L, &g->rootgc);
   for (i = 0; i < g->strt.size; i++)  /* free all string lists */
-    sweepwholelist(L, &g->strt.hash[i]);
+    sweepwholelist(L, gstrbucket(&g->strt, i));
 }
 
 
@@ -558,7 +595,8 @@ static void atomic (lua_State *L) {
 
 static void sweepstrstep (global_State *g, lua_State *L) {
   lu_mem old = g->totalbytes;
-  sweepwholelist(L, &g->strt.hash[g->sweepstrgc++]);
+  sweepwholelist(L, gstrbucket(&g->strt, g->sweepstrgc));
+  g->sweepstrgc++;
   if (g->sweepstrgc >= g->strt.size)  /* nothing more to sweep? */
     g->gcstate = GCSsweep;  /* end sweep-string phase */
   lua_assert(old >= g->totalbytes);
@@ -566,7 +604,7 @@ static void sweepstrstep (global_State *g, lua_State *L) {
 }
 
 
-static l_mem singlestep (lua_State *L) {
+static l_mem dosinglestep (lua_State *L) {
   global_State *g = G(L);
   /*lua_checkmemory(L);*/
   switch (g->gcstate) {
@@ -607,6 +645,9 @@ static l_mem singlestep (lua_State *L) {
       else {
         g->gcstate = GCSpause;  /* end collection */
         g->gcdept = 0;
+#ifdef BUILD_GC_STATS
+        gcstats.cycles++;
+#endif
         return 0;
       }
     }
@@ -615,10 +656,26 @@ static l_mem singlestep (lua_State *L) {
 }
 
 
+#ifdef BUILD_GC_STATS
+static l_mem singlestep (lua_State *L) {
+  lu_byte phase = G(L)->gcstate;
+  timer_data_type start = gcstats_now();
+  l_mem res = dosinglestep(L);
+  gcstats_add(&gcstats.phase[phase], start);
+  return res;
+}
+#else
+#define singlestep    dosinglestep
+#endif
+
+
 void luaC_step (lua_State *L) {
   global_State *g = G(L);
   if(is_block_gc(L)) return;
   set_block_gc(L);
+#ifdef BUILD_GC_STATS
+  timer_data_type start = gcstats_now();
+#endif
   l_mem lim = (GCSTEPSIZE/100) * g->gcstepmul;
   if (lim == 0)
     lim = (MAX_LUMEM-1)/2;  /* no limit */
@@ -630,6 +687,7 @@ void luaC_step (lua_State *L) {
     if (g->gcstate == GCSpause)
       break;
   } while (lim > 0);
+  luaS_shrinkstep(L);  /* continue a shrink of the string table */
   if (g->gcstate != GCSpause) {
     if (g->gcdept < GCSTEPSIZE)
       g->GCthreshold = g->totalbytes + GCSTEPSIZE;  /* - lim/g->gcstepmul;*/
@@ -642,6 +700,9 @@ void luaC_step (lua_State *L) {
     lua_assert(g->totalbytes >= g->estimate);
     setthreshold(g);
   }
+#ifdef BUILD_GC_STATS
+  gcstats_add(&gcstats.step, start);
+#endif
   unset_block_gc(L);
 }
 
@@ -658,6 +719,9 @@ void luaC_fullgc (lua_State *L) {
   global_State *g = G(L);
   if(is_block_gc(L)) return;
   set_block_gc(L);
+#ifdef BUILD_GC_STATS
+  timer_data_type start = gcstats_now();
+#endif
   if (g->gcstate <= GCSpropagate) {
     /* reset sweep marks to sweep all elements (returning them to white) */
     g->sweepstrgc = 0;
@@ -678,7 +742,11 @@ void luaC_fullgc (lua_State *L) {
   while (g->gcstate != GCSpause) {
     singlestep(L);
   }
+  luaS_shrinkstep(L);
   setthreshold(g);
+#ifdef BUILD_GC_STATS
+  gcstats_add(&gcstats.full, start);
+#endif
   unset_block_gc(L);
 }
 
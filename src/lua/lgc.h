@@ -9,6 +9,9 @@
 
 
 #include "lobject.h"
+#ifndef LUA_CROSS_COMPILER
+#include "platform_conf.h"
+#endif
 
 
 /*
@@ -101,10 +104,19 @@
 #define fixedstack(x)	l_setbit((x)->marked, FIXEDSTACKBIT)
 #define unfixedstack(x)	resetbit((x)->marked, FIXEDSTACKBIT)
 
+#ifdef BUILD_MEM_BUDGETS
+extern lu_byte lbudget_pending;
+LUAI_FUNC void lbudget_notify (lua_State *L);
+#define luaC_checkbudget(L) { if (lbudget_pending) lbudget_notify(L); }
+#else
+#define luaC_checkbudget(L) ((void)0)
+#endif
+
 #define luaC_checkGC(L) { \
   condhardstacktests(luaD_reallocstack(L, L->stacksize - EXTRA_STACK - 1)); \
   if (G(L)->totalbytes >= G(L)->GCthreshold) \
-	luaC_step(L); }
+	luaC_step(L); \
+  luaC_checkbudget(L); }
 
 
 #define luaC_barrier(L,p,v) { if (valiswhite(v) && isblack(obj2gco(p)))  \
@@ -120,6 +132,30 @@
 #define luaC_objbarriert(L,t,o)  \
    { if (iswhite(obj2gco(o)) && isblack(obj2gco(t))) luaC_barrierback(L,t); }
 
+
+/*
+** GC timing statistics (only collected if BUILD_GC_STATS is defined)
+** Histogram bucket `i' counts samples in [2^i, 2^(i+1)) microseconds,
+** except bucket 0 which also holds samples shorter than 1us and the last
+** bucket which holds everything longer.
+*/
+#define GCSTATS_BUCKETS		12
+
+typedef struct GCTimeStats {
+  lu_int32 count;  /* number of samples */
+  lu_int32 maxus;  /* longest sample (microseconds) */
+  lua_Number totalus;  /* sum of all samples (microseconds) */
+  lu_int32 hist[GCSTATS_BUCKETS];
+} GCTimeStats;
+
+typedef struct GCStats {
+  GCTimeStats phase[GCSfinalize+1];  /* `singlestep' timings, by gcstate */
+  GCTimeStats step;  /* complete incremental steps (luaC_step) */
+  GCTimeStats full;  /* full collections (luaC_fullgc) */
+  lu_int32 cycles;  /* number of completed collection cycles */
+} GCStats;
+
+
 LUAI_FUNC size_t luaC_separateudata (lua_State *L, int all);
 LUAI_FUNC void luaC_callGCTM (lua_State *L);
 LUAI_FUNC void luaC_freeall (lua_State *L);
@@ -131,6 +167,8 @@ LUAI_FUNC void luaC_link (lua_State *L, GCObject *o, lu_byte tt);
 LUAI_FUNC void luaC_linkupval (lua_State *L, UpVal *uv);
 LUAI_FUNC void luaC_barrierf (lua_State *L, GCObject *o, GCObject *v);
 LUAI_FUNC void luaC_barrierback (lua_State *L, Table *t);
+LUAI_FUNC GCStats *luaC_getstats (void);
+LUAI_FUNC void luaC_resetstats (void);
 
 
 #endif
@@ -19,6 +19,13 @@
 #include "lualib.h"
 #include "lrotable.h"
 
+#ifndef LUA_CROSS_COMPILER
+#include "platform_conf.h"
+#ifdef BUILD_CON_TCP
+#include "elua_net.h"
+#endif
+#endif
+
 
 #define IO_INPUT	1
 #define IO_OUTPUT	2
@@ -492,13 +499,24 @@ static int f_setvbuf (lua_State *L) {
 
 
 
+static int aux_flush (lua_State *L, FILE *f) {
+  int ok = fflush(f) == 0;
+#ifdef BUILD_CON_TCP
+  /* the console over TCP keeps the output until it fills a segment */
+  if (f == stdout || f == stderr)
+    elua_net_telnet_flush();
+#endif
+  return pushresult(L, ok, NULL);
+}
+
+
 static int io_flush (lua_State *L) {
-  return pushresult(L, fflush(getiofile(L, IO_OUTPUT)) == 0, NULL);
+  return aux_flush(L, getiofile(L, IO_OUTPUT));
 }
 
 
 static int f_flush (lua_State *L) {
-  return pushresult(L, fflush(tofile(L)) == 0, NULL);
+  return aux_flush(L, tofile(L));
 }
 
 #define MIN_OPT_LEVEL 2
@@ -17,6 +17,7 @@
 #include "lmem.h"
 #include "lobject.h"
 #include "lstate.h"
+#include "lbudget.h"
 
 
 
@@ -76,7 +77,11 @@ void *luaM_toobig (lua_State *L) {
 void *luaM_realloc_ (lua_State *L, void *block, size_t osize, size_t nsize) {
   global_State *g = G(L);
   lua_assert((osize == 0) == (block == NULL));
+#ifdef BUILD_MEM_BUDGETS
+  block = lbudget_realloc(L, block, osize, nsize);
+#else
   block = (*g->frealloc)(g->ud, block, osize, nsize);
+#endif
   if (block == NULL && nsize > 0)
     luaD_throw(L, LUA_ERRMEM);
   lua_assert((nsize == 0) == (block == NULL));
@@ -75,6 +75,8 @@ int luaO_rawequalObj (const TValue *t1, const TValue *t2) {
     case LUA_TNIL:
       return 1;
     case LUA_TNUMBER:
+      if (ttisint(t1) && ttisint(t2))
+        return ivalue(t1) == ivalue(t2);
       return luai_numeq(nvalue(t1), nvalue(t2));
     case LUA_TBOOLEAN:
       return bvalue(t1) == bvalue(t2);  /* boolean true must be 1 !! */
@@ -89,6 +91,37 @@ int luaO_rawequalObj (const TValue *t1, const TValue *t2) {
 }
 
 
+#ifdef LUA_NUMBER_HYBRID
+/*
+** converts `n' to an int if it is integral and fits in an int
+*/
+int luaO_num2int (lua_Number n, int *i) {
+  int k;
+  if (!(n >= cast_num(INT_MIN) && n <= cast_num(INT_MAX)))
+    return 0;  /* out of range (or NaN) */
+  lua_number2int(k, n);
+  if (!luai_numeq(cast_num(k), n))
+    return 0;
+  *i = k;
+  return 1;
+}
+
+
+/*
+** sets `o' to `n', as an integer when possible (-0 stays a lua_Number)
+*/
+void luaO_setnum (TValue *o, lua_Number n) {
+  int k;
+  if (luaO_num2int(n, &k) && (k != 0 || luai_numlt(0, 1/n))) {
+    setivalue(o, k);
+  }
+  else {
+    setnvalue(o, n);
+  }
+}
+#endif
+
+
 int luaO_str2d (const char *s, lua_Number *result) {
   char *endptr;
   *result = lua_str2number(s, &endptr);
@@ -74,6 +74,10 @@ typedef union {
     int _pad2;
     int b;
   };
+  struct {
+    int _pad3;
+    int i;
+  };
 } Value;
 #else // #if defined( LUA_PACK_VALUE ) && defined( ELUA_ENDIAN_BIG )
 typedef union {
@@ -81,6 +85,7 @@ typedef union {
   void *p;
   lua_Number n;
   int b;
+  int i;
 } Value;
 #endif // #if defined( LUA_PACK_VALUE ) && defined( ELUA_ENDIAN_BIG )
 
@@ -158,8 +163,25 @@ typedef TValuefields TValue;
 #define ttislightfunction(o)  (ttype_sig(o) == add_sig(LUA_TLIGHTFUNCTION))
 #endif // #ifndef LUA_PACK_VALUE
 
+/*
+** Integer subtype of numbers (see LUA_NUMBER_HYBRID in luaconf.h)
+** Packed integers are NaNs with their own signature, while unpacked ones
+** keep the number tag with an extra bit set.
+*/
+#if defined( LUA_NUMBER_HYBRID ) && !defined( LUA_PACK_VALUE )
+#define LUA_TINTBIT	16
+#define ttisint(o)	((o)->tt == (LUA_TNUMBER | LUA_TINTBIT))
+#elif defined( LUA_NUMBER_HYBRID )
+#define LUA_INT_SIG	(-2)
+#define ttisint(o)	((o)->_t.sig == LUA_INT_SIG)
+#else
+#define ttisint(o)	0
+#endif
+
 /* Macros to access values */
-#ifndef LUA_PACK_VALUE
+#if defined( LUA_NUMBER_HYBRID ) && !defined( LUA_PACK_VALUE )
+#define ttype(o)	((o)->tt & (LUA_TINTBIT-1))
+#elif !defined( LUA_PACK_VALUE )
 #define ttype(o)	((o)->tt)
 #else // #ifndef LUA_PACK_VALUE
 #define ttype(o)	((o)->_t.sig == LUA_NOTNUMBER_SIG ? (o)->_t.tt : LUA_TNUMBER)
@@ -169,7 +191,14 @@ typedef TValuefields TValue;
 #define pvalue(o)	check_exp(ttislightuserdata(o), (o)->value.p)
 #define rvalue(o)	check_exp(ttisrotable(o), (o)->value.p)
 #define fvalue(o) check_exp(ttislightfunction(o), (o)->value.p)
+#ifdef LUA_NUMBER_HYBRID
+#define nvalue(o)	check_exp(ttisnumber(o), \
+  ttisint(o) ? cast_num((o)->value.i) : (o)->value.n)
+#define ivalue(o)	check_exp(ttisint(o), (o)->value.i)
+#else
 #define nvalue(o)	check_exp(ttisnumber(o), (o)->value.n)
+#define ivalue(o)	cast_int(nvalue(o))
+#endif
 #define rawtsvalue(o)	check_exp(ttisstring(o), &(o)->value.gc->ts)
 #define tsvalue(o)	(&rawtsvalue(o)->tsv)
 #define rawuvalue(o)	check_exp(ttisuserdata(o), &(o)->value.gc->u)
@@ -207,6 +236,12 @@ typedef TValuefields TValue;
 #define setnvalue(obj,x) \
   { lua_Number i_x = (x); TValue *i_o=(obj); i_o->value.n=i_x; i_o->tt=LUA_TNUMBER; }
 
+#ifdef LUA_NUMBER_HYBRID
+#define setivalue(obj,x) \
+  { int i_x = (x); TValue *i_o=(obj); i_o->value.i=i_x; \
+    i_o->tt=LUA_TNUMBER | LUA_TINTBIT; }
+#endif
+
 #define setpvalue(obj,x) \
   { void *i_x = (x); TValue *i_o=(obj); i_o->value.p=i_x; i_o->tt=LUA_TLIGHTUSERDATA; }
   
@@ -268,6 +303,11 @@ typedef TValuefields TValue;
 #define setnvalue(obj,x) \
   { TValue *i_o=(obj); i_o->value.n=(x); }
 
+#ifdef LUA_NUMBER_HYBRID
+#define setivalue(obj,x) \
+  { TValue *i_o=(obj); i_o->value.i=(x); i_o->_ts.tt_sig=0xfffe0000; }
+#endif
+
 #define setpvalue(obj,x) \
   { TValue *i_o=(obj); i_o->value.p=(x); i_o->_ts.tt_sig=add_sig(LUA_TLIGHTUSERDATA);}
 
@@ -319,6 +359,10 @@ typedef TValuefields TValue;
     checkliveness(G(L),o1); }
 #endif // #ifndef LUA_PACK_VALUE
 
+#ifndef LUA_NUMBER_HYBRID
+#define setivalue(obj,x)	setnvalue(obj, cast_num(x))
+#endif
+
 /*
 ** different types of sets, according to destination
 */
@@ -339,7 +383,7 @@ typedef TValuefields TValue;
 #define setsvalue2n	setsvalue
 
 #ifndef LUA_PACK_VALUE
-#define setttype(obj, tt) (ttype(obj) = (tt))
+#define setttype(obj, _tt) ((obj)->tt = (_tt))
 #else // #ifndef LUA_PACK_VALUE
 /* considering it used only in lgc to set LUA_TDEADKEY */
 /* we could define it this way */
@@ -541,6 +585,12 @@ LUAI_FUNC int luaO_int2fb (unsigned int x);
 LUAI_FUNC int luaO_fb2int (int x);
 LUAI_FUNC int luaO_rawequalObj (const TValue *t1, const TValue *t2);
 LUAI_FUNC int luaO_str2d (const char *s, lua_Number *result);
+#ifdef LUA_NUMBER_HYBRID
+LUAI_FUNC int luaO_num2int (lua_Number n, int *i);
+LUAI_FUNC void luaO_setnum (TValue *o, lua_Number n);
+#else
+#define luaO_setnum(o,n)	setnvalue(o,n)
+#endif
 LUAI_FUNC const char *luaO_pushvfstring (lua_State *L, const char *fmt,
                                                        va_list argp);
 LUAI_FUNC const char *luaO_pushfstring (lua_State *L, const char *fmt, ...);
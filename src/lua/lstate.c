@@ -97,6 +97,7 @@ static void preinit_state (lua_State *L, global_State *g) {
   L->hookmask = 0;
   L->basehookcount = 0;
   L->allowhook = 1;
+  L->budget = 0;
   resethookcount(L);
   L->openupval = NULL;
   L->size_ci = 0;
@@ -115,7 +116,7 @@ static void close_state (lua_State *L) {
   luaC_freeall(L);  /* collect all objects */
   lua_assert(g->rootgc == obj2gco(L));
   lua_assert(g->strt.nuse == 0);
-  luaM_freearray(L, G(L)->strt.hash, G(L)->strt.size, TString *);
+  luaS_freestrt(L);
   luaZ_freebuffer(L, &g->buff);
   freestack(L, L);
   lua_assert(g->totalbytes == sizeof(LG));
@@ -134,6 +135,7 @@ lua_State *luaE_newthread (lua_State *L) {
   L1->hookmask = L->hookmask;
   L1->basehookcount = L->basehookcount;
   L1->hook = L->hook;
+  L1->budget = L->budget;  /* coroutines inherit the budget of their creator */
   resethookcount(L1);
   lua_assert(!isdead(G(L), obj2gco(L1)));
   L->top--; /* remove thread from stack */
@@ -171,9 +173,10 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   g->uvhead.u.l.next = &g->uvhead;
   g->GCthreshold = 0;  /* mark it as unfinished state */
   g->estimate = 0;
-  g->strt.size = 0;
+  g->strt.size = g->strt.base = 0;
   g->strt.nuse = 0;
-  g->strt.hash = NULL;
+  g->strt.seg = NULL;
+  g->strt.nseg = g->strt.sizeseg = g->strt.shrink = 0;
   setnilvalue(registry(L));
   luaZ_initbuffer(L, &g->buff);
   g->panic = NULL;
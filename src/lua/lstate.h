@@ -35,12 +35,23 @@ struct lua_longjmp;  /* defined in ldo.c */
 
 
 
+/* string table buckets are allocated in segments of this many buckets */
+#define STRTAB_SEGBITS	5
+#define STRTAB_SEGSIZE	(1 << STRTAB_SEGBITS)
+
 typedef struct stringtable {
-  GCObject **hash;
+  GCObject ***seg;  /* bucket segments */
   lu_int32 nuse;  /* number of elements */
-  int size;
+  int size;  /* number of buckets in use */
+  int base;  /* size at the start of the current split round */
+  int nseg;  /* number of allocated segments */
+  int sizeseg;  /* size of `seg' */
+  int shrink;  /* buckets still to be merged by `luaS_shrinkstep' */
 } stringtable;
 
+#define gstrbucket(tb,i)	(&(tb)->seg[(i) >> STRTAB_SEGBITS] \
+				           [(i) & (STRTAB_SEGSIZE-1)])
+
 
 /*
 ** informations about a call
@@ -118,6 +129,7 @@ struct lua_State {
   unsigned short baseCcalls;  /* nested C calls when resuming coroutine */
   lu_byte hookmask;
   lu_byte allowhook;
+  lu_byte budget;  /* memory budget charged for allocations (see lbudget.h) */
   int basehookcount;
   int hookcount;
   lua_Hook hook;
@@ -20,46 +20,167 @@
 #define LUAS_READONLY_STRING      1
 #define LUAS_REGULAR_STRING       0
 
+/*
+** The string table is a linear hash table: it grows and shrinks one
+** bucket at a time by splitting (or merging) a single chain, so a resize
+** never rehashes the whole table. Buckets are kept in fixed size segments
+** (see `gstrbucket'), so growing never reallocates the bucket array either.
+*/
+
+/* maximum number of buckets split on each call */
+#define STRTAB_GROWSTEP           4
+
+/* maximum number of buckets merged on each GC step */
+#define STRTAB_SHRINKSTEP         32
+
+
+/* bucket of hash `h': use the next round size if the bucket was split */
+static int strbucket (const stringtable *tb, unsigned int h) {
+  int i = lmod(h, tb->base);
+  if (i < tb->size - tb->base)
+    i = lmod(h, 2*tb->base);
+  return i;
+}
+
+
+/* add a new bucket at the end of the table, splitting its partner chain */
+static void growstep (lua_State *L, stringtable *tb) {
+  GCObject *p, **pb;
+  int newb = tb->size;
+  if (newb >= tb->nseg * STRTAB_SEGSIZE) {  /* needs a new segment? */
+    if (tb->nseg == tb->sizeseg)
+      luaM_growvector(L, tb->seg, tb->nseg, tb->sizeseg, GCObject **,
+                      MAX_INT / STRTAB_SEGSIZE, "string table overflow");
+    tb->seg[tb->nseg] = luaM_newvector(L, STRTAB_SEGSIZE, GCObject *);
+    tb->nseg++;
+  }
+  *gstrbucket(tb, newb) = NULL;
+  if (newb == 0) {  /* first bucket */
+    tb->size = tb->base = 1;
+    return;
+  }
+  /* rehash the chain of the bucket that is split */
+  pb = gstrbucket(tb, newb - tb->base);
+  p = *pb;
+  *pb = NULL;
+  while (p) {
+    GCObject *next = p->gch.next;  /* save next */
+    GCObject **dest = lmod(gco2ts(p)->hash, 2*tb->base) == newb ?
+                      gstrbucket(tb, newb) : pb;
+    p->gch.next = *dest;  /* chain it */
+    *dest = p;
+    p = next;
+  }
+  if (++tb->size == 2*tb->base)  /* round complete? */
+    tb->base = tb->size;
+}
+
+
+/* remove the last bucket of the table, merging it back into its partner */
+static void shrinkstep (lua_State *L, stringtable *tb) {
+  GCObject *p, **pb;
+  if (tb->size == tb->base)  /* go back one round */
+    tb->base >>= 1;
+  tb->size--;
+  p = *gstrbucket(tb, tb->size);
+  pb = gstrbucket(tb, tb->size - tb->base);
+  if (p) {  /* append the chain of its partner */
+    GCObject *last = p;
+    while (last->gch.next) last = last->gch.next;
+    last->gch.next = *pb;
+    *pb = p;
+  }
+  if (tb->nseg > 1 && tb->size <= (tb->nseg - 1) * STRTAB_SEGSIZE) {
+    tb->nseg--;  /* last segment is not used anymore */
+    luaM_freearray(L, tb->seg[tb->nseg], STRTAB_SEGSIZE, GCObject *);
+  }
+}
+
+
+static int canresize (lua_State *L) {
+  /* chains cannot change while the GC traverses the string table */
+  return !luaC_sweepstrgc(L) && !is_resizing_strings_gc(L);
+}
+
+
 void luaS_resize (lua_State *L, int newsize) {
-  stringtable *tb;
-  int i;
-  tb = &G(L)->strt;
-  if (luaC_sweepstrgc(L) || newsize == tb->size || is_resizing_strings_gc(L))
-    return;  /* cannot resize during GC traverse or doesn't need to be resized */
+  stringtable *tb = &G(L)->strt;
+  if (newsize == tb->size || !canresize(L))
+    return;
   set_resizing_strings_gc(L);
-  if (newsize > tb->size) {
-    luaM_reallocvector(L, tb->hash, tb->size, newsize, GCObject *);
-    for (i=tb->size; i<newsize; i++) tb->hash[i] = NULL;
+  tb->shrink = 0;
+  while (tb->size < newsize)
+    growstep(L, tb);
+  while (tb->size > newsize)
+    shrinkstep(L, tb);
+  unset_resizing_strings_gc(L);
+}
+
+
+/*
+** called by the GC once per cycle: if the table is too sparse, plan to
+** halve it (one whole round), so it gets back to its size in a few cycles
+** after many strings were freed. The buckets are merged a few at a time
+** by `luaS_shrinkstep', on each GC step.
+*/
+void luaS_shrink (lua_State *L) {
+  stringtable *tb = &G(L)->strt;
+  if (tb->shrink > 0 || tb->nuse >= cast(lu_int32, tb->size/4) ||
+      tb->size <= MINSTRTABSIZE*2)
+    return;
+  tb->shrink = tb->size/2;
+  if (tb->size - tb->shrink < MINSTRTABSIZE*2)
+    tb->shrink = tb->size - MINSTRTABSIZE*2;
+  luaS_shrinkstep(L);
+}
+
+
+/* called by the GC on each step: merge some of the planned buckets */
+void luaS_shrinkstep (lua_State *L) {
+  stringtable *tb = &G(L)->strt;
+  int n = STRTAB_SHRINKSTEP;
+  if (tb->shrink == 0 || !canresize(L))
+    return;
+  set_resizing_strings_gc(L);
+  while (n-- && tb->shrink > 0) {
+    shrinkstep(L, tb);
+    tb->shrink--;
   }
-  /* rehash */
-  for (i=0; i<tb->size; i++) {
-    GCObject *p = tb->hash[i];
-    tb->hash[i] = NULL;
-    while (p) {  /* for each node in the list */
-      GCObject *next = p->gch.next;  /* save next */
-      unsigned int h = gco2ts(p)->hash;
-      int h1 = lmod(h, newsize);  /* new position */
-      lua_assert(cast_int(h%newsize) == lmod(h, newsize));
-      p->gch.next = tb->hash[h1];  /* chain it */
-      tb->hash[h1] = p;
-      p = next;
-    }
+  if (tb->shrink == 0 && tb->nseg < tb->sizeseg/4) {  /* vector of segments too large? */
+    luaM_reallocvector(L, tb->seg, tb->sizeseg, tb->sizeseg/2, GCObject **);
+    tb->sizeseg /= 2;
   }
-  if (newsize < tb->size)
-    luaM_reallocvector(L, tb->hash, tb->size, newsize, GCObject *);
-  tb->size = newsize;
   unset_resizing_strings_gc(L);
 }
 
+
+void luaS_freestrt (lua_State *L) {
+  stringtable *tb = &G(L)->strt;
+  int i;
+  for (i = 0; i < tb->nseg; i++)
+    luaM_freearray(L, tb->seg[i], STRTAB_SEGSIZE, GCObject *);
+  luaM_freearray(L, tb->seg, tb->sizeseg, GCObject **);
+  tb->seg = NULL;
+  tb->size = tb->base = tb->nseg = tb->sizeseg = tb->shrink = 0;
+}
+
 static TString *newlstr (lua_State *L, const char *str, size_t l,
                                        unsigned int h, int readonly) {
   TString *ts;
   stringtable *tb;
+  GCObject **bucket;
   if (l+1 > (MAX_SIZET - sizeof(TString))/sizeof(char))
     luaM_toobig(L);
   tb = &G(L)->strt;
-  if ((tb->nuse + 1) > cast(lu_int32, tb->size) && tb->size <= MAX_INT/2)
-    luaS_resize(L, tb->size*2);  /* too crowded */
+  if ((tb->nuse + 1) > cast(lu_int32, tb->size) && tb->size < MAX_INT &&
+      canresize(L)) {  /* too crowded: split a few more buckets */
+    int n = STRTAB_GROWSTEP;
+    set_resizing_strings_gc(L);
+    tb->shrink = 0;  /* the table is needed again */
+    while (n-- && (tb->nuse + 1) > cast(lu_int32, tb->size))
+      growstep(L, tb);
+    unset_resizing_strings_gc(L);
+  }
   ts = cast(TString *, luaM_malloc(L, readonly ? sizeof(char**)+sizeof(TString) : (l+1)*sizeof(char)+sizeof(TString)));
   ts->tsv.len = l;
   ts->tsv.hash = h;
@@ -72,9 +193,9 @@ static TString *newlstr (lua_State *L, const char *str, size_t l,
     *(char **)(ts+1) = (char *)str;
     luaS_readonly(ts);
   }
-  h = lmod(h, tb->size);
-  ts->tsv.next = tb->hash[h];  /* chain new entry */
-  tb->hash[h] = obj2gco(ts);
+  bucket = gstrbucket(tb, strbucket(tb, h));
+  ts->tsv.next = *bucket;  /* chain new entry */
+  *bucket = obj2gco(ts);
   tb->nuse++;
   return ts;
 }
@@ -87,7 +208,7 @@ static TString *luaS_newlstr_helper (lua_State *L, const char *str, size_t l, in
   size_t l1;
   for (l1=l; l1>=step; l1-=step)  /* compute hash */
     h = h ^ ((h<<5)+(h>>2)+cast(unsigned char, str[l1-1]));
-  for (o = G(L)->strt.hash[lmod(h, G(L)->strt.size)];
+  for (o = *gstrbucket(&G(L)->strt, strbucket(&G(L)->strt, h));
        o != NULL;
        o = o->gch.next) {
     TString *ts = rawgco2ts(o);
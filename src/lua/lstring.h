@@ -27,6 +27,9 @@
 #define luaS_isreadonly(s) testbit((s)->marked, READONLYBIT)
 
 LUAI_FUNC void luaS_resize (lua_State *L, int newsize);
+LUAI_FUNC void luaS_shrink (lua_State *L);
+LUAI_FUNC void luaS_shrinkstep (lua_State *L);
+LUAI_FUNC void luaS_freestrt (lua_State *L);
 LUAI_FUNC Udata *luaS_newudata (lua_State *L, size_t s, Table *e);
 LUAI_FUNC TString *luaS_newlstr (lua_State *L, const char *str, size_t l);
 LUAI_FUNC TString *luaS_newrolstr (lua_State *L, const char *str, size_t l);
@@ -92,6 +92,27 @@ static Node *hashnum (const Table *t, lua_Number n) {
 }
 
 
+#ifdef LUA_NUMBER_HYBRID
+/*
+** integral numbers (int or lua_Number) that fit in an int are always
+** hashed as ints, so that `3' and `3.0' end up in the same place
+*/
+#define hashint(t,i)	hashmod(t, cast(unsigned int, (i)))
+
+static Node *hashnumber (const Table *t, const TValue *key) {
+  int k;
+  if (ttisint(key))
+    return hashint(t, ivalue(key));
+  else if (luaO_num2int(nvalue(key), &k))
+    return hashint(t, k);
+  else
+    return hashnum(t, nvalue(key));
+}
+#else
+#define hashnumber(t,key)	hashnum(t, nvalue(key))
+#endif
+
+
 
 /*
 ** returns the `main' position of an element in a table (that is, the index
@@ -100,7 +121,7 @@ static Node *hashnum (const Table *t, lua_Number n) {
 static Node *mainposition (const Table *t, const TValue *key) {
   switch (ttype(key)) {
     case LUA_TNUMBER:
-      return hashnum(t, nvalue(key));
+      return hashnumber(t, key);
     case LUA_TSTRING:
       return hashstr(t, rawtsvalue(key));
     case LUA_TBOOLEAN:
@@ -120,7 +141,9 @@ static Node *mainposition (const Table *t, const TValue *key) {
 ** the array part of the table, -1 otherwise.
 */
 static int arrayindex (const TValue *key) {
-  if (ttisnumber(key)) {
+  if (ttisint(key))
+    return ivalue(key);
+  else if (ttisnumber(key)) {
     lua_Number n = nvalue(key);
     int k;
     lua_number2int(k, n);
@@ -165,7 +188,7 @@ int luaH_next (lua_State *L, Table *t, StkId key) {
   int i = findindex(L, t, key);  /* find original element */
   for (i++; i < t->sizearray; i++) {  /* try first array part */
     if (!ttisnil(&t->array[i])) {  /* a non-nil value? */
-      setnvalue(key, cast_num(i+1));
+      setivalue(key, i+1);
       setobj2s(L, key+1, &t->array[i]);
       return 1;
     }
@@ -565,6 +588,14 @@ const TValue *luaH_getnum (Table *t, int key) {
   if (cast(unsigned int, key-1) < cast(unsigned int, t->sizearray))
     return &t->array[key-1];
   else {
+#ifdef LUA_NUMBER_HYBRID
+    Node *n = hashint(t, key);
+    do {  /* check whether `key' is somewhere in the chain */
+      if (ttisint(gkey(n)) && ivalue(gkey(n)) == key)
+        return gval(n);  /* that's it */
+      else n = gnext(n);
+    } while (n);
+#else
     lua_Number nk = cast_num(key);
     Node *n = hashnum(t, nk);
     do {  /* check whether `key' is somewhere in the chain */
@@ -572,6 +603,7 @@ const TValue *luaH_getnum (Table *t, int key) {
         return gval(n);  /* that's it */
       else n = gnext(n);
     } while (n);
+#endif
     return luaO_nilobject;
   }
 }
@@ -617,7 +649,10 @@ const TValue *luaH_get (Table *t, const TValue *key) {
     case LUA_TSTRING: return luaH_getstr(t, rawtsvalue(key));
     case LUA_TNUMBER: {
       int k;
-      lua_Number n = nvalue(key);
+      lua_Number n;
+      if (ttisint(key))
+        return luaH_getnum(t, ivalue(key));
+      n = nvalue(key);
       lua_number2int(k, n);
       if (luai_numeq(cast_num(k), nvalue(key))) /* index is int? */
         return luaH_getnum(t, k);  /* use specialized version */
@@ -662,8 +697,18 @@ TValue *luaH_set (lua_State *L, Table *t, const TValue *key) {
     return cast(TValue *, p);
   else {
     if (ttisnil(key)) luaG_runerror(L, "table index is nil");
-    else if (ttisnumber(key) && luai_numisnan(nvalue(key)))
-      luaG_runerror(L, "table index is NaN");
+    else if (ttisnumber(key) && !ttisint(key)) {
+#ifdef LUA_NUMBER_HYBRID
+      TValue k;
+      int i;
+      if (luaO_num2int(nvalue(key), &i)) {  /* integral keys are kept as ints */
+        setivalue(&k, i);
+        return newkey(L, t, &k);
+      }
+#endif
+      if (luai_numisnan(nvalue(key)))
+        luaG_runerror(L, "table index is NaN");
+    }
     return newkey(L, t, key);
   }
 }
@@ -675,7 +720,7 @@ TValue *luaH_setnum (lua_State *L, Table *t, int key) {
     return cast(TValue *, p);
   else {
     TValue k;
-    setnvalue(&k, cast_num(key));
+    setivalue(&k, key);
     return newkey(L, t, &k);
   }
 }
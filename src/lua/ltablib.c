@@ -267,6 +267,20 @@ static int sort (lua_State *L) {
 /* }====================================================== */
 
 
+/*
+** Create a table with preallocated array and hash parts, so that it
+** can be filled without going through repeated rehashes.
+*/
+static int tnew (lua_State *L) {
+  int narr = luaL_optint(L, 1, 0);
+  int nrec = luaL_optint(L, 2, 0);
+  luaL_argcheck(L, narr >= 0, 1, "negative size");
+  luaL_argcheck(L, nrec >= 0, 2, "negative size");
+  lua_createtable(L, narr, nrec);
+  return 1;
+}
+
+
 #define MIN_OPT_LEVEL 1
 #include "lrodefs.h"
 const LUA_REG_TYPE tab_funcs[] = {
@@ -275,6 +289,7 @@ const LUA_REG_TYPE tab_funcs[] = {
   {LSTRKEY("foreachi"), LFUNCVAL(foreachi)},
   {LSTRKEY("getn"), LFUNCVAL(getn)},
   {LSTRKEY("maxn"), LFUNCVAL(maxn)},
+  {LSTRKEY("new"), LFUNCVAL(tnew)},
   {LSTRKEY("insert"), LFUNCVAL(tinsert)},
   {LSTRKEY("remove"), LFUNCVAL(tremove)},
   {LSTRKEY("setn"), LFUNCVAL(setn)},
@@ -372,6 +372,16 @@ struct lua_Debug {
 
 int lua_main( int argc, char **argv );
 
+/* GC timing statistics (only with BUILD_GC_STATS). The configuration is
+** included last, since the headers it includes might need this one. */
+#ifndef LUA_CROSS_COMPILER
+#include "platform_conf.h"
+#endif
+
+#ifdef BUILD_GC_STATS
+LUA_API void (lua_getgcstats) (lua_State *L, int reset);
+#endif
+
 /******************************************************************************
 * Copyright (C) 1994-2008 Lua.org, PUC-Rio.  All rights reserved.
 *
@@ -613,6 +613,23 @@
 #define lua_str2number(s,p)	strtod((s), (p))
 #endif // #if defined LUA_NUMBER_INTEGRAL
 
+/*
+@@ LUA_NUMBER_HYBRID keeps the numbers that are integral and fit in an
+@* int as integers inside the (double) Lua numbers.
+** Arithmetic, numeric for loops and table indexing then don't need
+** floating point operations as long as all the values involved are
+** integers, which is a big win on CPUs without a FPU. Integers are
+** promoted to lua_Number when needed, so the language semantics don't
+** change. Not compatible with LUA_NUMBER_INTEGRAL.
+@@ lua_int2str converts an integer number to a string.
+*/
+#if defined LUA_NUMBER_HYBRID
+#if defined LUA_NUMBER_INTEGRAL
+#error "LUA_NUMBER_HYBRID can't be used with LUA_NUMBER_INTEGRAL"
+#endif
+#define lua_int2str(s,i)	sprintf((s), "%d", (i))
+#endif
+
 /*
 @@ The luai_num* macros define the primitive operations over numbers.
 */
@@ -55,7 +55,7 @@ const TValue *luaV_tonumber (const TValue *obj, TValue *n) {
   lua_Number num;
   if (ttisnumber(obj)) return obj;
   if (ttisstring(obj) && luaO_str2d(svalue(obj), &num)) {
-    setnvalue(n, num);
+    luaO_setnum(n, num);
     return n;
   }
   else
@@ -69,8 +69,15 @@ int luaV_tostring (lua_State *L, StkId obj) {
   else {
     char s[LUAI_MAXNUMBER2STR];
     ptrdiff_t objr = savestack(L, obj);
-    lua_Number n = nvalue(obj);
-    lua_number2str(s, n);
+#ifdef LUA_NUMBER_HYBRID
+    if (ttisint(obj))
+      lua_int2str(s, ivalue(obj));
+    else
+#endif
+    {
+      lua_Number n = nvalue(obj);
+      lua_number2str(s, n);
+    }
     setsvalue2s(L, restorestack(L, objr), luaS_new(L, s));
     return 1;
   }
@@ -259,6 +266,8 @@ int luaV_lessthan (lua_State *L, const TValue *l, const TValue *r) {
   int res;
   if (ttype(l) != ttype(r))
     return luaG_ordererror(L, l, r);
+  else if (ttisint(l) && ttisint(r))
+    return ivalue(l) < ivalue(r);
   else if (ttisnumber(l))
     return luai_numlt(nvalue(l), nvalue(r));
   else if (ttisstring(l))
@@ -273,6 +282,8 @@ static int lessequal (lua_State *L, const TValue *l, const TValue *r) {
   int res;
   if (ttype(l) != ttype(r))
     return luaG_ordererror(L, l, r);
+  else if (ttisint(l) && ttisint(r))
+    return ivalue(l) <= ivalue(r);
   else if (ttisnumber(l))
     return luai_numle(nvalue(l), nvalue(r));
   else if (ttisstring(l))
@@ -290,7 +301,10 @@ int luaV_equalval (lua_State *L, const TValue *t1, const TValue *t2) {
   lua_assert(ttype(t1) == ttype(t2));
   switch (ttype(t1)) {
     case LUA_TNIL: return 1;
-    case LUA_TNUMBER: return luai_numeq(nvalue(t1), nvalue(t2));
+    case LUA_TNUMBER:
+      if (ttisint(t1) && ttisint(t2))
+        return ivalue(t1) == ivalue(t2);
+      return luai_numeq(nvalue(t1), nvalue(t2));
     case LUA_TBOOLEAN: return bvalue(t1) == bvalue(t2);  /* true must be 1 !! */
     case LUA_TLIGHTUSERDATA: 
     case LUA_TROTABLE:
@@ -359,6 +373,62 @@ void luaV_concat (lua_State *L, int total, int last) {
 }
 
 
+#ifdef LUA_NUMBER_HYBRID
+/*
+** Integer version of the arithmetic operators. Returns 0 if the result
+** is not an integer that fits in an int (or is -0), in which case the
+** operation must be done with lua_Numbers.
+*/
+static int intarith (TValue *ra, int a, int b, TMS op) {
+  int r;
+  switch (op) {
+    case TM_ADD:
+      r = cast_int(cast(unsigned int, a) + cast(unsigned int, b));
+      if (((a ^ r) & (b ^ r)) < 0) return 0;  /* overflow */
+      break;
+    case TM_SUB:
+      r = cast_int(cast(unsigned int, a) - cast(unsigned int, b));
+      if (((a ^ b) & (a ^ r)) < 0) return 0;  /* overflow */
+      break;
+    case TM_MUL: {
+      long long m = (long long)a * b;
+      r = cast_int(m);
+      if (r != m || (r == 0 && (a < 0 || b < 0))) return 0;
+      break;
+    }
+    case TM_DIV:
+      if (b == 0 || (a == INT_MIN && b == -1) || a % b != 0 ||
+          (a == 0 && b < 0))
+        return 0;
+      r = a / b;
+      break;
+    case TM_MOD:
+      if (b == 0) return 0;
+      if (b == -1)  /* avoid overflow with INT_MIN % -1 */
+        r = 0;
+      else {
+        r = a % b;
+        if (r != 0 && (r ^ b) < 0) r += b;  /* result has the sign of `b' */
+      }
+      break;
+    case TM_UNM:
+      if (a == 0 || a == INT_MIN) return 0;
+      r = -a;
+      break;
+    default:
+      return 0;
+  }
+  setivalue(ra, r);
+  return 1;
+}
+
+#define arith_int(ra,rb,rc,op) \
+  (ttisint(rb) && ttisint(rc) && intarith(ra, ivalue(rb), ivalue(rc), op))
+#else
+#define arith_int(ra,rb,rc,op)	0
+#endif
+
+
 static void Arith (lua_State *L, StkId ra, const TValue *rb,
                    const TValue *rc, TMS op) {
   TValue tempb, tempc;
@@ -415,8 +485,10 @@ static void Arith (lua_State *L, StkId ra, const TValue *rb,
         TValue *rb = RKB(i); \
         TValue *rc = RKC(i); \
         if (ttisnumber(rb) && ttisnumber(rc)) { \
-          lua_Number nb = nvalue(rb), nc = nvalue(rc); \
-          setnvalue(ra, op(nb, nc)); \
+          if (!arith_int(ra, rb, rc, tm)) { \
+            lua_Number nb = nvalue(rb), nc = nvalue(rc); \
+            setnvalue(ra, op(nb, nc)); \
+          } \
         } \
         else \
           Protect(Arith(L, ra, rb, rc, tm)); \
@@ -550,8 +622,10 @@ void luaV_execute (lua_State *L, int nexeccalls) {
       case OP_UNM: {
         TValue *rb = RB(i);
         if (ttisnumber(rb)) {
-          lua_Number nb = nvalue(rb);
-          setnvalue(ra, luai_numunm(nb));
+          if (!arith_int(ra, rb, rb, TM_UNM)) {
+            lua_Number nb = nvalue(rb);
+            setnvalue(ra, luai_numunm(nb));
+          }
         }
         else {
           Protect(Arith(L, ra, rb, rb, TM_UNM));
@@ -568,11 +642,11 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         switch (ttype(rb)) {
           case LUA_TTABLE: 
           case LUA_TROTABLE: {
-            setnvalue(ra, ttistable(rb) ? cast_num(luaH_getn(hvalue(rb))) : cast_num(luaH_getn_ro(rvalue(rb))));
+            setivalue(ra, ttistable(rb) ? luaH_getn(hvalue(rb)) : luaH_getn_ro(rvalue(rb)));
             break;
           }
           case LUA_TSTRING: {
-            setnvalue(ra, cast_num(tsvalue(rb)->len));
+            setivalue(ra, cast_int(tsvalue(rb)->len));
             break;
           }
           default: {  /* try metamethod */
@@ -706,6 +780,19 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         }
       }
       case OP_FORLOOP: {
+#ifdef LUA_NUMBER_HYBRID
+        if (ttisint(ra)) {  /* integer loop (see OP_FORPREP) */
+          int step = ivalue(ra+2);
+          long long idx = (long long)ivalue(ra) + step;
+          int limit = ivalue(ra+1);
+          if (0 < step ? idx <= limit : limit <= idx) {
+            dojump(L, pc, GETARG_sBx(i));  /* jump back */
+            setivalue(ra, cast_int(idx));  /* update internal index... */
+            setivalue(ra+3, cast_int(idx));  /* ...and external index */
+          }
+          continue;
+        }
+#endif
         lua_Number step = nvalue(ra+2);
         lua_Number idx = luai_numadd(nvalue(ra), step); /* increment index */
         lua_Number limit = nvalue(ra+1);
@@ -728,6 +815,17 @@ void luaV_execute (lua_State *L, int nexeccalls) {
           luaG_runerror(L, LUA_QL("for") " limit must be a number");
         else if (!tonumber(pstep, ra+2))
           luaG_runerror(L, LUA_QL("for") " step must be a number");
+#ifdef LUA_NUMBER_HYBRID
+        /* the loop runs with ints only if all its control values are ints */
+        if (ttisint(ra) && ttisint(plimit) && ttisint(pstep)) {
+          long long start = (long long)ivalue(ra) - ivalue(pstep);
+          if (start == cast_int(start)) {
+            setivalue(ra, cast_int(start));
+            dojump(L, pc, GETARG_sBx(i));
+            continue;
+          }
+        }
+#endif
         setnvalue(ra, luai_numsub(nvalue(ra), nvalue(pstep)));
         dojump(L, pc, GETARG_sBx(i));
         continue;
@@ -12,6 +12,10 @@
 
 #ifdef BUILD_ADC
 
+// Limits of the filter stages
+#define ADC_FILTER_MAX_STAGES     8
+#define ADC_FILTER_MAX_TAPS       256
+
 // Lua: data = maxval( id )
 static int adc_maxval( lua_State* L )
 {
@@ -104,6 +108,10 @@ static int adc_sample( lua_State* L )
   count = luaL_checkinteger( L, 2 );
   if  ( ( count == 0 ) || count & ( count - 1 ) )
     return luaL_error( L, "count must be power of 2 and > 0" );
+#ifdef PLATFORM_HAS_ADC_STREAM
+  if( adc_stream_is_active() )
+    return luaL_error( L, "continuous acquisition in progress" );
+#endif
   
   // If first parameter is a table, extract channel list
   if ( lua_istable( L, 1 ) == 1 )
@@ -160,12 +168,113 @@ static int adc_getsample( lua_State* L )
   return 0;
 }
 
+// Helper: check the coefficients of a filter stage (at the top of the stack)
+static void adch_check_coefs( lua_State *L, unsigned n )
+{
+  unsigned k;
+  lua_Integer v;
+
+  for( k = 2; k <= n; k ++ )
+  {
+    lua_rawgeti( L, -1, k );
+    if( !lua_isnumber( L, -1 ) )
+      luaL_error( L, "invalid filter coefficient" );
+    v = lua_tointeger( L, -1 );
+    if( v < -32768 || v > 32767 )
+      luaL_error( L, "filter coefficient out of range" );
+    lua_pop( L, 1 );
+  }
+}
+
+// Lua: setfilter( id, [stages] )
+// Each stage is { adc.FIR, c0, c1, ... }, { adc.IIR, b0, b1, b2, a1, a2 } or
+// { adc.DECIMATE, n }
+static int adc_setfilter( lua_State* L )
+{
+  unsigned id, nstages = 0, i, k, n;
+  u8 types[ ADC_FILTER_MAX_STAGES ];
+  unsigned lens[ ADC_FILTER_MAX_STAGES ];
+  elua_adc_filter *f = NULL;
+
+  id = luaL_checkinteger( L, 1 );
+  MOD_CHECK_ID( adc, id );
+  if( !lua_isnoneornil( L, 2 ) )
+  {
+    luaL_checktype( L, 2, LUA_TTABLE );
+    if( ( nstages = lua_objlen( L, 2 ) ) > ADC_FILTER_MAX_STAGES )
+      return luaL_error( L, "too many filter stages" );
+  }
+
+  // Check all the stages before allocating the filter
+  for( i = 0; i < nstages; i ++ )
+  {
+    lua_rawgeti( L, 2, i + 1 );
+    if( !lua_istable( L, -1 ) )
+      return luaL_error( L, "invalid filter stage" );
+    n = lua_objlen( L, -1 );
+    lua_rawgeti( L, -1, 1 );
+    types[ i ] = lua_isnumber( L, -1 ) ? ( u8 )lua_tointeger( L, -1 ) : 0xFF;
+    lua_pop( L, 1 );
+    switch( types[ i ] )
+    {
+      case ADC_FILTER_FIR:
+        if( n < 2 || n - 1 > ADC_FILTER_MAX_TAPS )
+          return luaL_error( L, "invalid number of FIR coefficients" );
+        lens[ i ] = n - 1;
+        adch_check_coefs( L, n );
+        break;
+
+      case ADC_FILTER_IIR:
+        if( n != ADC_FILTER_IIR_NUM_COEFS + 1 )
+          return luaL_error( L, "an IIR stage needs %d coefficients", ADC_FILTER_IIR_NUM_COEFS );
+        lens[ i ] = 0;
+        adch_check_coefs( L, n );
+        break;
+
+      case ADC_FILTER_DECIMATE:
+        lua_rawgeti( L, -1, 2 );
+        lens[ i ] = lua_isnumber( L, -1 ) ? ( unsigned )lua_tointeger( L, -1 ) : 0;
+        lua_pop( L, 1 );
+        if( lens[ i ] == 0 || lens[ i ] > 0xFFFF )
+          return luaL_error( L, "invalid decimation factor" );
+        break;
+
+      default:
+        return luaL_error( L, "invalid filter stage type" );
+    }
+    lua_pop( L, 1 );
+  }
+
+  if( nstages > 0 )
+  {
+    if( ( f = adc_alloc_filter( id, nstages, types, lens ) ) == NULL )
+      return luaL_error( L, "not enough memory" );
+    for( i = 0; i < nstages; i ++ )
+    {
+      if( types[ i ] == ADC_FILTER_DECIMATE )
+        continue;
+      lua_rawgeti( L, 2, i + 1 );
+      n = lua_objlen( L, -1 );
+      for( k = 2; k <= n; k ++ )
+      {
+        lua_rawgeti( L, -1, k );
+        f->stages[ i ].coefs[ k - 2 ] = ( s16 )lua_tointeger( L, -1 );
+        lua_pop( L, 1 );
+      }
+      lua_pop( L, 1 );
+    }
+  }
+  adc_set_filter( id, f );
+  return 0;
+}
+
 #if defined( BUF_ENABLE_ADC )
-// Lua: table_of_vals = getsamples( id, [count] )
+// Lua: table_of_vals = getsamples( id, [count], [array_type] )
 static int adc_getsamples( lua_State* L )
 {
   unsigned id, i;
   u16 bcnt, count = 0;
+  array_t *pa;
   
   id = luaL_checkinteger( L, 1 );
   MOD_CHECK_ID( adc, id );
@@ -183,6 +292,15 @@ static int adc_getsamples( lua_State* L )
   if ( count > bcnt )
     count = bcnt;
   
+  // Return a packed array instead of a table if a type was given
+  if ( lua_isnumber( L, 3 ) )
+  {
+    pa = array_push( L, count, lua_tointeger( L, 3 ) );
+    for( i = 0; i < count; i ++ )
+      array_setint( pa, i, adc_get_processed_sample( id ) );
+    return 1;
+  }
+
   lua_createtable( L, count, 0 );
   for( i = 1; i <= count; i ++ )
   {
@@ -192,17 +310,21 @@ static int adc_getsamples( lua_State* L )
   return 1;
 }
 
-
 // Lua: insertsamples(id, table, idx, count)
+//      insertsamples(id, array, idx, count)
 static int adc_insertsamples( lua_State* L )
 {
   unsigned id, i, startidx;
   u16 bcnt, count;
+  array_t *pa = NULL;
   
   id = luaL_checkinteger( L, 1 );
   MOD_CHECK_ID( adc, id );
   
-  luaL_checktype(L, 2, LUA_TTABLE);
+  if( array_isarray( L, 2 ) )
+    pa = array_check( L, 2 );
+  else
+    luaL_checktype(L, 2, LUA_TTABLE);
   
   startidx = luaL_checkinteger( L, 3 );
   if  ( startidx <= 0 )
@@ -211,11 +333,19 @@ static int adc_insertsamples( lua_State* L )
   count = luaL_checkinteger(L, 4 );
   if  ( count == 0 )
     return luaL_error( L, "count must be > 0" );
+  if ( pa && startidx + count - 1 > array_getlen( pa ) )
+    return luaL_error( L, "array too small" );
   
   bcnt = adc_wait_samples( id, count );
   
   for( i = startidx; i < ( count + startidx ); i ++ )
   {
+    if( pa )
+    {
+      // arrays can't hold nil, zero out values where we don't have enough samples
+      array_setint( pa, i - 1, i < bcnt + startidx ? adc_get_processed_sample( id ) : 0 );
+      continue;
+    }
     if ( i < bcnt + startidx )
       lua_pushinteger( L, adc_get_processed_sample( id ) );
     else
@@ -228,6 +358,76 @@ static int adc_insertsamples( lua_State* L )
 }
 #endif
 
+#ifdef PLATFORM_HAS_ADC_STREAM
+// Lua: startstream( id | ids, frames )
+static int adc_startstream( lua_State* L )
+{
+  unsigned id, i;
+  lua_Integer frames;
+  u32 chmask = 0;
+
+  if( lua_istable( L, 1 ) )
+  {
+    for( i = 1; i <= lua_objlen( L, 1 ); i ++ )
+    {
+      lua_rawgeti( L, 1, i );
+      id = luaL_checkinteger( L, -1 );
+      MOD_CHECK_ID( adc, id );
+      chmask |= ( u32 )1 << id;
+      lua_pop( L, 1 );
+    }
+  }
+  else
+  {
+    id = luaL_checkinteger( L, 1 );
+    MOD_CHECK_ID( adc, id );
+    chmask = ( u32 )1 << id;
+  }
+  frames = luaL_checkinteger( L, 2 );
+  if( frames < 1 || frames > ADC_STREAM_MAX_FRAMES )
+    return luaL_argerror( L, 2, "invalid number of frames" );
+  if( chmask == 0 )
+    return luaL_error( L, "invalid arguments" );
+  if( adc_stream_start( chmask, frames ) != PLATFORM_OK )
+    return luaL_error( L, "unable to start the acquisition" );
+  return 0;
+}
+
+// Lua: stopstream()
+static int adc_stopstream( lua_State* L )
+{
+  adc_stream_stop();
+  return 0;
+}
+
+// Lua: data, lost = getsamples_packed( [timeout] )
+static int adc_getsamples_packed( lua_State* L )
+{
+  timer_data_type timeout = PLATFORM_TIMER_INF_TIMEOUT;
+  const u16 *pdata;
+
+  if( lua_isnumber( L, 1 ) )
+    timeout = ( timer_data_type )lua_tonumber( L, 1 );
+  if( !adc_stream_is_active() )
+    return luaL_error( L, "continuous acquisition not started" );
+  // Retry with a newer half if this one was overwritten during the copy
+  while( 1 )
+  {
+    if( ( pdata = adc_stream_get_half( timeout ) ) == NULL )
+    {
+      lua_pushnil( L );
+      break;
+    }
+    lua_pushlstring( L, ( const char* )pdata, adc_stream_get_half_len() * sizeof( u16 ) );
+    if( adc_stream_release_half() == PLATFORM_OK )
+      break;
+    lua_pop( L, 1 );
+  }
+  lua_pushinteger( L, adc_stream_get_lost() );
+  return 2;
+}
+#endif // #ifdef PLATFORM_HAS_ADC_STREAM
+
 // Module function map
 #define MIN_OPT_LEVEL 2
 #include "lrodefs.h"
@@ -239,17 +439,39 @@ const LUA_REG_TYPE adc_map[] =
   { LSTRKEY( "isdone" ), LFUNCVAL( adc_isdone ) },
   { LSTRKEY( "setblocking" ), LFUNCVAL( adc_setblocking ) },
   { LSTRKEY( "setsmoothing" ), LFUNCVAL( adc_setsmoothing ) },
+  { LSTRKEY( "setfilter" ), LFUNCVAL( adc_setfilter ) },
   { LSTRKEY( "getsample" ), LFUNCVAL( adc_getsample ) },
 #if defined( BUF_ENABLE_ADC )
   { LSTRKEY( "getsamples" ), LFUNCVAL( adc_getsamples ) },
   { LSTRKEY( "insertsamples" ), LFUNCVAL( adc_insertsamples ) },
+#endif
+#ifdef PLATFORM_HAS_ADC_STREAM
+  { LSTRKEY( "startstream" ), LFUNCVAL( adc_startstream ) },
+  { LSTRKEY( "stopstream" ), LFUNCVAL( adc_stopstream ) },
+  { LSTRKEY( "getsamples_packed" ), LFUNCVAL( adc_getsamples_packed ) },
+#endif
+#if LUA_OPTIMIZE_MEMORY > 0
+  { LSTRKEY( "FIR" ), LNUMVAL( ADC_FILTER_FIR ) },
+  { LSTRKEY( "IIR" ), LNUMVAL( ADC_FILTER_IIR ) },
+  { LSTRKEY( "DECIMATE" ), LNUMVAL( ADC_FILTER_DECIMATE ) },
 #endif
   { LNILKEY, LNILVAL }
 };
 
 LUALIB_API int luaopen_adc( lua_State *L )
 {
-  LREGISTER( L, AUXLIB_ADC, adc_map );
+#if LUA_OPTIMIZE_MEMORY > 0
+  return 0;
+#else // #if LUA_OPTIMIZE_MEMORY > 0
+  luaL_register( L, AUXLIB_ADC, adc_map );
+
+  // Module constants
+  MOD_REG_NUMBER( L, "FIR", ADC_FILTER_FIR );
+  MOD_REG_NUMBER( L, "IIR", ADC_FILTER_IIR );
+  MOD_REG_NUMBER( L, "DECIMATE", ADC_FILTER_DECIMATE );
+
+  return 1;
+#endif // #if LUA_OPTIMIZE_MEMORY > 0
 }
 
 #endif
@@ -0,0 +1,295 @@
+// Module that implements fixed size packed numeric arrays
+
+#include "lua.h"
+#include "lualib.h"
+#include "lauxlib.h"
+#include "type.h"
+#include "auxmods.h"
+#include "lrotable.h"
+#include "llimits.h"
+#include <string.h>
+
+#define META_NAME                 "eLua.array"
+#define array_check_self( L )     array_check( L, 1 )
+
+// Structure that describes our array
+struct array_t
+{
+  u32 len;
+  u8 type;
+  union
+  {
+    u8 u8[ 1 ];
+    u16 u16[ 1 ];
+    s32 s32[ 1 ];
+    float f[ 1 ];
+  } v;
+};
+
+static const u8 array_elsize[] = { 1, 2, 4, 4 };
+
+// Largest number of elements of the given type (the size of the block can't overflow)
+#define ARRAY_MAX_LEN( type )     ( ( MAX_SIZET - sizeof( array_t ) ) / array_elsize[ type ] )
+
+static void arrayh_push_meta( lua_State *L );
+
+// Helper: push a new array on the stack
+array_t* array_push( lua_State *L, u32 len, int type )
+{
+  array_t *pa;
+
+  if( type < ARRAY_U8 || type > ARRAY_FLOAT )
+    luaL_error( L, "invalid array type" );
+  if( len > ARRAY_MAX_LEN( type ) )
+    luaL_error( L, "array too large" );
+  pa = ( array_t* )lua_newuserdata( L, sizeof( array_t ) + len * array_elsize[ type ] );
+  pa->len = len;
+  pa->type = type;
+  memset( &pa->v, 0, len * array_elsize[ type ] );
+  arrayh_push_meta( L );
+  lua_setmetatable( L, -2 );
+  return pa;
+}
+
+// Helper: return the array at the given stack index or raise an error
+array_t* array_check( lua_State *L, int stackid )
+{
+  return ( array_t* )luaL_checkudata( L, stackid, META_NAME );
+}
+
+// Helper: check if the value at the given stack index is an array
+int array_isarray( lua_State *L, int stackid )
+{
+  int res = 0;
+
+  if( lua_touserdata( L, stackid ) && lua_getmetatable( L, stackid ) )
+  {
+    lua_getfield( L, LUA_REGISTRYINDEX, META_NAME );
+    res = lua_rawequal( L, -1, -2 );
+    lua_pop( L, 2 );
+  }
+  return res;
+}
+
+u32 array_getlen( array_t *pa )
+{
+  return pa->len;
+}
+
+int array_gettype( array_t *pa )
+{
+  return pa->type;
+}
+
+// Helper: return a pointer to the packed elements of the array
+void* array_getdata( array_t *pa )
+{
+  return &pa->v;
+}
+
+// Helper: set the value of an element (0-based index) from an integer
+void array_setint( array_t *pa, u32 idx, s32 val )
+{
+  switch( pa->type )
+  {
+    case ARRAY_U8:
+      pa->v.u8[ idx ] = ( u8 )val;
+      break;
+
+    case ARRAY_U16:
+      pa->v.u16[ idx ] = ( u16 )val;
+      break;
+
+    case ARRAY_S32:
+      pa->v.s32[ idx ] = val;
+      break;
+
+    case ARRAY_FLOAT:
+      pa->v.f[ idx ] = ( float )val;
+      break;
+  }
+}
+
+// Helper: set the value of an element (0-based index) from a number
+static void array_setnum( array_t *pa, u32 idx, lua_Number val )
+{
+  if( pa->type == ARRAY_FLOAT )
+    pa->v.f[ idx ] = ( float )val;
+  else
+    array_setint( pa, idx, ( s32 )val );
+}
+
+// Helper: push the value of an element (0-based index)
+static void array_pushval( lua_State *L, array_t *pa, u32 idx )
+{
+  switch( pa->type )
+  {
+    case ARRAY_U8:
+      lua_pushinteger( L, pa->v.u8[ idx ] );
+      break;
+
+    case ARRAY_U16:
+      lua_pushinteger( L, pa->v.u16[ idx ] );
+      break;
+
+    case ARRAY_S32:
+      lua_pushinteger( L, pa->v.s32[ idx ] );
+      break;
+
+    case ARRAY_FLOAT:
+      lua_pushnumber( L, ( lua_Number )pa->v.f[ idx ] );
+      break;
+  }
+}
+
+// Helper: check an 1-based index and return it as a 0-based index
+static u32 array_checkindex( lua_State *L, array_t *pa, int stackid )
+{
+  u32 idx = ( u32 )luaL_checkinteger( L, stackid );
+
+  if( ( idx <= 0 ) || ( idx > pa->len ) )
+    luaL_error( L, "invalid index." );
+  return idx - 1;
+}
+
+// Lua: array = array.new( capacity, [type], [fill] ), or
+//      array = array.new( lua_array, [type] )
+static int array_new( lua_State *L )
+{
+  int type = luaL_optinteger( L, 2, ARRAY_S32 );
+  array_t *pa;
+  lua_Integer n;
+  u32 i, len;
+
+  if( type < ARRAY_U8 || type > ARRAY_FLOAT )
+    return luaL_argerror( L, 2, "invalid array type" );
+  if( lua_istable( L, 1 ) || lua_isrotable( L, 1 ) )
+  {
+    len = lua_objlen( L, 1 );
+    pa = array_push( L, len, type );
+    for( i = 0; i < len; i ++ )
+    {
+      lua_rawgeti( L, 1, i + 1 );
+      array_setnum( pa, i, lua_tonumber( L, -1 ) );
+      lua_pop( L, 1 );
+    }
+  }
+  else
+  {
+    n = luaL_checkinteger( L, 1 );
+    if( n < 0 || ( size_t )n > ARRAY_MAX_LEN( type ) || ( size_t )n != ( u32 )n )
+      return luaL_argerror( L, 1, "invalid array size" );
+    len = ( u32 )n;
+    pa = array_push( L, len, type );
+    if( lua_isnumber( L, 3 ) )
+      for( i = 0; i < len; i ++ )
+        array_setnum( pa, i, lua_tonumber( L, 3 ) );
+  }
+  return 1;
+}
+
+// Lua: value = array[ idx ]
+static int array_get( lua_State *L )
+{
+  array_t *pa = array_check_self( L );
+
+  array_pushval( L, pa, array_checkindex( L, pa, 2 ) );
+  return 1;
+}
+
+// Lua: array[ idx ] = value
+static int array_set( lua_State *L )
+{
+  array_t *pa = array_check_self( L );
+
+  array_setnum( pa, array_checkindex( L, pa, 2 ), luaL_checknumber( L, 3 ) );
+  return 0;
+}
+
+// Lua: size = #array
+static int array_len( lua_State *L )
+{
+  lua_pushinteger( L, array_check_self( L )->len );
+  return 1;
+}
+
+// Lua: table = array.totable( array, [first], [last] )
+static int array_totable( lua_State *L )
+{
+  array_t *pa = array_check_self( L );
+  u32 first = ( u32 )luaL_optinteger( L, 2, 1 );
+  u32 last = ( u32 )luaL_optinteger( L, 3, pa->len );
+  u32 i;
+
+  if( first < 1 || last > pa->len )
+    return luaL_error( L, "invalid index." );
+  lua_createtable( L, last >= first ? last - first + 1 : 0, 0 );
+  for( i = first; i <= last; i ++ )
+  {
+    array_pushval( L, pa, i - 1 );
+    lua_rawseti( L, -2, i - first + 1 );
+  }
+  return 1;
+}
+
+// Lua: string = array.tostring( array )
+static int array_tostring( lua_State *L )
+{
+  array_t *pa = array_check_self( L );
+
+  lua_pushlstring( L, ( const char* )&pa->v, pa->len * array_elsize[ pa->type ] );
+  return 1;
+}
+
+// Module function map
+#define MIN_OPT_LEVEL 2
+#include "lrodefs.h"
+const LUA_REG_TYPE array_map[] =
+{
+  { LSTRKEY( "new" ), LFUNCVAL( array_new ) },
+  { LSTRKEY( "totable" ), LFUNCVAL( array_totable ) },
+  { LSTRKEY( "tostring" ), LFUNCVAL( array_tostring ) },
+#if LUA_OPTIMIZE_MEMORY > 0
+  { LSTRKEY( "U8" ), LNUMVAL( ARRAY_U8 ) },
+  { LSTRKEY( "U16" ), LNUMVAL( ARRAY_U16 ) },
+  { LSTRKEY( "S32" ), LNUMVAL( ARRAY_S32 ) },
+  { LSTRKEY( "FLOAT" ), LNUMVAL( ARRAY_FLOAT ) },
+#endif
+  { LNILKEY, LNILVAL }
+};
+
+static const LUA_REG_TYPE array_mt_map[] =
+{
+  { LSTRKEY( "__index" ), LFUNCVAL( array_get ) },
+  { LSTRKEY( "__newindex" ), LFUNCVAL( array_set ) },
+  { LSTRKEY( "__len" ), LFUNCVAL( array_len ) },
+  { LNILKEY, LNILVAL }
+};
+
+// Helper: push the metatable of the arrays, creating it if needed. Other
+// modules (pio, adc) return arrays even if the array module is not enabled.
+static void arrayh_push_meta( lua_State *L )
+{
+#if LUA_OPTIMIZE_MEMORY > 0
+  luaL_rometatable( L, META_NAME, ( void* )array_mt_map );
+#else // #if LUA_OPTIMIZE_MEMORY > 0
+  if( luaL_newmetatable( L, META_NAME ) )
+    luaL_register( L, NULL, array_mt_map );
+#endif // #if LUA_OPTIMIZE_MEMORY > 0
+}
+
+LUALIB_API int luaopen_array( lua_State* L )
+{
+#if LUA_OPTIMIZE_MEMORY > 0
+  arrayh_push_meta( L );
+  return 0;
+#else // #if LUA_OPTIMIZE_MEMORY > 0
+  arrayh_push_meta( L );
+  luaL_register( L, AUXLIB_ARRAY, array_map );
+  MOD_REG_NUMBER( L, "U8", ARRAY_U8 );
+  MOD_REG_NUMBER( L, "U16", ARRAY_U16 );
+  MOD_REG_NUMBER( L, "S32", ARRAY_S32 );
+  MOD_REG_NUMBER( L, "FLOAT", ARRAY_FLOAT );
+  return 1;
+#endif // #if LUA_OPTIMIZE_MEMORY > 0
+}
@@ -6,6 +6,7 @@
 #define __AUXMODS_H__
 
 #include "lua.h"
+#include "type.h"
 
 #define AUXLIB_PIO      "pio"
 LUALIB_API int ( luaopen_pio )( lua_State *L );
@@ -40,6 +41,9 @@ LUALIB_API int ( luaopen_bit )( lua_State *L );
 #define AUXLIB_NET      "net"
 LUALIB_API int ( luaopen_net )( lua_State *L );
 
+#define AUXLIB_HTTPD    "httpd"
+LUALIB_API int ( luaopen_httpd )( lua_State *L );
+
 #define AUXLIB_CPU      "cpu"
 LUALIB_API int ( luaopen_cpu )( lua_State* L );
 
@@ -58,6 +62,28 @@ LUALIB_API int ( luaopen_elua )( lua_State *L );
 #define AUXLIB_I2C  "i2c"
 LUALIB_API int ( luaopen_i2c )( lua_State *L );
 
+#define AUXLIB_ARRAY "array"
+LUALIB_API int ( luaopen_array )( lua_State *L );
+
+// Packed array element types and helpers for modules that fill arrays in bulk
+enum
+{
+  ARRAY_U8 = 0,
+  ARRAY_U16,
+  ARRAY_S32,
+  ARRAY_FLOAT
+};
+
+typedef struct array_t array_t;
+
+array_t* array_push( lua_State *L, u32 len, int type );
+array_t* array_check( lua_State *L, int stackid );
+int array_isarray( lua_State *L, int stackid );
+u32 array_getlen( array_t *pa );
+int array_gettype( array_t *pa );
+void* array_getdata( array_t *pa );
+void array_setint( array_t *pa, u32 idx, s32 val );
+
 // Helper macros
 #define MOD_CHECK_ID( mod, id )\
   if( !platform_ ## mod ## _exists( id ) )\
@@ -52,14 +52,14 @@ typedef size_t lua_UInteger;
 #define LOGICAL_SHIFT(name, op)                                         \
   static int bit_ ## name(lua_State *L) {                               \
     lua_pushinteger(L, (lua_UInteger)TOBIT(L, 1) op                     \
-                          (unsigned)luaL_checknumber(L, 2));            \
+                          (unsigned)luaL_checkinteger(L, 2));           \
     return 1;                                                           \
   }
 
 #define ARITHMETIC_SHIFT(name, op)                                      \
   static int bit_ ## name(lua_State *L) {                               \
     lua_pushinteger(L, (lua_Integer)TOBIT(L, 1) op                      \
-                          (unsigned)luaL_checknumber(L, 2));            \
+                          (unsigned)luaL_checkinteger(L, 2));           \
     return 1;                                                           \
   }
 
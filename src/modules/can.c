@@ -6,6 +6,9 @@
 #include "platform.h"
 #include "auxmods.h"
 #include "lrotable.h"
+#include "platform_conf.h"
+#include "common.h"
+#include "buf.h"
 
 // Lua: result = setup( id, clock )
 static int can_setup( lua_State* L )
@@ -67,6 +70,90 @@ static int can_recv( lua_State* L )
     return 0;
 }
 
+// Lua: frames = recvall( id, [max] )
+// Returns an array of { canid, canidtype, message } entries (possibly empty)
+static int can_recvall( lua_State* L )
+{
+  u8 len;
+  unsigned id;
+  u32 canid, max, n = 0;
+  u8  idtype, data[ PLATFORM_CAN_MAXLEN ];
+
+  id = luaL_checkinteger( L, 1 );
+  MOD_CHECK_ID( can, id );
+  max = ( u32 )luaL_optinteger( L, 2, 0 );
+
+  lua_newtable( L );
+  while( ( max == 0 || n < max ) && platform_can_recv( id, &canid, &idtype, &len, data ) == PLATFORM_OK )
+  {
+    lua_createtable( L, 3, 0 );
+    lua_pushinteger( L, canid );
+    lua_rawseti( L, -2, 1 );
+    lua_pushinteger( L, idtype );
+    lua_rawseti( L, -2, 2 );
+    lua_pushlstring( L, ( const char * )data, ( size_t )len );
+    lua_rawseti( L, -2, 3 );
+    lua_rawseti( L, -2, ++ n );
+  }
+  return 1;
+}
+
+// Largest receive buffer (in messages)
+#define CAN_MAX_BUF_SIZE        ( 1 << BUF_SIZE_32768 )
+
+// Lua: set_buffer( id, [size] )
+// Buffering is disabled if 'size' is not given
+static int can_set_buffer( lua_State* L )
+{
+  unsigned id = luaL_checkinteger( L, 1 );
+  lua_Integer size = 0;
+
+  MOD_CHECK_ID( can, id );
+  if( !lua_isnoneornil( L, 2 ) )
+  {
+    size = luaL_checkinteger( L, 2 );
+    if( size < 2 || size > CAN_MAX_BUF_SIZE || ( size & ( size - 1 ) ) )
+      return luaL_argerror( L, 2, "the buffer size must be a power of 2 between 2 and 32768" );
+  }
+  if( platform_can_set_buffer( id, size ? intlog2( ( u32 )size ) : 0 ) == PLATFORM_ERR )
+    return luaL_error( L, "unable to set CAN buffer" );
+  return 0;
+}
+
+// Lua: set_filter( id, idx, canid, mask, canidtype )
+static int can_set_filter( lua_State* L )
+{
+  unsigned id = luaL_checkinteger( L, 1 );
+  unsigned idx = luaL_checkinteger( L, 2 );
+  u32 canid = ( u32 )luaL_checkinteger( L, 3 );
+  u32 mask = ( u32 )luaL_checkinteger( L, 4 );
+  int idtype = luaL_checkinteger( L, 5 );
+
+  MOD_CHECK_ID( can, id );
+  if( idtype != ELUA_CAN_ID_STD && idtype != ELUA_CAN_ID_EXT )
+    return luaL_error( L, "invalid CAN ID type" );
+  if( platform_can_set_filter( id, idx, canid, mask, idtype ) == PLATFORM_ERR )
+    return luaL_error( L, "unable to set CAN filter %d", idx );
+  return 0;
+}
+
+// Lua: clear_filter( id, [idx] )
+// Without an index all the filters are cleared
+static int can_clear_filter( lua_State* L )
+{
+  unsigned id = luaL_checkinteger( L, 1 );
+  unsigned i;
+
+  MOD_CHECK_ID( can, id );
+  if( lua_isnoneornil( L, 2 ) )
+  {
+    for( i = 0; i < PLATFORM_CAN_NUM_FILTERS; i ++ )
+      platform_can_clear_filter( id, i );
+  }
+  else if( platform_can_clear_filter( id, luaL_checkinteger( L, 2 ) ) == PLATFORM_ERR )
+    return luaL_error( L, "invalid CAN filter" );
+  return 0;
+}
 
 // Module function map
 #define MIN_OPT_LEVEL 2
@@ -76,9 +163,14 @@ const LUA_REG_TYPE can_map[] =
   { LSTRKEY( "setup" ),  LFUNCVAL( can_setup ) },
   { LSTRKEY( "send" ),  LFUNCVAL( can_send ) },  
   { LSTRKEY( "recv" ),  LFUNCVAL( can_recv ) },
+  { LSTRKEY( "recvall" ),  LFUNCVAL( can_recvall ) },
+  { LSTRKEY( "set_buffer" ),  LFUNCVAL( can_set_buffer ) },
+  { LSTRKEY( "set_filter" ),  LFUNCVAL( can_set_filter ) },
+  { LSTRKEY( "clear_filter" ),  LFUNCVAL( can_clear_filter ) },
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "ID_STD" ), LNUMVAL( ELUA_CAN_ID_STD ) },
   { LSTRKEY( "ID_EXT" ), LNUMVAL( ELUA_CAN_ID_EXT ) },
+  { LSTRKEY( "NUM_FILTERS" ), LNUMVAL( PLATFORM_CAN_NUM_FILTERS ) },
 #endif
   { LNILKEY, LNILVAL }
 };
@@ -93,6 +185,7 @@ LUALIB_API int luaopen_can( lua_State *L )
   // Module constants  
   MOD_REG_NUMBER( L, "ID_STD", ELUA_CAN_ID_STD );
   MOD_REG_NUMBER( L, "ID_EXT", ELUA_CAN_ID_EXT );
+  MOD_REG_NUMBER( L, "NUM_FILTERS", PLATFORM_CAN_NUM_FILTERS );
   
   return 1;
 #endif // #if LUA_OPTIMIZE_MEMORY > 0  
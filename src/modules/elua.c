@@ -7,6 +7,7 @@
 #include "auxmods.h"
 #include "lrotable.h"
 #include "legc.h"
+#include "lbudget.h"
 #include "platform_conf.h"
 #include "linenoise.h"
 #include "shell.h"
@@ -31,6 +32,95 @@ static int elua_egc_setup( lua_State *L )
   return 0;
 }
 
+#ifdef BUILD_MEM_BUDGETS
+
+static int elua_check_budget( lua_State *L, int stackid )
+{
+  int id = luaL_checkinteger( L, stackid );
+
+  luaL_argcheck( L, id >= LBUDGET_DEFAULT && id < LBUDGET_MAX, stackid, "invalid budget" );
+  return id;
+}
+
+// Set the soft limit callback of budget 'id' to the value at 'stackid'
+static void elua_set_budget_cb( lua_State *L, int id, int stackid )
+{
+  lua_rawgeti( L, LUA_REGISTRYINDEX, LBUDGET_CB_KEY );
+  if( lua_isnil( L, -1 ) )
+  {
+    lua_pop( L, 1 );
+    lua_newtable( L );
+    lua_pushvalue( L, -1 );
+    lua_rawseti( L, LUA_REGISTRYINDEX, LBUDGET_CB_KEY );
+  }
+  lua_pushvalue( L, stackid );
+  lua_rawseti( L, -2, id );
+  lua_pop( L, 1 );
+}
+
+// Lua: id = elua.budget_new( soft, hard, [callback] )
+static int elua_budget_new( lua_State *L )
+{
+  lu_mem soft = ( lu_mem )luaL_checkinteger( L, 1 );
+  lu_mem hard = ( lu_mem )luaL_checkinteger( L, 2 );
+  int id;
+
+  if( lua_gettop( L ) >= 3 && !lua_isnil( L, 3 ) )
+    luaL_checktype( L, 3, LUA_TFUNCTION );
+  else
+  {
+    lua_settop( L, 2 );
+    lua_pushnil( L );
+  }
+  if( ( id = lbudget_new( soft, hard ) ) == -1 )
+    return 0;
+  elua_set_budget_cb( L, id, 3 );
+  lua_pushinteger( L, id );
+  return 1;
+}
+
+// Lua: elua.budget_free( id )
+static int elua_budget_free( lua_State *L )
+{
+  int id = elua_check_budget( L, 1 );
+
+  luaL_argcheck( L, id != LBUDGET_DEFAULT, 1, "can't free the default budget" );
+  lbudget_free( id );
+  lua_pushnil( L );
+  elua_set_budget_cb( L, id, lua_gettop( L ) );
+  return 0;
+}
+
+// Lua: previd = elua.budget_set( id, [co] )
+static int elua_budget_set( lua_State *L )
+{
+  int id = elua_check_budget( L, 1 );
+  lua_State *co = L;
+
+  if( lua_gettop( L ) >= 2 )
+  {
+    co = lua_tothread( L, 2 );
+    luaL_argcheck( L, co, 2, "coroutine expected" );
+  }
+  luaL_argcheck( L, id == LBUDGET_DEFAULT || lbudget_get( id )->inuse, 1, "budget not allocated" );
+  lua_pushinteger( L, co->budget );
+  co->budget = ( lu_byte )id;
+  return 1;
+}
+
+// Lua: used, peak, failures = elua.budget_info( [id] )
+static int elua_budget_info( lua_State *L )
+{
+  lbudget *b = lbudget_get( lua_gettop( L ) >= 1 ? elua_check_budget( L, 1 ) : L->budget );
+
+  lua_pushinteger( L, b->used );
+  lua_pushinteger( L, b->peak );
+  lua_pushinteger( L, b->failures );
+  return 3;
+}
+
+#endif // #ifdef BUILD_MEM_BUDGETS
+
 // Lua: elua.version()
 static int elua_version( lua_State *L )
 {
@@ -90,6 +180,12 @@ const LUA_REG_TYPE elua_map[] =
 #ifdef BUILD_SHELL
   { LSTRKEY( "shell" ), LFUNCVAL( elua_shell ) },
 #endif
+#ifdef BUILD_MEM_BUDGETS
+  { LSTRKEY( "budget_new" ), LFUNCVAL( elua_budget_new ) },
+  { LSTRKEY( "budget_free" ), LFUNCVAL( elua_budget_free ) },
+  { LSTRKEY( "budget_set" ), LFUNCVAL( elua_budget_set ) },
+  { LSTRKEY( "budget_info" ), LFUNCVAL( elua_budget_info ) },
+#endif
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "EGC_NOT_ACTIVE" ), LNUMVAL( EGC_NOT_ACTIVE ) },
   { LSTRKEY( "EGC_ON_ALLOC_FAILURE" ), LNUMVAL( EGC_ON_ALLOC_FAILURE ) },
@@ -0,0 +1,627 @@
+// Module for serving HTTP/1.1 requests (with Lua handlers and static files)
+
+#include "lualib.h"
+#include "lauxlib.h"
+#include "platform.h"
+#include "auxmods.h"
+#include "elua_net.h"
+#include "common.h"
+#include "devman.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "lrotable.h"
+
+#include "platform_conf.h"
+#ifdef BUILD_UIP
+
+// Maximum number of connections served at the same time
+#ifndef HTTPD_MAX_CONNS
+#define HTTPD_MAX_CONNS         4
+#endif
+
+// Maximum size of the request line, of a header line and of a file name
+#ifndef HTTPD_LINE_SIZE
+#define HTTPD_LINE_SIZE         256
+#endif
+
+// Maximum number of request headers
+#ifndef HTTPD_MAX_HEADERS
+#define HTTPD_MAX_HEADERS       32
+#endif
+
+// Maximum size of a request body
+#ifndef HTTPD_MAX_BODY
+#define HTTPD_MAX_BODY          4096
+#endif
+
+// Size of the blocks read from the files that can't be sent directly from memory
+#ifndef HTTPD_FILE_BLOCK
+#define HTTPD_FILE_BLOCK        512
+#endif
+
+// Time to wait for the next line of a request (us)
+#define HTTPD_REQUEST_TIMEOUT   2000000
+
+// An idle keep-alive connection is closed after this time (us)
+#define HTTPD_KEEPALIVE_TIMEOUT 5000000
+
+// Bodies up to this size are sent together with the headers, in one segment
+#define HTTPD_SMALL_BODY        1024
+
+// How long to wait for a request before checking for new connections (us)
+#define HTTPD_POLL_TIMEOUT      20000
+
+// State of the request being served
+typedef struct
+{
+  int sock;
+  u8 head;                      // HEAD request (headers only)
+  u8 http11;                    // HTTP/1.1 client (can use chunked responses)
+  u8 keepalive;                 // keep the connection after the response
+  u8 failed;                    // the response couldn't be sent
+} httpd_req;
+
+// The connections served by httpd.serve
+static int httpd_socks[ HTTPD_MAX_CONNS ];
+static timer_data_type httpd_last[ HTTPD_MAX_CONNS ];
+static unsigned httpd_nconns;
+static u8 httpd_running, httpd_stopped;
+static char httpd_line[ HTTPD_LINE_SIZE ];
+static char httpd_block[ HTTPD_FILE_BLOCK ];
+
+// Reason phrases of the status codes
+static const struct
+{
+  u16 status;
+  const char *reason;
+} httpd_reasons[] =
+{
+  { 100, "Continue" }, { 200, "OK" }, { 201, "Created" }, { 204, "No Content" },
+  { 301, "Moved Permanently" }, { 302, "Found" }, { 304, "Not Modified" },
+  { 400, "Bad Request" }, { 403, "Forbidden" }, { 404, "Not Found" }, { 405, "Method Not Allowed" },
+  { 408, "Request Timeout" }, { 411, "Length Required" }, { 413, "Payload Too Large" },
+  { 414, "URI Too Long" }, { 431, "Request Header Fields Too Large" }, { 500, "Internal Server Error" },
+  { 501, "Not Implemented" }, { 503, "Service Unavailable" }
+};
+
+// Content types of the static files
+static const char* const httpd_types[] =
+{
+  "html", "text/html", "htm", "text/html", "css", "text/css", "js", "application/javascript",
+  "json", "application/json", "txt", "text/plain", "lua", "text/plain", "xml", "text/xml",
+  "png", "image/png", "jpg", "image/jpeg", "gif", "image/gif", "ico", "image/x-icon",
+  "svg", "image/svg+xml", NULL
+};
+
+static const char* httpdh_reason( int status )
+{
+  unsigned i;
+
+  for( i = 0; i < sizeof( httpd_reasons ) / sizeof( httpd_reasons[ 0 ] ); i ++ )
+    if( httpd_reasons[ i ].status == status )
+      return httpd_reasons[ i ].reason;
+  return status < 400 ? "OK" : "Error";
+}
+
+static const char* httpdh_content_type( const char *fname )
+{
+  const char *ext = strrchr( fname, '.' );
+  unsigned i;
+
+  if( ext && !strchr( ext, '/' ) )
+    for( i = 0; httpd_types[ i ]; i += 2 )
+      if( !strcmp( ext + 1, httpd_types[ i ] ) )
+        return httpd_types[ i + 1 ];
+  return "application/octet-stream";
+}
+
+// Helper: send data to the client, the connection is closed after the
+// response if the data can't be sent
+static int httpdh_send( httpd_req *r, const void *data, u32 len )
+{
+  elua_net_size n;
+
+  while( len > 0 )
+  {
+    n = ( elua_net_size )UMIN( len, 0x4000 );
+    if( elua_net_send( r->sock, data, n ) != n )
+    {
+      r->keepalive = 0;
+      r->failed = 1;
+      return -1;
+    }
+    data = ( const char* )data + n;
+    len -= n;
+  }
+  return 0;
+}
+
+// Helper: send the status line and the headers of the response. 'length' is
+// the size of the body, or -1 if it is sent in chunks (or until the connection
+// is closed for HTTP/1.0 clients). 'hidx' is the index of a table with more
+// headers (or 0). A small body at index 'bidx' (if not 0) is sent with the headers.
+static int httpdh_send_head( lua_State *L, httpd_req *r, int status, const char *ctype, s32 length, int hidx, int bidx )
+{
+  int nparts = 1;
+  const char *s;
+  size_t len;
+
+  if( length < 0 && !r->http11 )
+    r->keepalive = 0;
+  if( hidx )
+  {
+    lua_getfield( L, hidx, "Content-Type" );
+    if( lua_isstring( L, -1 ) )
+      ctype = NULL;
+    lua_pop( L, 1 );
+  }
+  lua_pushfstring( L, "HTTP/1.1 %d %s\r\nServer: eLua\r\n%s%s%s", status, httpdh_reason( status ),
+                   ctype ? "Content-Type: " : "", ctype ? ctype : "", ctype ? "\r\n" : "" );
+  if( length >= 0 )
+    lua_pushfstring( L, "Content-Length: %d\r\n", ( int )length );
+  else
+    lua_pushstring( L, r->http11 ? "Transfer-Encoding: chunked\r\n" : "" );
+  lua_pushstring( L, r->keepalive ? "Connection: keep-alive\r\n" : "Connection: close\r\n" );
+  nparts += 2;
+  if( hidx )
+  {
+    lua_pushnil( L );
+    while( lua_next( L, hidx ) )
+    {
+      if( lua_type( L, -2 ) == LUA_TSTRING && lua_isstring( L, -1 ) )
+      {
+        luaL_checkstack( L, 2, "too many headers" );
+        // Keep the header line below the key used by lua_next
+        lua_pushfstring( L, "%s: %s\r\n", lua_tostring( L, -2 ), lua_tostring( L, -1 ) );
+        lua_insert( L, -3 );
+        nparts ++;
+      }
+      lua_pop( L, 1 );
+    }
+  }
+  lua_pushliteral( L, "\r\n" );
+  nparts ++;
+  if( bidx )
+  {
+    lua_pushvalue( L, bidx );
+    nparts ++;
+  }
+  lua_concat( L, nparts );
+  s = lua_tolstring( L, -1, &len );
+  httpdh_send( r, s, len );
+  lua_pop( L, 1 );
+  return r->failed ? -1 : 0;
+}
+
+// Helper: send a short error response
+static void httpdh_error( lua_State *L, httpd_req *r, int status )
+{
+  lua_pushfstring( L, "%d %s\n", status, httpdh_reason( status ) );
+  httpdh_send_head( L, r, status, "text/plain", lua_objlen( L, -1 ), 0, r->head ? 0 : lua_gettop( L ) );
+  lua_pop( L, 1 );
+}
+
+// Helper: send a file. Files in memory (ROMFS) are sent directly from memory,
+// the others are read in blocks. Returns 0 if the file doesn't exist.
+static int httpdh_send_file( lua_State *L, httpd_req *r, const char *fname )
+{
+  FILE *fp;
+  const char *addr;
+  long size;
+  size_t n;
+
+  if( ( fp = fopen( fname, "rb" ) ) == NULL )
+    return 0;
+  fseek( fp, 0, SEEK_END );
+  size = ftell( fp );
+  fseek( fp, 0, SEEK_SET );
+  // The size is unknown if ftell fails (or doesn't fit a Content-Length)
+  if( size < 0 || ( s32 )size != size )
+  {
+    fclose( fp );
+    httpdh_error( L, r, 500 );
+    return 1;
+  }
+  httpdh_send_head( L, r, 200, httpdh_content_type( fname ), size, 0, 0 );
+  if( !r->head && size > 0 )
+  {
+    if( ( addr = dm_getaddr( fileno( fp ) ) ) != NULL )
+    {
+      if( elua_net_send_static( r->sock, addr, size ) != size )
+        r->keepalive = 0;
+    }
+    else
+      while( ( n = fread( httpd_block, 1, HTTPD_FILE_BLOCK, fp ) ) > 0 )
+        if( httpdh_send( r, httpd_block, n ) == -1 )
+          break;
+  }
+  fclose( fp );
+  return 1;
+}
+
+// Helper: serve a static file from the 'root' directory
+static void httpdh_static( lua_State *L, httpd_req *r, const char *root, const char *path )
+{
+  size_t len = strlen( path );
+
+  if( strstr( path, ".." ) || strlen( root ) + len + sizeof( "index.html" ) > HTTPD_LINE_SIZE )
+  {
+    httpdh_error( L, r, 404 );
+    return;
+  }
+  // The line buffer is free after the request was read
+  strcpy( httpd_line, root );
+  strcat( httpd_line, path );
+  if( path[ len - 1 ] == '/' )
+    strcat( httpd_line, "index.html" );
+  if( !httpdh_send_file( L, r, httpd_line ) )
+    httpdh_error( L, r, 404 );
+}
+
+// Helper: send the response returned by a Lua handler (status, body, headers
+// at the top of the stack)
+static void httpdh_respond( lua_State *L, httpd_req *r )
+{
+  int status = lua_isnumber( L, -3 ) ? ( int )lua_tointeger( L, -3 ) : 200;
+  int hidx = lua_istable( L, -1 ) ? lua_gettop( L ) : 0;
+  int bidx = lua_gettop( L ) - 1;
+  char hex[ 12 ];
+  const char *data;
+  size_t len;
+
+  if( lua_isfunction( L, bidx ) )
+  {
+    // Chunked response: the function returns the chunks, then nil
+    if( httpdh_send_head( L, r, status, "text/html", -1, hidx, 0 ) == -1 || r->head )
+      return;
+    while( 1 )
+    {
+      lua_pushvalue( L, bidx );
+      if( lua_pcall( L, 0, 1, 0 ) != 0 )
+      {
+        printf( "httpd: %s\n", lua_tostring( L, -1 ) );
+        lua_pop( L, 1 );
+        // The response can't be completed
+        r->keepalive = 0;
+        r->failed = 1;
+        return;
+      }
+      data = lua_tolstring( L, -1, &len );
+      if( data == NULL || len == 0 )
+        break;
+      if( r->http11 )
+      {
+        sprintf( hex, "%x\r\n", ( unsigned )len );
+        lua_pushstring( L, hex );
+        lua_insert( L, -2 );
+        lua_pushliteral( L, "\r\n" );
+        lua_concat( L, 3 );
+        data = lua_tolstring( L, -1, &len );
+      }
+      if( httpdh_send( r, data, len ) == -1 )
+        break;
+      lua_pop( L, 1 );
+    }
+    lua_pop( L, 1 );
+    if( r->http11 && !r->failed )
+      httpdh_send( r, "0\r\n\r\n", 5 );
+  }
+  else
+  {
+    data = lua_tolstring( L, bidx, &len );
+    if( data == NULL )
+      len = 0;
+    if( r->head || len > HTTPD_SMALL_BODY )
+    {
+      httpdh_send_head( L, r, status, "text/html", len, hidx, 0 );
+      if( !r->head && len > 0 )
+        httpdh_send( r, data, len );
+    }
+    else
+      httpdh_send_head( L, r, status, "text/html", len, hidx, data ? bidx : 0 );
+  }
+}
+
+// Helper: read a line of the request (without the line terminator). Returns
+// its length, -1 if the line can't be read or HTTPD_LINE_TOO_LONG.
+#define HTTPD_LINE_TOO_LONG     ( -2 )
+static int httpdh_read_line( int sock )
+{
+  elua_net_size n;
+
+  n = elua_net_recv( sock, httpd_line, HTTPD_LINE_SIZE - 1, '\n', PLATFORM_TIMER_SYS_ID, HTTPD_REQUEST_TIMEOUT );
+  if( n < 0 || elua_net_get_last_err( sock ) != ELUA_NET_ERR_OK )
+    return -1;
+  if( n == HTTPD_LINE_SIZE - 1 )
+    return HTTPD_LINE_TOO_LONG;
+  httpd_line[ n ] = '\0';
+  return n;
+}
+
+// Helper: decode the %xx sequences in a path
+static void httpdh_unescape( char *p )
+{
+  char *d = p;
+  unsigned v;
+
+  while( *p )
+  {
+    if( p[ 0 ] == '%' && isxdigit( ( int )p[ 1 ] ) && isxdigit( ( int )p[ 2 ] ) && sscanf( p + 1, "%2x", &v ) == 1 )
+    {
+      *d ++ = ( char )v;
+      p += 3;
+    }
+    else
+      *d ++ = *p ++;
+  }
+  *d = '\0';
+}
+
+// Helper: read a request and send its response. Returns 0 if the connection
+// can be kept for the next request.
+static int httpdh_serve_request( lua_State *L, int sock, int hidx, const char *root )
+{
+  httpd_req req;
+  char *path, *query, *version, *p;
+  int n, tries = 0, top = lua_gettop( L ), nheaders = 0, status = 0, expect = 0;
+  long length = 0;
+
+  req.sock = sock;
+  req.head = req.http11 = req.keepalive = req.failed = 0;
+  // Request line: method, target and version (empty lines before it are ignored)
+  while( ( n = httpdh_read_line( sock ) ) == 0 && ++ tries < 4 );
+  if( n == HTTPD_LINE_TOO_LONG )
+    httpdh_error( L, &req, 414 );
+  if( n <= 0 )
+    return -1;
+  if( ( path = strchr( httpd_line, ' ' ) ) == NULL || ( version = strchr( path + 1, ' ' ) ) == NULL )
+  {
+    httpdh_error( L, &req, 400 );
+    return -1;
+  }
+  *path ++ = *version ++ = '\0';
+  if( strncmp( version, "HTTP/1.", 7 ) || *path != '/' )
+  {
+    httpdh_error( L, &req, 400 );
+    return -1;
+  }
+  req.http11 = version[ 7 ] != '0';
+  req.keepalive = req.http11;
+  req.head = !strcmp( httpd_line, "HEAD" );
+  if( ( query = strchr( path, '?' ) ) != NULL )
+    *query ++ = '\0';
+  httpdh_unescape( path );
+  // The line buffer is used for the headers, so the method and the path are
+  // kept on the stack (at top + 1 and top + 2)
+  lua_pushstring( L, httpd_line );
+  lua_pushstring( L, path );
+  // The request table: method, path, query, headers and body
+  lua_createtable( L, 0, 5 );
+  lua_pushvalue( L, top + 1 );
+  lua_setfield( L, -2, "method" );
+  lua_pushvalue( L, top + 2 );
+  lua_setfield( L, -2, "path" );
+  lua_pushstring( L, query ? query : "" );
+  lua_setfield( L, -2, "query" );
+  lua_newtable( L );
+  // Headers (the names are converted to lower case)
+  while( 1 )
+  {
+    if( ( n = httpdh_read_line( sock ) ) < 0 )
+    {
+      if( n == HTTPD_LINE_TOO_LONG )
+      {
+        req.keepalive = 0;
+        httpdh_error( L, &req, 431 );
+      }
+      lua_settop( L, top );
+      return -1;
+    }
+    if( n == 0 )
+      break;
+    if( ++ nheaders > HTTPD_MAX_HEADERS )
+    {
+      status = 431;
+      continue;
+    }
+    if( ( p = strchr( httpd_line, ':' ) ) == NULL )
+    {
+      status = 400;
+      continue;
+    }
+    *p ++ = '\0';
+    while( *p == ' ' || *p == '\t' )
+      p ++;
+    for( n = 0; httpd_line[ n ]; n ++ )
+      httpd_line[ n ] = tolower( ( int )httpd_line[ n ] );
+    if( !strcmp( httpd_line, "content-length" ) )
+      length = atol( p );
+    else if( !strcmp( httpd_line, "transfer-encoding" ) && strcmp( p, "identity" ) )
+      status = 501;
+    else if( !strcmp( httpd_line, "expect" ) )
+      expect = 1;
+    else if( !strcmp( httpd_line, "connection" ) )
+    {
+      for( n = 0; p[ n ]; n ++ )
+        p[ n ] = tolower( ( int )p[ n ] );
+      if( strstr( p, "close" ) )
+        req.keepalive = 0;
+      else if( strstr( p, "keep-alive" ) )
+        req.keepalive = 1;
+    }
+    lua_pushstring( L, p );
+    lua_setfield( L, -2, httpd_line );
+  }
+  lua_setfield( L, -2, "headers" );
+  if( status == 0 && ( length < 0 || length > HTTPD_MAX_BODY ) )
+    status = 413;
+  if( status )
+  {
+    req.keepalive = 0;
+    httpdh_error( L, &req, status );
+    lua_settop( L, top );
+    return -1;
+  }
+  // Body
+  if( length > 0 )
+  {
+    luaL_Buffer b;
+    elua_net_size got;
+
+    if( expect && req.http11 )
+      httpdh_send( &req, "HTTP/1.1 100 Continue\r\n\r\n", 25 );
+    luaL_buffinit( L, &b );
+    while( length > 0 )
+    {
+      got = elua_net_recvbuf( sock, &b, ( elua_net_size )length, ELUA_NET_NO_LASTCHAR, PLATFORM_TIMER_SYS_ID, HTTPD_REQUEST_TIMEOUT );
+      if( got <= 0 )
+        break;
+      length -= got;
+    }
+    luaL_pushresult( &b );
+    if( length > 0 )
+    {
+      lua_settop( L, top );
+      return -1;
+    }
+    lua_setfield( L, -2, "body" );
+  }
+  // The handler for "METHOD path", then the handler for "path"
+  lua_pushfstring( L, "%s %s", lua_tostring( L, top + 1 ), lua_tostring( L, top + 2 ) );
+  lua_rawget( L, hidx );
+  if( lua_isnil( L, -1 ) )
+  {
+    lua_pop( L, 1 );
+    lua_pushvalue( L, top + 2 );
+    lua_rawget( L, hidx );
+  }
+  if( lua_isfunction( L, -1 ) )
+  {
+    lua_insert( L, -2 );
+    if( lua_pcall( L, 1, 3, 0 ) != 0 )
+    {
+      printf( "httpd: %s\n", lua_tostring( L, -1 ) );
+      httpdh_error( L, &req, 500 );
+    }
+    else
+      httpdh_respond( L, &req );
+  }
+  else if( root && ( req.head || !strcmp( lua_tostring( L, top + 1 ), "GET" ) ) )
+    httpdh_static( L, &req, root, lua_tostring( L, top + 2 ) );
+  else
+    httpdh_error( L, &req, root ? 405 : 404 );
+  lua_settop( L, top );
+  return req.keepalive ? 0 : -1;
+}
+
+// Helper: close the connection with the given index
+static void httpdh_close( unsigned i )
+{
+  elua_net_close( httpd_socks[ i ] );
+  httpd_socks[ i ] = httpd_socks[ -- httpd_nconns ];
+  httpd_last[ i ] = httpd_last[ httpd_nconns ];
+}
+
+// The server loop (called in protected mode by httpd.serve, which closes the
+// connections if it ends with an error)
+static int httpdh_loop( lua_State *L )
+{
+  u16 port = ( u16 )luaL_checkinteger( L, 1 );
+  const char *root = lua_tostring( L, 3 );
+  int ready[ HTTPD_MAX_CONNS ];
+  unsigned i, j, nr, nw;
+  elua_net_ip from;
+  int s;
+
+  while( !httpd_stopped )
+  {
+    // New connections
+    if( httpd_nconns < HTTPD_MAX_CONNS && ( s = elua_accept( port, PLATFORM_TIMER_SYS_ID, 0, &from ) ) != -1 )
+    {
+      httpd_socks[ httpd_nconns ] = s;
+      httpd_last[ httpd_nconns ++ ] = platform_timer_start( PLATFORM_TIMER_SYS_ID );
+    }
+    // Requests
+    memcpy( ready, httpd_socks, httpd_nconns * sizeof( int ) );
+    nr = httpd_nconns;
+    nw = 0;
+    elua_net_select( ready, &nr, NULL, &nw, PLATFORM_TIMER_SYS_ID, HTTPD_POLL_TIMEOUT );
+    for( j = 0; j < nr && !httpd_stopped; j ++ )
+      for( i = 0; i < httpd_nconns; i ++ )
+        if( httpd_socks[ i ] == ready[ j ] )
+        {
+          if( httpdh_serve_request( L, ready[ j ], 2, root ) == -1 )
+            httpdh_close( i );
+          else
+            httpd_last[ i ] = platform_timer_start( PLATFORM_TIMER_SYS_ID );
+          break;
+        }
+    // Idle connections
+    for( i = 0; i < httpd_nconns; )
+      if( platform_timer_get_diff_crt( PLATFORM_TIMER_SYS_ID, httpd_last[ i ] ) >= HTTPD_KEEPALIVE_TIMEOUT )
+        httpdh_close( i );
+      else
+        i ++;
+  }
+  return 0;
+}
+
+// Lua: serve( port, handlers, [root] )
+static int httpd_serve( lua_State *L )
+{
+  int res;
+
+  luaL_checkinteger( L, 1 );
+  luaL_checktype( L, 2, LUA_TTABLE );
+  if( !lua_isnoneornil( L, 3 ) )
+    luaL_checkstring( L, 3 );
+  if( httpd_running )
+    return luaL_error( L, "server already running" );
+  httpd_running = 1;
+  httpd_stopped = 0;
+  httpd_nconns = 0;
+  lua_settop( L, 3 );
+  lua_pushcfunction( L, httpdh_loop );
+  lua_insert( L, 1 );
+  res = lua_pcall( L, 3, 0, 0 );
+  while( httpd_nconns > 0 )
+    httpdh_close( 0 );
+  httpd_running = 0;
+  if( res != 0 )
+    return lua_error( L );
+  return 0;
+}
+
+// Lua: stop()
+static int httpd_stop( lua_State *L )
+{
+  httpd_stopped = 1;
+  return 0;
+}
+
+// Module function map
+#define MIN_OPT_LEVEL 2
+#include "lrodefs.h"
+const LUA_REG_TYPE httpd_map[] =
+{
+  { LSTRKEY( "serve" ), LFUNCVAL( httpd_serve ) },
+  { LSTRKEY( "stop" ), LFUNCVAL( httpd_stop ) },
+  { LNILKEY, LNILVAL }
+};
+
+LUALIB_API int luaopen_httpd( lua_State *L )
+{
+  LREGISTER( L, AUXLIB_HTTPD, httpd_map );
+}
+
+#else // #ifdef BUILD_UIP
+
+LUALIB_API int luaopen_httpd( lua_State *L )
+{
+  return 0;
+}
+
+#endif // #ifdef BUILD_UIP
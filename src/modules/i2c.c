@@ -136,6 +136,69 @@ static int i2c_read( lua_State *L )
   return 1;
 }
 
+// Helper: execute a combined transaction and push the received data (or nil if
+// the slave didn't acknowledge)
+static int i2c_transfer_helper( lua_State *L, unsigned id, int address, const u8 *txdata, u32 txlen, u32 rxlen )
+{
+  luaL_Buffer b;
+  u8 *rxdata;
+  int res;
+
+  if( address < 0 || address > 127 )
+    return luaL_error( L, "slave address must be from 0 to 127" );
+  // Receive directly in the Lua buffer if possible
+  if( rxlen <= LUAL_BUFFERSIZE )
+  {
+    luaL_buffinit( L, &b );
+    rxdata = ( u8* )luaL_prepbuffer( &b );
+  }
+  else
+    rxdata = ( u8* )lua_newuserdata( L, rxlen );
+  if( ( res = platform_i2c_transfer( id, ( u16 )address, txdata, txlen, rxdata, rxlen ) ) == -1 )
+    lua_pushnil( L );
+  else if( rxlen <= LUAL_BUFFERSIZE )
+  {
+    luaL_addsize( &b, res );
+    luaL_pushresult( &b );
+  }
+  else
+    lua_pushlstring( L, ( const char* )rxdata, res );
+  return 1;
+}
+
+// Lua: rxdata = i2c.transfer( id, address, txdata, [rxlen] )
+static int i2c_transfer( lua_State *L )
+{
+  unsigned id = luaL_checkinteger( L, 1 );
+  int address = luaL_checkinteger( L, 2 );
+  size_t txlen;
+  const char *txdata = luaL_optlstring( L, 3, "", &txlen );
+  s32 rxlen = ( s32 )luaL_optinteger( L, 4, 0 );
+
+  MOD_CHECK_ID( i2c, id );
+  if( rxlen < 0 )
+    return luaL_error( L, "invalid receive length" );
+  return i2c_transfer_helper( L, id, address, ( const u8* )txdata, txlen, ( u32 )rxlen );
+}
+
+// Lua: data = i2c.readreg( id, address, register, [count] )
+static int i2c_readreg( lua_State *L )
+{
+  unsigned id = luaL_checkinteger( L, 1 );
+  int address = luaL_checkinteger( L, 2 );
+  int reg = luaL_checkinteger( L, 3 );
+  s32 count = ( s32 )luaL_optinteger( L, 4, 1 );
+  u8 regdata;
+
+  MOD_CHECK_ID( i2c, id );
+  if( reg < 0 || reg > 255 )
+    return luaL_error( L, "register must be from 0 to 255" );
+  if( count < 0 )
+    return luaL_error( L, "invalid count" );
+  regdata = ( u8 )reg;
+  return i2c_transfer_helper( L, id, address, &regdata, 1, ( u32 )count );
+}
+
 // Module function map
 #define MIN_OPT_LEVEL   2
 #include "lrodefs.h"
@@ -147,6 +210,8 @@ const LUA_REG_TYPE i2c_map[] =
   { LSTRKEY( "address" ), LFUNCVAL( i2c_address ) },
   { LSTRKEY( "write" ), LFUNCVAL( i2c_write ) },
   { LSTRKEY( "read" ), LFUNCVAL( i2c_read ) },
+  { LSTRKEY( "transfer" ), LFUNCVAL( i2c_transfer ) },
+  { LSTRKEY( "readreg" ), LFUNCVAL( i2c_readreg ) },
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "FAST" ), LNUMVAL( PLATFORM_I2C_SPEED_FAST ) },
   { LSTRKEY( "SLOW" ), LNUMVAL( PLATFORM_I2C_SPEED_SLOW ) },
@@ -49,16 +49,26 @@ static int net_close( lua_State* L )
   return 1;
 }
 
-// Lua: res, err = send( sock, str )
+// Lua: res, err = send( sock, str, [timer_id, timeout] )
+// Without a timer_id/timeout the data is sent directly from 'str', otherwise
+// it is sent through the send buffer of the socket
 static int net_send( lua_State* L )
 {
   int sock = ( int )luaL_checkinteger( L, 1 );
   const char *buf;
   size_t len;
+  unsigned timer_id;
+  timer_data_type timeout;
     
   luaL_checktype( L, 2, LUA_TSTRING );
   buf = lua_tolstring( L, 2, &len );
-  lua_pushinteger( L, elua_net_send( sock, buf, len ) );
+  if( lua_gettop( L ) >= 3 )
+  {
+    cmn_get_timeout_data( L, 3, &timer_id, &timeout );
+    lua_pushinteger( L, elua_net_send_buffered( sock, buf, len, timer_id, timeout ) );
+  }
+  else
+    lua_pushinteger( L, elua_net_send( sock, buf, len ) );
   lua_pushinteger( L, elua_net_get_last_err( sock ) );
   return 2;  
 }
@@ -166,6 +176,188 @@ static int net_recv( lua_State *L )
   return 2;
 }
 
+// Lua: res = bind( sock, port )
+static int net_bind( lua_State *L )
+{
+  int sock = ( int )luaL_checkinteger( L, 1 );
+  u16 port = ( u16 )luaL_checkinteger( L, 2 );
+
+  lua_pushinteger( L, elua_net_bind( sock, port ) );
+  return 1;
+}
+
+// Lua: res, err = sendto( sock, str, iptype, port )
+static int net_sendto( lua_State *L )
+{
+  int sock = ( int )luaL_checkinteger( L, 1 );
+  u16 port = ( u16 )luaL_checkinteger( L, 4 );
+  elua_net_ip ip;
+  const char *buf;
+  size_t len;
+
+  luaL_checktype( L, 2, LUA_TSTRING );
+  buf = lua_tolstring( L, 2, &len );
+  ip.ipaddr = ( u32 )luaL_checkinteger( L, 3 );
+  lua_pushinteger( L, elua_net_sendto( sock, buf, len, ip, port ) );
+  lua_pushinteger( L, elua_net_get_last_err( sock ) );
+  return 2;
+}
+
+// Lua: res, remoteip, port, err = recvfrom( sock, maxsize, [timer_id, timeout] )
+static int net_recvfrom( lua_State *L )
+{
+  int sock = ( int )luaL_checkinteger( L, 1 );
+  elua_net_size maxsize = ( elua_net_size )luaL_checkinteger( L, 2 );
+  unsigned timer_id = PLATFORM_TIMER_SYS_ID;
+  timer_data_type timeout = PLATFORM_TIMER_INF_TIMEOUT;
+  luaL_Buffer net_recv_buff;
+  elua_net_ip remip;
+  u16 port;
+
+  cmn_get_timeout_data( L, 3, &timer_id, &timeout );
+  luaL_buffinit( L, &net_recv_buff );
+  elua_net_recvfrombuf( sock, &net_recv_buff, maxsize, &remip, &port, timer_id, timeout );
+  luaL_pushresult( &net_recv_buff );
+  lua_pushinteger( L, remip.ipaddr );
+  lua_pushinteger( L, port );
+  lua_pushinteger( L, elua_net_get_last_err( sock ) );
+  return 4;
+}
+
+// Helper: read the sockets from the table at 'idx' to 'socks'
+static void net_get_sockets( lua_State *L, int idx, int *socks, unsigned n )
+{
+  unsigned i;
+
+  for( i = 0; i < n; i ++ )
+  {
+    lua_rawgeti( L, idx, i + 1 );
+    socks[ i ] = ( int )luaL_checkinteger( L, -1 );
+    lua_pop( L, 1 );
+  }
+}
+
+// Helper: push the sockets in 'socks' as a new table
+static void net_push_sockets( lua_State *L, const int *socks, unsigned n )
+{
+  unsigned i;
+
+  lua_createtable( L, n, 0 );
+  for( i = 0; i < n; i ++ )
+  {
+    lua_pushinteger( L, socks[ i ] );
+    lua_rawseti( L, -2, i + 1 );
+  }
+}
+
+// Lua: readable, writable = select( recvt, [sendt], [timer_id, timeout] )
+static int net_select( lua_State *L )
+{
+  unsigned nr, nw, maxr;
+  unsigned timer_id;
+  timer_data_type timeout;
+  int *socks;
+
+  luaL_checktype( L, 1, LUA_TTABLE );
+  nr = maxr = lua_objlen( L, 1 );
+  if( lua_isnoneornil( L, 2 ) )
+    nw = 0;
+  else
+  {
+    luaL_checktype( L, 2, LUA_TTABLE );
+    nw = lua_objlen( L, 2 );
+  }
+  cmn_get_timeout_data( L, 3, &timer_id, &timeout );
+  socks = ( int* )lua_newuserdata( L, ( nr + nw ) * sizeof( int ) );
+  net_get_sockets( L, 1, socks, nr );
+  if( nw > 0 )
+    net_get_sockets( L, 2, socks + maxr, nw );
+  if( elua_net_select( socks, &nr, socks + maxr, &nw, timer_id, timeout ) == -1 )
+    return luaL_error( L, "invalid socket" );
+  net_push_sockets( L, socks, nr );
+  net_push_sockets( L, socks + maxr, nw );
+  return 2;
+}
+
+// Lua: res = chksum( str, [i, j] )
+static int net_chksum( lua_State *L )
+{
+  size_t len;
+  const char *buf = luaL_checklstring( L, 1, &len );
+  long i = luaL_optlong( L, 2, 1 );
+  long j = luaL_optlong( L, 3, -1 );
+
+  // Same indexes as string.sub
+  if( i < 0 )
+    i += ( long )len + 1;
+  if( j < 0 )
+    j += ( long )len + 1;
+  if( i < 1 )
+    i = 1;
+  if( j > ( long )len )
+    j = ( long )len;
+  if( i > j )
+    i = j + 1;
+  if( j - i + 1 > 0xFFFF )
+    return luaL_error( L, "data too long" );
+  lua_pushinteger( L, elua_net_chksum( buf + i - 1, ( u16 )( j - i + 1 ) ) );
+  return 1;
+}
+
+// Lua: queued, buffered, dropped = rxstats( sock, [reset] )
+static int net_rxstats( lua_State *L )
+{
+  int sock = ( int )luaL_checkinteger( L, 1 );
+  int reset = lua_toboolean( L, 2 );
+  u32 queued, buffered, dropped;
+
+  if( elua_net_rxstats( sock, &queued, &buffered, &dropped, reset ) == -1 )
+    return luaL_error( L, "invalid socket" );
+  lua_pushinteger( L, queued );
+  lua_pushinteger( L, buffered );
+  lua_pushinteger( L, dropped );
+  return 3;
+}
+
+// Lua: segments, bytes = telnetstats( [reset] )
+static int net_telnetstats( lua_State *L )
+{
+  int reset = lua_toboolean( L, 1 );
+  u32 segments, bytes;
+
+  if( elua_net_telnet_stats( &segments, &bytes, reset ) == -1 )
+    return luaL_error( L, "no console over TCP" );
+  lua_pushinteger( L, segments );
+  lua_pushinteger( L, bytes );
+  return 2;
+}
+
+// Lua: hits, misses = arpstats( [reset] )
+static int net_arpstats( lua_State *L )
+{
+  int reset = lua_toboolean( L, 1 );
+  u32 hits, misses;
+
+  elua_net_arpstats( &hits, &misses, reset );
+  lua_pushinteger( L, hits );
+  lua_pushinteger( L, misses );
+  return 2;
+}
+
+// Lua: hits, neghits, misses = dnsstats( [reset] )
+static int net_dnsstats( lua_State *L )
+{
+  int reset = lua_toboolean( L, 1 );
+  u32 hits, neg, misses;
+
+  if( elua_net_dnsstats( &hits, &neg, &misses, reset ) == -1 )
+    return luaL_error( L, "no DNS support" );
+  lua_pushinteger( L, hits );
+  lua_pushinteger( L, neg );
+  lua_pushinteger( L, misses );
+  return 3;
+}
+
 // Lua: iptype = lookup( "name" )
 static int net_lookup( lua_State* L )
 {
@@ -191,6 +383,15 @@ const LUA_REG_TYPE net_map[] =
   { LSTRKEY( "send" ), LFUNCVAL( net_send ) },
   { LSTRKEY( "recv" ), LFUNCVAL( net_recv ) },
   { LSTRKEY( "lookup" ), LFUNCVAL( net_lookup ) },
+  { LSTRKEY( "select" ), LFUNCVAL( net_select ) },
+  { LSTRKEY( "bind" ), LFUNCVAL( net_bind ) },
+  { LSTRKEY( "sendto" ), LFUNCVAL( net_sendto ) },
+  { LSTRKEY( "recvfrom" ), LFUNCVAL( net_recvfrom ) },
+  { LSTRKEY( "chksum" ), LFUNCVAL( net_chksum ) },
+  { LSTRKEY( "rxstats" ), LFUNCVAL( net_rxstats ) },
+  { LSTRKEY( "telnetstats" ), LFUNCVAL( net_telnetstats ) },
+  { LSTRKEY( "arpstats" ), LFUNCVAL( net_arpstats ) },
+  { LSTRKEY( "dnsstats" ), LFUNCVAL( net_dnsstats ) },
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "SOCK_STREAM" ), LNUMVAL( ELUA_NET_SOCK_STREAM ) },
   { LSTRKEY( "SOCK_DGRAM" ), LNUMVAL( ELUA_NET_SOCK_DGRAM ) },
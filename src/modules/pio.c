@@ -6,6 +6,7 @@
 #include "auxmods.h"
 #include "lrotable.h"
 #include "platform_conf.h"
+#include "llimits.h"
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -274,9 +275,268 @@ static int pio_port_getval( lua_State *L )
   return total;
 }
 
+// Lua: t = pio.port.snapshot( [port1, port2, ..., portn] )
+// Reads all the given ports (all the ports if none is given) with interrupts
+// disabled and returns a table indexed by port code
+static int pio_port_snapshot( lua_State *L )
+{
+  pio_type values[ PLATFORM_IO_PORTS ];
+  int total = lua_gettop( L );
+  int i, v, port, old_status;
+  u32 port_mask = 0;
+
+  if( total == 0 )
+  {
+    for( i = 0; i < PLATFORM_IO_PORTS; i ++ )
+      if( platform_pio_has_port( i ) )
+        port_mask |= 1UL << i;
+  }
+  else
+    for( i = 1; i <= total; i ++ )
+    {
+      v = luaL_checkinteger( L, i );
+      port = PLATFORM_IO_GET_PORT( v );
+      if( !PLATFORM_IO_IS_PORT( v ) || !platform_pio_has_port( port ) )
+        return luaL_error( L, "invalid port" );
+      port_mask |= 1UL << port;
+    }
+
+  // Read all the ports as close together as possible
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  for( i = 0; i < PLATFORM_IO_PORTS; i ++ )
+    if( port_mask & ( 1UL << i ) )
+      values[ i ] = platform_pio_op( i, PLATFORM_IO_ALL_PINS, PLATFORM_IO_PORT_GET_VALUE );
+  platform_cpu_set_global_interrupts( old_status );
+
+  lua_newtable( L );
+  for( i = 0; i < PLATFORM_IO_PORTS; i ++ )
+    if( port_mask & ( 1UL << i ) )
+    {
+      lua_pushinteger( L, values[ i ] );
+      lua_rawseti( L, -2, PLATFORM_IO_ENCODE( i, 0, 1 ) );
+    }
+  return 1;
+}
+
+// Lua: pio.port.apply( t )
+// 't' is indexed by port or pin codes. A port entry is either the port value
+// or a { value, mask } pair that changes only the pins in 'mask', a pin entry
+// is 0 or 1. The changes are merged per port and written with interrupts
+// disabled, using a single write for full port values and at most a set and
+// a clear operation otherwise
+static int pio_port_apply( lua_State *L )
+{
+  pio_type setmask[ PLATFORM_IO_PORTS ], clrmask[ PLATFORM_IO_PORTS ];
+  pio_type value, mask;
+  u32 full_mask = 0, port_mask = 0;
+  int i, v, port, pin, old_status;
+
+  luaL_checktype( L, 1, LUA_TTABLE );
+  for( i = 0; i < PLATFORM_IO_PORTS; i ++ )
+    setmask[ i ] = clrmask[ i ] = 0;
+
+  // Compute the combined masks for all the ports
+  lua_pushnil( L );
+  while( lua_next( L, 1 ) )
+  {
+    if( lua_type( L, -2 ) != LUA_TNUMBER )
+      return luaL_error( L, "invalid pin/port" );
+    v = lua_tointeger( L, -2 );
+    port = PLATFORM_IO_GET_PORT( v );
+    if( !platform_pio_has_port( port ) )
+      return luaL_error( L, "invalid port" );
+    if( PLATFORM_IO_IS_PORT( v ) )
+    {
+      if( lua_istable( L, -1 ) )
+      {
+        lua_rawgeti( L, -1, 1 );
+        lua_rawgeti( L, -2, 2 );
+        value = ( pio_type )luaL_checkinteger( L, -2 );
+        mask = ( pio_type )luaL_checkinteger( L, -1 );
+        lua_pop( L, 2 );
+      }
+      else
+      {
+        // Pins given by other entries take precedence over the port value
+        value = ( pio_type )luaL_checkinteger( L, -1 );
+        mask = ~( setmask[ port ] | clrmask[ port ] );
+        full_mask |= 1UL << port;
+      }
+    }
+    else
+    {
+      pin = PLATFORM_IO_GET_PIN( v );
+      if( !platform_pio_has_pin( port, pin ) )
+        return luaL_error( L, "invalid pin" );
+      value = ( pio_type )luaL_checkinteger( L, -1 );
+      if( value != 0 && value != 1 )
+        return luaL_error( L, "invalid pin value" );
+      mask = 1UL << pin;
+      value = value ? mask : 0;
+    }
+    setmask[ port ] = ( setmask[ port ] & ~mask ) | ( value & mask );
+    clrmask[ port ] = ( clrmask[ port ] & ~mask ) | ( ~value & mask );
+    port_mask |= 1UL << port;
+    lua_pop( L, 1 );
+  }
+
+  // Issue the minimal number of register writes
+  old_status = platform_cpu_set_global_interrupts( PLATFORM_CPU_DISABLE );
+  for( i = 0; i < PLATFORM_IO_PORTS; i ++ )
+  {
+    if( ( port_mask & ( 1UL << i ) ) == 0 )
+      continue;
+    if( full_mask & ( 1UL << i ) )
+      platform_pio_op( i, setmask[ i ], PLATFORM_IO_PORT_SET_VALUE );
+    else
+    {
+      if( setmask[ i ] )
+        platform_pio_op( i, setmask[ i ], PLATFORM_IO_PIN_SET );
+      if( clrmask[ i ] )
+        platform_pio_op( i, clrmask[ i ], PLATFORM_IO_PIN_CLEAR );
+    }
+  }
+  platform_cpu_set_global_interrupts( old_status );
+  return 0;
+}
+
+// ****************************************************************************
+// Waveform operations
+
+#if defined( PLATFORM_HAS_SYSTIMER ) || defined( PLATFORM_HAS_PIO_WAVE )
+#define PIO_WAVE_SUPPORT
+
+// Number of S32 array elements in a step ( port, mask, value, delay )
+#define PIO_WAVE_STEP_WORDS   4
+
+// Helper: return field 'idx' of the step table on the top of the stack
+static u32 pioh_wave_get_field( lua_State *L, int idx )
+{
+  u32 res;
+
+  lua_rawgeti( L, -1, idx );
+  res = ( u32 )luaL_checknumber( L, -1 );
+  lua_pop( L, 1 );
+  return res;
+}
+
+// Lua: pio.waveform.play( steps, [count] )
+// 'steps' is either an array.S32 with 4 elements ( port, mask, value, delay )
+// for each step (used in place) or a table of { port, mask, value, delay } tables
+static int pio_wave_play( lua_State *L )
+{
+  unsigned count = ( unsigned )luaL_optinteger( L, 2, 1 );
+  pio_wave_step *steps;
+  unsigned nsteps, i;
+  array_t *pa;
+
+  if( array_isarray( L, 1 ) )
+  {
+    pa = array_check( L, 1 );
+    if( array_gettype( pa ) != ARRAY_S32 || array_getlen( pa ) % PIO_WAVE_STEP_WORDS )
+      return luaL_error( L, "steps must be an array.S32 with 4 elements per step" );
+    steps = ( pio_wave_step* )array_getdata( pa );
+    nsteps = array_getlen( pa ) / PIO_WAVE_STEP_WORDS;
+  }
+  else
+  {
+    luaL_checktype( L, 1, LUA_TTABLE );
+    nsteps = lua_objlen( L, 1 );
+    steps = ( pio_wave_step* )lua_newuserdata( L, nsteps * sizeof( pio_wave_step ) );
+    for( i = 0; i < nsteps; i ++ )
+    {
+      lua_rawgeti( L, 1, i + 1 );
+      if( !lua_istable( L, -1 ) )
+        return luaL_error( L, "invalid step %d", i + 1 );
+      steps[ i ].port = pioh_wave_get_field( L, 1 );
+      steps[ i ].mask = pioh_wave_get_field( L, 2 );
+      steps[ i ].value = pioh_wave_get_field( L, 3 );
+      steps[ i ].delay = pioh_wave_get_field( L, 4 );
+      lua_pop( L, 1 );
+    }
+  }
+  for( i = 0; i < nsteps; i ++ )
+    if( !PLATFORM_IO_IS_PORT( steps[ i ].port ) || !platform_pio_has_port( PLATFORM_IO_GET_PORT( steps[ i ].port ) ) )
+      return luaL_error( L, "invalid port in step %d", i + 1 );
+  for( ; count > 0; count -- )
+    platform_pio_wave_play( steps, nsteps );
+  return 0;
+}
+
+// Lua: data, n = pio.waveform.capture( port, mask, maxentries | array, timeout )
+// Returns an array.S32 with ( timestamp, value ) pairs and the number of pairs
+static int pio_wave_capture( lua_State *L )
+{
+  u32 port = ( u32 )luaL_checkinteger( L, 1 );
+  pio_type mask = ( pio_type )luaL_checknumber( L, 2 );
+  u32 timeout = ( u32 )luaL_checkinteger( L, 4 );
+  lua_Integer max;
+  unsigned n;
+  u32 *pdata;
+  array_t *pa;
+
+  if( !PLATFORM_IO_IS_PORT( port ) || !platform_pio_has_port( PLATFORM_IO_GET_PORT( port ) ) )
+    return luaL_error( L, "invalid port" );
+  if( array_isarray( L, 3 ) )
+  {
+    // Capture directly in the given array
+    pa = array_check( L, 3 );
+    if( array_gettype( pa ) != ARRAY_S32 )
+      return luaL_error( L, "the capture array must be an array.S32" );
+    n = platform_pio_wave_capture( port, mask, ( u32* )array_getdata( pa ), array_getlen( pa ) / 2, timeout );
+    lua_pushvalue( L, 3 );
+  }
+  else
+  {
+    max = luaL_checkinteger( L, 3 );
+    if( max < 1 || ( size_t )max > MAX_SIZET / ( 2 * sizeof( u32 ) ) || ( unsigned )max != max )
+      return luaL_argerror( L, 3, "invalid number of entries" );
+    pdata = ( u32* )lua_newuserdata( L, max * 2 * sizeof( u32 ) );
+    n = platform_pio_wave_capture( port, mask, pdata, max, timeout );
+    pa = array_push( L, n * 2, ARRAY_S32 );
+    memcpy( array_getdata( pa ), pdata, n * 2 * sizeof( u32 ) );
+  }
+  lua_pushinteger( L, n );
+  return 2;
+}
+
+#endif // #if defined( PLATFORM_HAS_SYSTIMER ) || defined( PLATFORM_HAS_PIO_WAVE )
+
 // ****************************************************************************
 // The __index metamethod will return pin/port numeric identifiers
 
+// Maximum number of decoded pin/port names kept in the name cache
+#ifndef PIO_NAME_CACHE_SIZE
+#define PIO_NAME_CACHE_SIZE   64
+#endif
+
+// The name cache is a table that maps names to codes, kept in the registry
+// (not as a reference, since the Lua state can be closed and opened again)
+static unsigned pio_name_cache_entries;
+#define PIO_NAME_CACHE_KEY    ( int )&pio_name_cache_entries
+
+// Helper: add a decoded name to the name cache
+static void pioh_cache_name( lua_State *L, int code )
+{
+  lua_rawgeti( L, LUA_REGISTRYINDEX, PIO_NAME_CACHE_KEY );
+  if( lua_isnil( L, -1 ) )
+  {
+    lua_pop( L, 1 );
+    lua_newtable( L );
+    lua_pushvalue( L, -1 );
+    lua_rawseti( L, LUA_REGISTRYINDEX, PIO_NAME_CACHE_KEY );
+    pio_name_cache_entries = 0;
+  }
+  if( pio_name_cache_entries < PIO_NAME_CACHE_SIZE )
+  {
+    lua_pushvalue( L, 2 );
+    lua_pushinteger( L, code );
+    lua_rawset( L, -3 );
+    pio_name_cache_entries ++;
+  }
+  lua_pop( L, 1 );
+}
+
 static int pio_mt_index( lua_State* L )
 {
   const char *key = luaL_checkstring( L ,2 );
@@ -284,6 +544,18 @@ static int pio_mt_index( lua_State* L )
   
   if( !key || *key != 'P' )
     return 0;
+
+  // Look in the name cache first, names are parsed only on their first use
+  lua_rawgeti( L, LUA_REGISTRYINDEX, PIO_NAME_CACHE_KEY );
+  if( lua_istable( L, -1 ) )
+  {
+    lua_pushvalue( L, 2 );
+    lua_rawget( L, -2 );
+    if( !lua_isnil( L, -1 ) )
+      return 1;
+    lua_pop( L, 1 );
+  }
+  lua_pop( L, 1 );
   if( isupper( (unsigned char) key[ 1 ] ) ) // PA, PB, ...
   {
     if( PIO_PREFIX != 'A' )
@@ -371,6 +643,7 @@ static int pio_mt_index( lua_State* L )
     return 0;
   else
   {
+    pioh_cache_name( L, sz );
     lua_pushinteger( L, sz );
     return 1;
   }
@@ -448,8 +721,19 @@ static const LUA_REG_TYPE pio_port_map[] =
   { LSTRKEY( "sethigh" ), LFUNCVAL( pio_port_sethigh ) },
   { LSTRKEY( "setlow" ), LFUNCVAL( pio_port_setlow ) },
   { LSTRKEY( "getval" ), LFUNCVAL( pio_port_getval ) },
+  { LSTRKEY( "snapshot" ), LFUNCVAL( pio_port_snapshot ) },
+  { LSTRKEY( "apply" ), LFUNCVAL( pio_port_apply ) },
+  { LNILKEY, LNILVAL }
+};
+
+#ifdef PIO_WAVE_SUPPORT
+static const LUA_REG_TYPE pio_waveform_map[] =
+{
+  { LSTRKEY( "play" ), LFUNCVAL( pio_wave_play ) },
+  { LSTRKEY( "capture" ), LFUNCVAL( pio_wave_capture ) },
   { LNILKEY, LNILVAL }
 };
+#endif
 
 const LUA_REG_TYPE pio_map[] =
 {
@@ -457,6 +741,9 @@ const LUA_REG_TYPE pio_map[] =
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "pin" ), LROVAL( pio_pin_map ) },
   { LSTRKEY( "port" ), LROVAL( pio_port_map ) },
+#ifdef PIO_WAVE_SUPPORT
+  { LSTRKEY( "waveform" ), LROVAL( pio_waveform_map ) },
+#endif
   { LSTRKEY( "INPUT" ), LNUMVAL( PIO_DIR_INPUT ) },
   { LSTRKEY( "OUTPUT" ), LNUMVAL( PIO_DIR_OUTPUT ) },
   { LSTRKEY( "PULLUP" ), LNUMVAL( PLATFORM_IO_PIN_PULLUP ) },
@@ -495,6 +782,12 @@ LUALIB_API int luaopen_pio( lua_State *L )
   luaL_register( L, NULL, pio_port_map );
   lua_setfield( L, -2, "port" );
 
+#ifdef PIO_WAVE_SUPPORT
+  lua_newtable( L );
+  luaL_register( L, NULL, pio_waveform_map );
+  lua_setfield( L, -2, "waveform" );
+#endif
+
   return 1;
 #endif // #if LUA_OPTIMIZE_MEMORY > 0
 }
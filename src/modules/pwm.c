@@ -4,8 +4,15 @@
 #include "lualib.h"
 #include "lauxlib.h"
 #include "platform.h"
+#include "platform_conf.h"
+#include "common.h"
 #include "auxmods.h"
 #include "lrotable.h"
+#include <string.h>
+
+#if defined( BUILD_C_INT_HANDLERS ) && defined( INT_TMR_MATCH ) && ( INT_TMR_MATCH != ELUA_INT_INVALID_INTERRUPT )
+#define PWM_SEQ_SUPPORT
+#endif
 
 // Lua: realfrequency = setup( id, frequency, duty )
 static int pwm_setup( lua_State* L )
@@ -79,6 +86,143 @@ static int pwm_getclock( lua_State* L )
   return 1;
 }
 
+// Helper: return the channel at index 'idx' on the stack
+// (only integral numbers are accepted, not strings or fractional numbers)
+static unsigned pwmh_check_id( lua_State* L, int idx )
+{
+  lua_Number n;
+  unsigned id;
+
+  if( lua_type( L, idx ) != LUA_TNUMBER || ( n = lua_tonumber( L, idx ) ) < 0 || n >= NUM_PWM || ( id = ( unsigned )n ) != n )
+    return luaL_error( L, "invalid PWM channel" );
+  MOD_CHECK_ID( pwm, id );
+  return id;
+}
+
+// Helper: return the duty cycle at index 'idx' on the stack
+static u8 pwmh_check_duty( lua_State* L, int idx )
+{
+  lua_Integer duty;
+
+  if( !lua_isnumber( L, idx ) || ( duty = lua_tointeger( L, idx ) ) < 0 || duty > 100 )
+    return luaL_error( L, "duty cycle must be from 0 to 100" );
+  return ( u8 )duty;
+}
+
+// Lua: update( { [ id1 ] = duty1, [ id2 ] = duty2, ... } )
+static int pwm_update( lua_State* L )
+{
+  u8 ids[ NUM_PWM ], duties[ NUM_PWM ];
+  u8 seen[ ( NUM_PWM + 7 ) / 8 ];
+  unsigned n = 0, id;
+
+  luaL_checktype( L, 1, LUA_TTABLE );
+  memset( seen, 0, sizeof( seen ) );
+  lua_pushnil( L );
+  while( lua_next( L, 1 ) )
+  {
+    if( n == NUM_PWM )
+      return luaL_error( L, "too many PWM channels" );
+    id = pwmh_check_id( L, -2 );
+    if( seen[ id >> 3 ] & ( 1 << ( id & 7 ) ) )
+      return luaL_error( L, "PWM channel %d is used more than once", id );
+    seen[ id >> 3 ] |= 1 << ( id & 7 );
+    ids[ n ] = id;
+    duties[ n ++ ] = pwmh_check_duty( L, -1 );
+    lua_pop( L, 1 );
+  }
+  if( platform_pwm_update( n, ids, duties ) != PLATFORM_OK )
+    return luaL_error( L, "all the channels must be set up first" );
+  return 0;
+}
+
+#ifdef PWM_SEQ_SUPPORT
+// Lua: startseq( timer_id, period_us, ids, duties, [count] )
+// 'ids' is a table of channels, 'duties' is either an array.U8 with a duty
+// cycle for each channel for each step or a table of steps (tables of duty cycles)
+static int pwm_startseq( lua_State* L )
+{
+  unsigned tmr_id, count, nch, nsteps, i, j;
+  timer_data_type period;
+  u8 ids[ NUM_PWM ];
+  u8 *duties;
+  array_t *pa;
+  int res;
+
+  tmr_id = luaL_checkinteger( L, 1 );
+  MOD_CHECK_TIMER( tmr_id );
+  period = ( timer_data_type )luaL_checknumber( L, 2 );
+  luaL_checktype( L, 3, LUA_TTABLE );
+  count = ( unsigned )luaL_optinteger( L, 5, 0 );
+  nch = lua_objlen( L, 3 );
+  if( nch == 0 || nch > NUM_PWM )
+    return luaL_error( L, "invalid number of channels" );
+  for( i = 0; i < nch; i ++ )
+  {
+    lua_rawgeti( L, 3, i + 1 );
+    ids[ i ] = pwmh_check_id( L, -1 );
+    lua_pop( L, 1 );
+  }
+  if( array_isarray( L, 4 ) )
+  {
+    pa = array_check( L, 4 );
+    if( array_gettype( pa ) != ARRAY_U8 || array_getlen( pa ) == 0 || array_getlen( pa ) % nch )
+      return luaL_error( L, "duties must be an array.U8 with %d elements per step", nch );
+    duties = ( u8* )array_getdata( pa );
+    nsteps = array_getlen( pa ) / nch;
+    for( i = 0; i < nsteps * nch; i ++ )
+      if( duties[ i ] > 100 )
+        return luaL_error( L, "invalid duty cycle in step %d", i / nch + 1 );
+  }
+  else
+  {
+    luaL_checktype( L, 4, LUA_TTABLE );
+    if( ( nsteps = lua_objlen( L, 4 ) ) == 0 )
+      return luaL_error( L, "the sequence has no steps" );
+    duties = ( u8* )lua_newuserdata( L, nsteps * nch );
+    for( i = 0; i < nsteps; i ++ )
+    {
+      lua_rawgeti( L, 4, i + 1 );
+      if( !lua_istable( L, -1 ) || lua_objlen( L, -1 ) != nch )
+        return luaL_error( L, "invalid step %d", i + 1 );
+      for( j = 0; j < nch; j ++ )
+      {
+        lua_rawgeti( L, -1, j + 1 );
+        duties[ i * nch + j ] = pwmh_check_duty( L, -1 );
+        lua_pop( L, 1 );
+      }
+      lua_pop( L, 1 );
+    }
+  }
+  res = cmn_pwm_seq_start( tmr_id, period, nch, ids, duties, nsteps, count );
+  if( res == CMN_PWM_SEQ_NOT_SETUP )
+    return luaL_error( L, "all the channels must be set up first" );
+  else if( res == CMN_PWM_SEQ_NO_MEMORY )
+    return luaL_error( L, "not enough memory" );
+  else if( res == PLATFORM_TIMER_INT_TOO_SHORT )
+    return luaL_error( L, "timer interval too small" );
+  else if( res == PLATFORM_TIMER_INT_TOO_LONG )
+    return luaL_error( L, "timer interval too long" );
+  else if( res == PLATFORM_TIMER_INT_INVALID_ID )
+    return luaL_error( L, "match interrupt cannot be set on this timer" );
+  return 0;
+}
+
+// Lua: stopseq()
+static int pwm_stopseq( lua_State* L )
+{
+  cmn_pwm_seq_stop();
+  return 0;
+}
+
+// Lua: active = seqactive()
+static int pwm_seqactive( lua_State* L )
+{
+  lua_pushboolean( L, cmn_pwm_seq_is_active() );
+  return 1;
+}
+#endif // #ifdef PWM_SEQ_SUPPORT
+
 // Module function map
 #define MIN_OPT_LEVEL 2
 #include "lrodefs.h"
@@ -89,6 +233,12 @@ const LUA_REG_TYPE pwm_map[] =
   { LSTRKEY( "stop" ), LFUNCVAL( pwm_stop ) },
   { LSTRKEY( "setclock" ), LFUNCVAL( pwm_setclock ) },
   { LSTRKEY( "getclock" ), LFUNCVAL( pwm_getclock ) },
+  { LSTRKEY( "update" ), LFUNCVAL( pwm_update ) },
+#ifdef PWM_SEQ_SUPPORT
+  { LSTRKEY( "startseq" ), LFUNCVAL( pwm_startseq ) },
+  { LSTRKEY( "stopseq" ), LFUNCVAL( pwm_stopseq ) },
+  { LSTRKEY( "seqactive" ), LFUNCVAL( pwm_seqactive ) },
+#endif
   { LNILKEY, LNILVAL }
 };
 
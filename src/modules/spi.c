@@ -4,8 +4,57 @@
 #include "lualib.h"
 #include "lauxlib.h"
 #include "platform.h"
+#include "platform_conf.h"
 #include "auxmods.h"
 #include "lrotable.h"
+#include "utils.h"
+
+// Size of the intermediate buffer used when receiving into an array
+#define SPI_TRANSFER_CHUNK        32
+
+#define SPI_DEV_META_NAME         "eLua.spidev"
+#define SPI_DEV_NO_CS             ( -1 )
+#define spi_dev_check( L, idx )   ( spi_dev_t* )luaL_checkudata( L, idx, SPI_DEV_META_NAME )
+
+// Arguments of a transfer
+typedef struct
+{
+  const u8 *txdata;
+  size_t txlen;
+  u32 rxlen;
+  array_t *pa;
+  u8 *rxbuf;
+} spi_xfer_t;
+
+// Last configuration of each SPI interface
+typedef struct
+{
+  u32 clock;
+  u8 is_master, cpol, cpha, databits, valid;
+} spi_config_t;
+
+// SPI device
+typedef struct
+{
+  u32 clock;
+  u32 transfers, bytes;
+  s16 cs;
+  u8 id, cpol, cpha, databits;
+} spi_dev_t;
+
+static spi_config_t spi_configs[ NUM_SPI ];
+
+static void spi_config_set( unsigned id, int is_master, u32 clock, unsigned cpol, unsigned cpha, unsigned databits )
+{
+  spi_config_t *pcfg = spi_configs + id;
+
+  pcfg->is_master = is_master;
+  pcfg->clock = clock;
+  pcfg->cpol = cpol;
+  pcfg->cpha = cpha;
+  pcfg->databits = databits;
+  pcfg->valid = 1;
+}
 
 // Lua: sson( id )
 static int spi_sson( lua_State* L )
@@ -49,6 +98,7 @@ static int spi_setup( lua_State* L )
     return luaL_error( L, "invalid clock phase." );
   databits = luaL_checkinteger( L, 6 );
   res = platform_spi_setup( id, is_master, clock, cpol, cpha, databits );
+  spi_config_set( id, is_master, clock, cpol, cpha, databits );
   lua_pushinteger( L, res );
   return 1;
 }
@@ -79,6 +129,11 @@ static int spi_rw_helper( lua_State *L, int withread )
     else if( lua_isstring( L, i ) )
     {
       sval = lua_tolstring( L, i, &len );
+      if( !withread )
+      {
+        platform_spi_send_recv_block( id, ( const u8* )sval, NULL, len );
+        continue;
+      }
       for( j = 0; j < len; j ++ )
       {
         value = platform_spi_send_recv( id, sval[ j ] );
@@ -105,6 +160,243 @@ static int spi_readwrite( lua_State* L )
   return spi_rw_helper( L, 1 );
 }
 
+// Helper: get the arguments of a transfer from the stack ('txidx' is the data to
+// send, 'rxidx' is the number of bytes to receive or the array that receives them)
+static void spi_check_xfer( lua_State *L, int txidx, int rxidx, spi_xfer_t *px )
+{
+  lua_Integer reqlen;
+
+  px->txdata = ( const u8* )luaL_optlstring( L, txidx, "", &px->txlen );
+  px->pa = NULL;
+  if( array_isarray( L, rxidx ) )
+  {
+    px->pa = array_check( L, rxidx );
+    px->rxlen = array_getlen( px->pa );
+  }
+  else
+  {
+    if( ( reqlen = luaL_optinteger( L, rxidx, px->txlen ) ) < 0 )
+      luaL_error( L, "invalid receive length" );
+    px->rxlen = ( u32 )reqlen;
+  }
+}
+
+// Helper: allocate the receive buffer of a transfer (a userdata left on the stack
+// until spi_push_xfer), so that no Lua error can be raised while the transfer
+// runs with a device selected
+static void spi_prep_xfer( lua_State *L, spi_xfer_t *px )
+{
+  px->rxbuf = px->pa ? NULL : ( u8* )lua_newuserdata( L, px->rxlen );
+}
+
+// Helper: execute a transfer prepared by spi_prep_xfer. Returns the number of 
+// bytes transferred.
+static u32 spi_do_xfer( unsigned id, spi_xfer_t *px )
+{
+  u8 *rxdata, buf[ SPI_TRANSFER_CHUNK ];
+  u32 total, pos, n, i;
+
+  total = UMAX( px->txlen, px->rxlen );
+  // Transfer in chunks that don't cross the end of the TX or RX data
+  for( pos = 0; pos < total; pos += n )
+  {
+    n = px->pa ? UMIN( total - pos, SPI_TRANSFER_CHUNK ) : total - pos;
+    if( pos < px->txlen )
+      n = UMIN( n, px->txlen - pos );
+    if( pos < px->rxlen )
+    {
+      n = UMIN( n, px->rxlen - pos );
+      rxdata = px->pa ? buf : px->rxbuf + pos;
+    }
+    else
+      rxdata = NULL;
+    platform_spi_send_recv_block( id, pos < px->txlen ? px->txdata + pos : NULL, rxdata, n );
+    if( rxdata != NULL && px->pa )
+      for( i = 0; i < n; i ++ )
+        array_setint( px->pa, pos + i, buf[ i ] );
+  }
+  return total;
+}
+
+// Helper: push the result of a transfer (the received data as a string or the
+// number of bytes written in the array) in place of its receive buffer
+static void spi_push_xfer( lua_State *L, spi_xfer_t *px )
+{
+  if( px->pa )
+    lua_pushinteger( L, px->rxlen );
+  else
+  {
+    lua_pushlstring( L, ( const char* )px->rxbuf, px->rxlen );
+    lua_remove( L, -2 );
+  }
+}
+
+// Lua: rxdata = transfer( id, txdata, [rxlen] )
+//      count = transfer( id, txdata, array )
+// 'txdata' can be nil for a read-only transfer. If more bytes are received than
+// sent, 0xFF is sent for the remaining bytes.
+static int spi_transfer( lua_State *L )
+{
+  spi_xfer_t xfer;
+  unsigned id;
+
+  id = luaL_checkinteger( L, 1 );
+  MOD_CHECK_ID( spi, id );
+  spi_check_xfer( L, 2, 3, &xfer );
+  spi_prep_xfer( L, &xfer );
+  spi_do_xfer( id, &xfer );
+  spi_push_xfer( L, &xfer );
+  return 1;
+}
+
+// ****************************************************************************
+// SPI devices: an interface configuration and a chip select pin that are 
+// applied automatically around each transfer
+
+// Helper: configure the interface for the given device (if needed)
+static void spi_dev_configure( spi_dev_t *pdev )
+{
+  spi_config_t *pcfg = spi_configs + pdev->id;
+
+  if( pcfg->valid && pcfg->is_master && pcfg->clock == pdev->clock && pcfg->cpol == pdev->cpol &&
+      pcfg->cpha == pdev->cpha && pcfg->databits == pdev->databits )
+    return;
+  platform_spi_setup( pdev->id, PLATFORM_SPI_MASTER, pdev->clock, pdev->cpol, pdev->cpha, pdev->databits );
+  spi_config_set( pdev->id, 1, pdev->clock, pdev->cpol, pdev->cpha, pdev->databits );
+}
+
+// Helper: select/deselect the given device
+static void spi_dev_select( spi_dev_t *pdev, int is_select )
+{
+#if NUM_PIO > 0
+  if( pdev->cs != SPI_DEV_NO_CS )
+  {
+    // The chip select pin is active low
+    platform_pio_op( PLATFORM_IO_GET_PORT( pdev->cs ), 1 << PLATFORM_IO_GET_PIN( pdev->cs ),
+                     is_select ? PLATFORM_IO_PIN_CLEAR : PLATFORM_IO_PIN_SET );
+    return;
+  }
+#endif
+  platform_spi_select( pdev->id, is_select ? PLATFORM_SPI_SELECT_ON : PLATFORM_SPI_SELECT_OFF );
+}
+
+// Helper: execute a complete transaction on a device and push its result. The
+// device is deselected before anything that could raise a Lua error.
+static void spi_dev_xfer( lua_State *L, spi_dev_t *pdev, spi_xfer_t *px )
+{
+  spi_prep_xfer( L, px );
+  spi_dev_configure( pdev );
+  spi_dev_select( pdev, 1 );
+  pdev->bytes += spi_do_xfer( pdev->id, px );
+  spi_dev_select( pdev, 0 );
+  pdev->transfers ++;
+  spi_push_xfer( L, px );
+}
+
+// Lua: dev = device( id, clock, cpol, cpha, databits, [cs] )
+// 'cs' is a pin (for example pio.PA_3) used as an active low chip select. If not
+// given, the dedicated SS pin of the interface is used (see spi.sson/spi.ssoff).
+static int spi_device( lua_State *L )
+{
+  spi_dev_t *pdev;
+  unsigned id, cpol, cpha;
+  int cs = SPI_DEV_NO_CS;
+
+  id = luaL_checkinteger( L, 1 );
+  MOD_CHECK_ID( spi, id );
+  cpol = luaL_checkinteger( L, 3 );
+  if( ( cpol != 0 ) && ( cpol != 1 ) )
+    return luaL_error( L, "invalid clock polarity." );
+  cpha = luaL_checkinteger( L, 4 );
+  if( ( cpha != 0 ) && ( cpha != 1 ) )
+    return luaL_error( L, "invalid clock phase." );
+  if( !lua_isnoneornil( L, 6 ) )
+  {
+#if NUM_PIO > 0
+    cs = luaL_checkinteger( L, 6 );
+    if( PLATFORM_IO_IS_PORT( cs ) || !platform_pio_has_port( PLATFORM_IO_GET_PORT( cs ) ) ||
+        !platform_pio_has_pin( PLATFORM_IO_GET_PORT( cs ), PLATFORM_IO_GET_PIN( cs ) ) )
+      return luaL_error( L, "invalid chip select pin" );
+#else
+    return luaL_error( L, "chip select pins are not supported" );
+#endif
+  }
+  pdev = ( spi_dev_t* )lua_newuserdata( L, sizeof( spi_dev_t ) );
+  pdev->id = id;
+  pdev->clock = luaL_checkinteger( L, 2 );
+  pdev->cpol = cpol;
+  pdev->cpha = cpha;
+  pdev->databits = luaL_checkinteger( L, 5 );
+  pdev->cs = cs;
+  pdev->transfers = pdev->bytes = 0;
+  luaL_getmetatable( L, SPI_DEV_META_NAME );
+  lua_setmetatable( L, -2 );
+  // Start with the device deselected
+#if NUM_PIO > 0
+  if( cs != SPI_DEV_NO_CS )
+  {
+    spi_dev_select( pdev, 0 );
+    platform_pio_op( PLATFORM_IO_GET_PORT( cs ), 1 << PLATFORM_IO_GET_PIN( cs ), PLATFORM_IO_PIN_DIR_OUTPUT );
+  }
+#endif
+  return 1;
+}
+
+// Lua: rxdata = dev:transfer( txdata, [rxlen] )
+//      count = dev:transfer( txdata, array )
+static int spi_dev_transfer( lua_State *L )
+{
+  spi_dev_t *pdev = spi_dev_check( L, 1 );
+  spi_xfer_t xfer;
+
+  spi_check_xfer( L, 2, 3, &xfer );
+  spi_dev_xfer( L, pdev, &xfer );
+  return 1;
+}
+
+// Lua: transfers, bytes = dev:stats( [reset] )
+static int spi_dev_stats( lua_State *L )
+{
+  spi_dev_t *pdev = spi_dev_check( L, 1 );
+
+  lua_pushinteger( L, pdev->transfers );
+  lua_pushinteger( L, pdev->bytes );
+  if( lua_toboolean( L, 2 ) )
+    pdev->transfers = pdev->bytes = 0;
+  return 2;
+}
+
+// Lua: rxdata1, rxdata2, ... = batch( { { dev1, txdata1, [rxlen1] }, { dev2, txdata2, [rxlen2] }, ... } )
+// Executes all the transactions in order, returns the result of each transaction
+// (the same as dev:transfer)
+static int spi_batch( lua_State *L )
+{
+  int i, total, top;
+  spi_dev_t *pdev;
+  spi_xfer_t xfer;
+
+  luaL_checktype( L, 1, LUA_TTABLE );
+  total = lua_objlen( L, 1 );
+  luaL_checkstack( L, total + 4, "too many transactions" );
+  for( i = 1; i <= total; i ++ )
+  {
+    lua_rawgeti( L, 1, i );
+    if( !lua_istable( L, -1 ) )
+      return luaL_error( L, "invalid transaction at position %d", i );
+    top = lua_gettop( L );
+    lua_rawgeti( L, top, 1 );
+    lua_rawgeti( L, top, 2 );
+    lua_rawgeti( L, top, 3 );
+    pdev = spi_dev_check( L, top + 1 );
+    spi_check_xfer( L, top + 2, top + 3, &xfer );
+    spi_dev_xfer( L, pdev, &xfer );
+    // Keep only the result on the stack
+    lua_replace( L, top );
+    lua_settop( L, top );
+  }
+  return total;
+}
+
 // Module function map
 #define MIN_OPT_LEVEL 2
 #include "lrodefs.h"
@@ -115,6 +407,9 @@ const LUA_REG_TYPE spi_map[] =
   { LSTRKEY( "ssoff" ),  LFUNCVAL( spi_ssoff ) },
   { LSTRKEY( "write" ),  LFUNCVAL( spi_write ) },  
   { LSTRKEY( "readwrite" ),  LFUNCVAL( spi_readwrite ) },    
+  { LSTRKEY( "transfer" ),  LFUNCVAL( spi_transfer ) },
+  { LSTRKEY( "device" ),  LFUNCVAL( spi_device ) },
+  { LSTRKEY( "batch" ),  LFUNCVAL( spi_batch ) },
 #if LUA_OPTIMIZE_MEMORY > 0
   { LSTRKEY( "MASTER" ), LNUMVAL( PLATFORM_SPI_MASTER ) } ,
   { LSTRKEY( "SLAVE" ), LNUMVAL( PLATFORM_SPI_SLAVE ) },
@@ -122,11 +417,27 @@ const LUA_REG_TYPE spi_map[] =
   { LNILKEY, LNILVAL }
 };
 
+static const LUA_REG_TYPE spi_dev_mt_map[] =
+{
+  { LSTRKEY( "transfer" ), LFUNCVAL( spi_dev_transfer ) },
+  { LSTRKEY( "stats" ), LFUNCVAL( spi_dev_stats ) },
+#if LUA_OPTIMIZE_MEMORY > 0
+  { LSTRKEY( "__index" ), LROVAL( spi_dev_mt_map ) },
+#endif
+  { LNILKEY, LNILVAL }
+};
+
 LUALIB_API int luaopen_spi( lua_State *L )
 {
 #if LUA_OPTIMIZE_MEMORY > 0
+  luaL_rometatable( L, SPI_DEV_META_NAME, ( void* )spi_dev_mt_map );
   return 0;
 #else // #if LUA_OPTIMIZE_MEMORY > 0
+  luaL_newmetatable( L, SPI_DEV_META_NAME );
+  luaL_register( L, NULL, spi_dev_mt_map );
+  lua_pushvalue( L, -1 );
+  lua_setfield( L, -2, "__index" );
+  lua_pop( L, 1 );
   luaL_register( L, AUXLIB_SPI, spi_map );
   
   // Add the MASTER and SLAVE constants (for spi.setup)
@@ -16,6 +16,10 @@
 #define HAS_TMR_MATCH_INT
 #endif
 
+#if defined( BUILD_LUA_INT_HANDLERS ) && defined( INT_TMR_SW ) && SWTMR_NUM_TIMERS > 0
+#define HAS_TMR_SCHEDULE
+#endif
+
 // Helper function for the read/start functions
 static int tmrh_timer_op( lua_State* L, int op )
 {
@@ -156,6 +160,116 @@ static int tmr_set_match_int( lua_State *L )
 }
 #endif // #ifdef HAS_TMR_MATCH_INT
 
+#ifdef HAS_TMR_SCHEDULE
+// The Lua callbacks of the software timers are kept in a table in the registry,
+// indexed by timer handle. The handles of the timers started from Lua are also
+// kept here, so they can be released when a new Lua state is created.
+static u16 tmr_sw_handles[ SWTMR_NUM_TIMERS ];
+#define TMR_SW_CALLBACKS_KEY    ( int )&tmr_sw_handles
+
+// Helper: stop a timer started from Lua
+static void tmrh_sw_stop( lua_State *L, int handle )
+{
+  cmn_swtmr_stop( handle );
+  if( tmr_sw_handles[ SWTMR_GET_ID( handle ) ] == handle )
+    tmr_sw_handles[ SWTMR_GET_ID( handle ) ] = 0;
+  lua_pushnil( L );
+  lua_rawseti( L, -2, handle );
+}
+
+// INT_TMR_SW handler: call the Lua callback of the timer
+static int tmr_sw_dispatch( lua_State *L )
+{
+  int handle = ( int )luaL_checkinteger( L, 1 );
+  int periodic = cmn_swtmr_is_periodic( handle );
+
+  // Ignore the interrupts of canceled timers
+  if( periodic == -1 )
+    return 0;
+  lua_rawgeti( L, LUA_REGISTRYINDEX, TMR_SW_CALLBACKS_KEY );
+  if( !lua_istable( L, -1 ) )
+    return 0;
+  lua_rawgeti( L, -1, handle );
+  lua_insert( L, -2 );
+  // One shot timers are released after they expire
+  if( !periodic )
+    tmrh_sw_stop( L, handle );
+  lua_pop( L, 1 );
+  if( !lua_isnil( L, -1 ) )
+  {
+    lua_pushinteger( L, handle );
+    lua_call( L, 1, 0 );
+  }
+  return 0;
+}
+
+// Helper: push the callbacks table, creating it (and installing the INT_TMR_SW
+// handler) if needed
+static void tmrh_sw_get_callbacks( lua_State *L )
+{
+  unsigned i;
+
+  lua_rawgeti( L, LUA_REGISTRYINDEX, TMR_SW_CALLBACKS_KEY );
+  if( !lua_isnil( L, -1 ) )
+    return;
+  lua_pop( L, 1 );
+  // Release the timers left running by a previous Lua state
+  for( i = 0; i < SWTMR_NUM_TIMERS; i ++ )
+    if( tmr_sw_handles[ i ] )
+    {
+      cmn_swtmr_stop( tmr_sw_handles[ i ] );
+      tmr_sw_handles[ i ] = 0;
+    }
+  lua_newtable( L );
+  lua_pushvalue( L, -1 );
+  lua_rawseti( L, LUA_REGISTRYINDEX, TMR_SW_CALLBACKS_KEY );
+  // Install the interrupt handler that calls the callbacks
+  lua_rawgeti( L, LUA_REGISTRYINDEX, LUA_INT_HANDLER_KEY );
+  lua_rawgeti( L, -1, INT_TMR_SW );
+  if( lua_isnil( L, -1 ) )
+  {
+    lua_pushcfunction( L, tmr_sw_dispatch );
+    lua_rawseti( L, -3, INT_TMR_SW );
+    elua_int_enable( INT_TMR_SW );
+  }
+  lua_pop( L, 2 );
+}
+
+// Lua: handle = schedule( delay_us, f, [periodic] )
+static int tmr_schedule( lua_State *L )
+{
+  lua_Number ndelay = luaL_checknumber( L, 1 );
+  int periodic = lua_toboolean( L, 3 );
+  timer_data_type delay;
+  int handle;
+
+  if( ndelay < 0 || ndelay > PLATFORM_TIMER_SYS_MAX )
+    return luaL_argerror( L, 1, "invalid delay" );
+  delay = ( timer_data_type )ndelay;
+  if( periodic && delay == 0 )
+    return luaL_argerror( L, 1, "periodic timers need a delay greater than 0" );
+  luaL_checkanyfunction( L, 2 );
+  tmrh_sw_get_callbacks( L );
+  if( ( handle = cmn_swtmr_start( delay, periodic ? delay : 0 ) ) == -1 )
+    return luaL_error( L, "no software timer available" );
+  tmr_sw_handles[ SWTMR_GET_ID( handle ) ] = handle;
+  lua_pushvalue( L, 2 );
+  lua_rawseti( L, -2, handle );
+  lua_pushinteger( L, handle );
+  return 1;
+}
+
+// Lua: cancel( handle )
+static int tmr_cancel( lua_State *L )
+{
+  int handle = ( int )luaL_checkinteger( L, 1 );
+
+  tmrh_sw_get_callbacks( L );
+  tmrh_sw_stop( L, handle );
+  return 0;
+}
+#endif // #ifdef HAS_TMR_SCHEDULE
+
 #if VTMR_NUM_TIMERS > 0
 // __index metafunction for TMR
 // Look for all VIRTx timer identifiers
@@ -196,6 +310,10 @@ const LUA_REG_TYPE tmr_map[] =
 #ifdef HAS_TMR_MATCH_INT
   { LSTRKEY( "set_match_int" ), LFUNCVAL( tmr_set_match_int ) },
 #endif  
+#ifdef HAS_TMR_SCHEDULE
+  { LSTRKEY( "schedule" ), LFUNCVAL( tmr_schedule ) },
+  { LSTRKEY( "cancel" ), LFUNCVAL( tmr_cancel ) },
+#endif
 #if LUA_OPTIMIZE_MEMORY > 0 && VTMR_NUM_TIMERS > 0
   { LSTRKEY( "__metatable" ), LROVAL( tmr_map ) },
 #endif
@@ -94,7 +94,28 @@ static int uart_write( lua_State* L )
   return 0;
 }
 
+// Helper for uart.read: fill the array at index 2 with received bytes
+static int uart_read_array( lua_State* L, int id )
+{
+  array_t *pa = array_check( L, 2 );
+  unsigned timer_id = PLATFORM_TIMER_SYS_ID;
+  timer_data_type timeout = PLATFORM_TIMER_INF_TIMEOUT;
+  u32 count, len = array_getlen( pa );
+  int res;
+
+  uart_get_timeout_data( L, 3, &timeout, &timer_id );
+  for( count = 0; count < len; count ++ )
+  {
+    if( ( res = platform_uart_recv( id, timer_id, timeout ) ) == -1 )
+      break;
+    array_setint( pa, count, res );
+  }
+  lua_pushinteger( L, count );
+  return 1;
+}
+
 // Lua: uart.read( id, format, [timeout], [timer_id] )
+//      count = uart.read( id, array, [timeout], [timer_id] )
 static int uart_read( lua_State* L )
 {
   int id, res, mode, issign;
@@ -108,6 +129,10 @@ static int uart_read( lua_State* L )
   id = luaL_checkinteger( L, 1 );
   MOD_CHECK_ID( uart, id );
 
+  // Read directly into a packed array if one was given
+  if( array_isarray( L, 2 ) )
+    return uart_read_array( L, id );
+
   // Check format
   if( lua_isnumber( L, 2 ) )
   {
@@ -29,12 +29,15 @@ static _ssize_t std_read( struct _reent *r, int fd, void* vptr, size_t len, void
 
   // Get (and wait for) socket
   while( ( sock = elua_net_get_telnet_socket() ) == - 1 );
+
+  // Send the output that waits to be sent (for example the prompt)
+  elua_net_telnet_flush();
   
   // Read data
   actsize = 0;
   while( 1 )
   {
-    pktsize = elua_net_recv( sock, lptr, len, -1, 0, 0 );
+    pktsize = elua_net_recv( sock, lptr, len, -1, 0, PLATFORM_TIMER_INF_TIMEOUT );
     // Check EOF
     for( j = 0; j < pktsize; j ++ )
       if( lptr[ j ] == STD_CTRLZ_CODE )
@@ -69,7 +72,7 @@ static _ssize_t std_write( struct _reent *r, int fd, const void* vptr, size_t le
   // Get (and wait for) socket
   while( ( sock = elua_net_get_telnet_socket() ) == - 1 );  
   
-  // Send data
+  // Send data (it is coalesced with the next writes, see elua_net_telnet_flush)
   elua_net_send( sock, vptr, len );
   return len;
 }
@@ -358,9 +358,30 @@ pid_t getpid( void )
 }
 
 #include <sys/times.h>
+#include <time.h>
+// The system timer (if available) is used as the process time, so that clock()
+// and Lua's os.clock() can be used to measure time intervals. The time is
+// accumulated from the differences between the calls, so it doesn't jump back
+// when a 32-bit system timer wraps (if clock() is called at least once per
+// wrap period, about 71 minutes)
+static timer_data_type times_last;
+static u64 times_us;
+
 clock_t _times_r( struct _reent* r, struct tms *buf )
 {
-  return 0;
+  timer_data_type now = platform_timer_read_sys();
+  clock_t t;
+
+  times_us += platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, times_last, now );
+  times_last = now;
+  t = ( clock_t )( times_us / ( 1000000 / CLOCKS_PER_SEC ) );
+
+  if( buf )
+  {
+    buf->tms_utime = t;
+    buf->tms_stime = buf->tms_cutime = buf->tms_cstime = 0;
+  }
+  return t;
 }
 
 int _link_r( struct _reent *r, const char *c1, const char *c2 )
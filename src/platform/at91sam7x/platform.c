@@ -429,7 +429,7 @@ u32 platform_pwm_set_clock( unsigned id, u32 clock )
   return platform_pwm_get_clock( id );
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   u32 pwmclk = platform_pwm_get_clock( id );
   u32 period;  
@@ -858,7 +858,10 @@ __attribute__((__interrupt__)) static void adc_int_handler()
       d->sample_buf[ d->seq_ctr ] = ( u16 )adc_get_value(adc, s->id );
       s->value_fresh = 1;
 
-      if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+      // Run the filter stage, the sample is dropped if it doesn't produce an output
+      if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+        s->value_fresh = 0;
+      else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
         adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
       else if ( s->reqsamples > 1 )
@@ -954,7 +957,7 @@ static const gpio_map_t pwm_pins =
  * "duty" (0-100).  0 means low all the time, 100 high all the time.
  * Return actual frequency set.
  */
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   u32 pwmclk;        // base clock frequency for PWM counters
   u32 period;        // number of base clocks per cycle
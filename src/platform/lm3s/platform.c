@@ -374,7 +374,7 @@ int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data
   return PLATFORM_OK;
 }
 
-int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
 {
   // wait for a message
   if( can_rx_flag != 0 )
@@ -776,7 +776,7 @@ u32 platform_pwm_set_clock( unsigned id, u32 clock )
   return sysclk / pwm_div_data[ min_i ];
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   u32 pwmclk = platform_pwm_get_clock( id );
   u32 period;
@@ -881,8 +881,11 @@ void ADCIntHandler( void )
     d->sample_buf[ d->seq_ctr ] = ( u16 )tmpbuff[ d->seq_ctr ];
     s->value_fresh = 1; // Mark sample as fresh
     
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
     // Fill in smoothing buffer until warmed up
-    if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
       adc_smooth_data( s->id );
 
 #if defined( BUF_ENABLE_ADC )
@@ -104,9 +104,25 @@ typedef unsigned short uip_stats_t;
 //#define UIP_CONF_RECEIVE_WINDOW     400
 
 //
-// Size of ARP table
+// Maximum unacknowledged data in transit on a TCP connection (0 for a
+// single segment)
 //
-#define UIP_CONF_ARPTAB_SIZE        4
+#define UIP_CONF_TCP_SND_WND        ( 2 * UIP_TCP_MSS )
+
+//
+// Advertise the room left in the receive buffer of each connection (needed by
+// the receive rings of the eLua sockets)
+//
+#define UIP_CONF_TCP_RCV_WND        1
+
+//
+// Size of ARP table (the 'arp_size' attribute of the 'tcpip' component)
+//
+#ifdef ELUA_NET_ARP_SIZE
+#define UIP_CONF_ARPTAB_SIZE        ELUA_NET_ARP_SIZE
+#else
+#define UIP_CONF_ARPTAB_SIZE        8
+#endif
 
 //
 // uIP buffer size.
@@ -133,6 +149,12 @@ typedef unsigned short uip_stats_t;
 //
 #define UIP_CONF_LLH_LEN            14
 
+//
+// Word-at-a-time checksum (src/uip/uip_chksum.c)
+//
+#define UIP_ARCH_CHKSUM             1
+#define UIP_CONF_CHKSUM_THUMB2      1
+
 //
 // CPU byte order.
 //
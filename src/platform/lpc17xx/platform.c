@@ -423,7 +423,10 @@ void ADC_IRQHandler(void)
     d->sample_buf[ d->seq_ctr ] = ( u16 )ADC_ChannelGetData( LPC_ADC, s->id );
     s->value_fresh = 1;
             
-    if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
       adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
     else if ( s->reqsamples > 1 )
@@ -626,7 +629,7 @@ static void platform_setup_pwm()
   platform_pwm_set_clock( 0, 1000000 );
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   PWM_MATCHCFG_Type PWMMatchCfgDat;
   u32 divisor = platform_pwm_get_clock( id ) / frequency - 1;
@@ -794,7 +797,7 @@ int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data
   return PLATFORM_OK;
 }
 
-int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
 {
   // wait for a message
   if( can_rx_flag[id] != 0 )
@@ -611,7 +611,10 @@ static void adc_int_handler()
     AD0CR &= 0xF8FFFF00;        // stop ADC, disable channels
     s->value_fresh = 1;
             
-    if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
       adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
     else if ( s->reqsamples > 1 )
@@ -862,7 +865,7 @@ static void platform_setup_pwm()
   }
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   unsigned pwmid = id / 6, chid = id % 6;
   PREG PWMxMR0 = pwmid == 0 ? ( PREG )&PWM0MR0 : ( PREG )&PWM1MR0;
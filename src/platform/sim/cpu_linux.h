@@ -3,14 +3,19 @@
 #ifndef __CPU_LINUX_H__
 #define __CPU_LINUX_H__
 
+#include "platform_ints.h"
+
 // Number of resources (0 if not available/not implemented)
-#define NUM_PIO               0
-#define NUM_SPI               0
+#define NUM_PIO               2
+#define NUM_SPI               1
 #define NUM_UART              0
 #define NUM_TIMER             0
 #define NUM_PWM               0
-#define NUM_ADC               0
-#define NUM_CAN               0
+#define NUM_ADC               4
+#define NUM_CAN               1
+#define NUM_I2C               1
+
+#define ADC_BIT_RESOLUTION    12
 
 // PIO prefix ('0' for P0, P1, ... or 'A' for PA, PB, ...)
 #define PIO_PREFIX            'A'
@@ -18,7 +23,7 @@
 // #define PIO_PINS_PER_PORT (n) if each port has the same number of pins, or
 // #define PIO_PIN_ARRAY { n1, n2, ... } to define pins per port in an array
 // Use #define PIO_PINS_PER_PORT 0 if this isn't needed
-#define PIO_PINS_PER_PORT     0
+#define PIO_PINS_PER_PORT     32
 
 // Allocator data: define your free memory zones here in two arrays
 // (start address and end address)
@@ -28,5 +33,11 @@ extern void *memory_end_address;
 #define INTERNAL_RAM1_FIRST_FREE ( void* )memory_start_address
 #define INTERNAL_RAM1_LAST_FREE  ( void* )memory_end_address
 
+// Interrupt list for this CPU
+#define PLATFORM_CPU_CONSTANTS_INTS\
+  _C( INT_CAN_RX ),           \
+  _C( INT_TMR_SW ),           \
+  _C( INT_NET_EVENT ),
+
 #endif
 
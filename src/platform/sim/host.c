@@ -8,6 +8,9 @@
 #define __NR_close            6
 #define __NR_gettimeofday     78
 #define __NR_lseek            19
+#define __NR_unlink           10
+#define __NR_socketcall       102
+#define __NR_sched_yield      158
 
 int host_errno = 0;
 
@@ -19,6 +22,16 @@ int host_errno = 0;
 	return (type) (res); \
 } while(0)
 
+#define _syscall0(type,name) \
+type host_##name(void) \
+{ \
+long __res; \
+__asm__ volatile ("int $0x80" \
+        : "=a" (__res) \
+        : "0" (__NR_##name)); \
+__syscall_return(type,__res); \
+}
+
 #define _syscall1(type,name,type1,arg1) \
 type host_##name(type1 arg1) \
 { \
@@ -72,4 +85,7 @@ _syscall1(void, exit, int, status);
 _syscall1(int, close, int, status);
 _syscall2(int, gettimeofday, struct timeval*, tv, struct timezone*, tz);
 _syscall3(long, lseek, int, fd, long, offset, int, whence );
+_syscall1(int, unlink, const char*, pathname);
+_syscall2(int, socketcall, int, call, unsigned long*, args);
+_syscall0(int, sched_yield);
 
@@ -14,6 +14,9 @@ ssize_t host_write( int fd, const void * buf, size_t count );
 int host_open( const char *name, int flags, mode_t mode );
 int host_close( int fd );
 long host_lseek( int fd, long pos, int whence );
+int host_unlink( const char *pathname );
+int host_socketcall( int call, unsigned long *args );
+int host_sched_yield( void );
 
 #define PROT_READ 0x1   /* Page can be read.  */
 #define PROT_WRITE  0x2   /* Page can be written.  */
@@ -31,6 +34,21 @@ long host_lseek( int fd, long pos, int whence );
 
 #define MAP_FAILED (void *)(-1)
 
+// Socket functions (arguments of "socketcall") and flags
+#define SYS_SOCKET    1
+#define SYS_BIND      2
+#define SYS_SENDTO    11
+#define SYS_RECVFROM  12
+
+#define AF_UNIX       1
+#define SOCK_DGRAM    2
+#define MSG_DONTWAIT  0x40
+
+// Host error codes (they don't match the ones in errno.h)
+#define HOST_EAGAIN         11
+#define HOST_EADDRINUSE     98
+#define HOST_ECONNREFUSED   111
+
 void *host_mmap2(void *addr, size_t length, int prot, int flags, int fd, off_t pgoffset);
 int host_gettimeofday( struct timeval *tv, struct timezone *tz );
 void host_exit(int status);
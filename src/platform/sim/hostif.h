@@ -38,5 +38,19 @@ long hostif_lseek( int fd, long pos, int whence );
 // Get time
 s64 hostif_gettime();
 
+// Open a datagram socket bound to 'path' (a socket left behind by a program
+// that is no longer running is replaced)
+int hostif_dgram_open( const char *path );
+
+// Send a datagram to the socket bound to 'path', waiting at most 'wait_us'
+// microseconds for room in its receive queue
+int hostif_dgram_send( int fd, const char *path, const void *buf, unsigned count, unsigned wait_us );
+
+// Receive a datagram without waiting (-1 if there is no datagram)
+int hostif_dgram_recv( int fd, void *buf, unsigned count );
+
+// Let the other host processes run
+void hostif_yield( void );
+
 #endif // __HOSTIO_H__
 
@@ -78,3 +78,85 @@ s64 hostif_gettime()
   return ( s64 )tv.tv_sec * 1000000 + tv.tv_usec;
 }
 
+
+// Datagram sockets (UNIX domain)
+
+struct host_sockaddr_un
+{
+  unsigned short sun_family;
+  char sun_path[ 108 ];
+};
+
+// Helper: fill a socket address, return its length
+static unsigned hostif_dgram_addr( struct host_sockaddr_un *paddr, const char *path )
+{
+  paddr->sun_family = AF_UNIX;
+  strncpy( paddr->sun_path, path, sizeof( paddr->sun_path ) - 1 );
+  paddr->sun_path[ sizeof( paddr->sun_path ) - 1 ] = '\0';
+  return sizeof( paddr->sun_family ) + strlen( paddr->sun_path ) + 1;
+}
+
+int hostif_dgram_open( const char *path )
+{
+  struct host_sockaddr_un addr;
+  unsigned long args[ 3 ];
+  int fd;
+
+  args[ 0 ] = AF_UNIX;
+  args[ 1 ] = SOCK_DGRAM;
+  args[ 2 ] = 0;
+  if( ( fd = host_socketcall( SYS_SOCKET, args ) ) < 0 )
+    return -1;
+  args[ 0 ] = fd;
+  args[ 1 ] = ( unsigned long )&addr;
+  args[ 2 ] = hostif_dgram_addr( &addr, path );
+  if( host_socketcall( SYS_BIND, args ) == 0 )
+    return fd;
+  // If the socket is in use, check if there's still someone listening on it
+  // (an empty datagram is ignored by the receiver)
+  if( host_errno == HOST_EADDRINUSE && hostif_dgram_send( fd, path, "", 0, 0 ) < 0 && host_errno == HOST_ECONNREFUSED )
+  {
+    host_unlink( path );
+    if( host_socketcall( SYS_BIND, args ) == 0 )
+      return fd;
+  }
+  host_close( fd );
+  return -1;
+}
+
+int hostif_dgram_send( int fd, const char *path, const void *buf, unsigned count, unsigned wait_us )
+{
+  struct host_sockaddr_un addr;
+  unsigned long args[ 6 ];
+  s64 start = hostif_gettime();
+  int res;
+
+  args[ 0 ] = fd;
+  args[ 1 ] = ( unsigned long )buf;
+  args[ 2 ] = count;
+  args[ 3 ] = MSG_DONTWAIT;
+  args[ 4 ] = ( unsigned long )&addr;
+  args[ 5 ] = hostif_dgram_addr( &addr, path );
+  // Let the receiver run while its queue is full
+  while( ( res = host_socketcall( SYS_SENDTO, args ) ) < 0 && host_errno == HOST_EAGAIN && hostif_gettime() - start < wait_us )
+    host_sched_yield();
+  return res;
+}
+
+int hostif_dgram_recv( int fd, void *buf, unsigned count )
+{
+  unsigned long args[ 6 ];
+
+  args[ 0 ] = fd;
+  args[ 1 ] = ( unsigned long )buf;
+  args[ 2 ] = count;
+  args[ 3 ] = MSG_DONTWAIT;
+  args[ 4 ] = 0;
+  args[ 5 ] = 0;
+  return host_socketcall( SYS_RECVFROM, args );
+}
+
+void hostif_yield( void )
+{
+  host_sched_yield();
+}
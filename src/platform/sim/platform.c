@@ -8,12 +8,23 @@
 #include <reent.h>
 #include <errno.h>
 #include <string.h>
+#include <stdio.h>
 #include <ctype.h>
 #include "term.h"
+#include "common.h"
+#include "elua_adc.h"
+#include "elua_net.h"
+#include <math.h>
 
 // Platform specific includes
 #include "hostif.h"
 
+#ifdef BUILD_UIP
+#include "elua_uip.h"
+#include "uip.h"
+#include "uip_arp.h"
+#endif
+
 // ****************************************************************************
 // Terminal support code
 
@@ -95,6 +106,21 @@ void platform_ll_init( void )
   memory_end_address = memory_start_address + MEM_LENGTH;
 }
 
+#ifdef BUILD_ADC
+static void sim_adc_init( void );
+#endif
+
+#ifdef BUILD_UIP
+static void sim_eth_init( void );
+#endif
+
+// The system timer is the host time in microseconds, wrapped at the same
+// value as the system timer of a real target
+static timer_data_type sim_timer_get_sys( void )
+{
+  return ( timer_data_type )( ( u64 )hostif_gettime() % ( ( u64 )PLATFORM_TIMER_SYS_MAX + 1 ) );
+}
+
 int platform_init()
 { 
   if( memory_start_address == NULL ) 
@@ -115,11 +141,103 @@ int platform_init()
 
   term_clrscr();
   term_gotoxy( 1, 1 );
+
+#ifdef BUILD_ADC
+  sim_adc_init();
+#endif
+
+#ifdef BUILD_UIP
+  sim_eth_init();
+#endif
  
   // All done
   return PLATFORM_OK;
 }
 
+// ****************************************************************************
+// PIO functions (virtual ports; an input pin reads 1 if it has a pullup, an
+// output pin reads its own value; all the output changes are recorded in
+// SIM_PIO_TRACE_FILE as "<time in us> <port> <value>" lines)
+
+#define SIM_PIO_TRACE_FILE      "pio_trace.txt"
+
+static pio_type sim_pio_out[ NUM_PIO ], sim_pio_dir[ NUM_PIO ], sim_pio_pullup[ NUM_PIO ];
+static int sim_pio_trace_fd = -1;
+static s64 sim_pio_trace_start;
+
+// Helper: record the new value of the output pins if it is different from 'prev'
+static void sim_pio_trace( unsigned port, pio_type prev )
+{
+  char line[ 32 ];
+
+  if( prev == ( sim_pio_out[ port ] & sim_pio_dir[ port ] ) )
+    return;
+  if( sim_pio_trace_fd == -1 )
+  {
+    if( ( sim_pio_trace_fd = hostif_open( SIM_PIO_TRACE_FILE, 577, 0666 ) ) < 0 ) // 577 == O_WRONLY | O_CREAT | O_TRUNC
+      return;
+    sim_pio_trace_start = hostif_gettime();
+  }
+  sprintf( line, "%lu %s %08lX\n", ( unsigned long )( hostif_gettime() - sim_pio_trace_start ), 
+           platform_pio_get_prefix( port ), ( unsigned long )( sim_pio_out[ port ] & sim_pio_dir[ port ] ) );
+  hostif_write( sim_pio_trace_fd, line, strlen( line ) );
+}
+
+pio_type platform_pio_op( unsigned port, pio_type pinmask, int op )
+{
+  pio_type prev = sim_pio_out[ port ] & sim_pio_dir[ port ], retval = 1;
+
+  switch( op )
+  {
+    case PLATFORM_IO_PORT_SET_VALUE:
+      sim_pio_out[ port ] = pinmask;
+      break;
+
+    case PLATFORM_IO_PIN_SET:
+      sim_pio_out[ port ] |= pinmask;
+      break;
+
+    case PLATFORM_IO_PIN_CLEAR:
+      sim_pio_out[ port ] &= ~pinmask;
+      break;
+
+    case PLATFORM_IO_PORT_DIR_OUTPUT:
+      pinmask = PLATFORM_IO_ALL_PINS;
+    case PLATFORM_IO_PIN_DIR_OUTPUT:
+      sim_pio_dir[ port ] |= pinmask;
+      break;
+
+    case PLATFORM_IO_PORT_DIR_INPUT:
+      pinmask = PLATFORM_IO_ALL_PINS;
+    case PLATFORM_IO_PIN_DIR_INPUT:
+      sim_pio_dir[ port ] &= ~pinmask;
+      break;
+
+    case PLATFORM_IO_PORT_GET_VALUE:
+      retval = ( sim_pio_out[ port ] & sim_pio_dir[ port ] ) | ( sim_pio_pullup[ port ] & ~sim_pio_dir[ port ] );
+      break;
+
+    case PLATFORM_IO_PIN_GET:
+      retval = ( ( sim_pio_out[ port ] & sim_pio_dir[ port ] ) | ( sim_pio_pullup[ port ] & ~sim_pio_dir[ port ] ) ) & pinmask ? 1 : 0;
+      break;
+
+    case PLATFORM_IO_PIN_PULLUP:
+      sim_pio_pullup[ port ] |= pinmask;
+      break;
+
+    case PLATFORM_IO_PIN_PULLDOWN:
+    case PLATFORM_IO_PIN_NOPULL:
+      sim_pio_pullup[ port ] &= ~pinmask;
+      break;
+
+    default:
+      retval = 0;
+      break;
+  }
+  sim_pio_trace( port, prev );
+  return retval;
+}
+
 // ****************************************************************************
 // "Dummy" UART functions
 
@@ -142,6 +260,456 @@ int platform_s_uart_set_flow_control( unsigned id, int type )
   return PLATFORM_ERR;
 }
 
+// ****************************************************************************
+// SPI functions (loopback: MISO is connected to MOSI)
+
+u32 platform_spi_setup( unsigned id, int mode, u32 clock, unsigned cpol, unsigned cpha, unsigned databits )
+{
+  return clock;
+}
+
+spi_data_type platform_spi_send_recv( unsigned id, spi_data_type data )
+{
+  return data;
+}
+
+void platform_spi_send_recv_block( unsigned id, const u8 *txdata, u8 *rxdata, u32 len )
+{
+  if( rxdata == NULL )
+    return;
+  if( txdata )
+    memcpy( rxdata, txdata, len );
+  else
+    memset( rxdata, 0xFF, len );
+}
+
+void platform_spi_select( unsigned id, int is_select )
+{
+}
+
+// ****************************************************************************
+// I2C functions (a simulated slave with 256 8-bit registers at address
+// SIM_I2C_SLAVE_ADDRESS; the first byte written after the address selects the 
+// register, the register pointer is incremented after each read/write)
+
+#define SIM_I2C_SLAVE_ADDRESS   0x50
+
+enum
+{
+  SIM_I2C_IDLE,
+  SIM_I2C_REG,
+  SIM_I2C_WRITE,
+  SIM_I2C_READ
+};
+
+static u8 sim_i2c_regs[ 256 ];
+static u8 sim_i2c_ptr;
+static u8 sim_i2c_state;
+
+u32 platform_i2c_setup( unsigned id, u32 speed )
+{
+  return speed;
+}
+
+void platform_i2c_send_start( unsigned id )
+{
+  sim_i2c_state = SIM_I2C_IDLE;
+}
+
+void platform_i2c_send_stop( unsigned id )
+{
+  sim_i2c_state = SIM_I2C_IDLE;
+}
+
+int platform_i2c_send_address( unsigned id, u16 address, int direction )
+{
+  if( address != SIM_I2C_SLAVE_ADDRESS )
+    return 0;
+  sim_i2c_state = direction == PLATFORM_I2C_DIRECTION_TRANSMITTER ? SIM_I2C_REG : SIM_I2C_READ;
+  return 1;
+}
+
+int platform_i2c_send_byte( unsigned id, u8 data )
+{
+  if( sim_i2c_state == SIM_I2C_REG )
+  {
+    sim_i2c_ptr = data;
+    sim_i2c_state = SIM_I2C_WRITE;
+  }
+  else if( sim_i2c_state == SIM_I2C_WRITE )
+    sim_i2c_regs[ sim_i2c_ptr ++ ] = data;
+  else
+    return 0;
+  return 1;
+}
+
+int platform_i2c_recv_byte( unsigned id, int ack )
+{
+  if( sim_i2c_state != SIM_I2C_READ )
+    return -1;
+  return sim_i2c_regs[ sim_i2c_ptr ++ ];
+}
+
+// ****************************************************************************
+// CAN functions (a virtual loopback interface: all the frames sent on the
+// interface are received back on the same interface)
+
+#define SIM_CAN_FIFO_SIZE       16
+
+typedef struct
+{
+  u32 canid;
+  u8 idtype;
+  u8 len;
+  u8 data[ PLATFORM_CAN_MAXLEN ];
+} sim_can_frame;
+
+static sim_can_frame sim_can_fifo[ SIM_CAN_FIFO_SIZE ];
+static unsigned sim_can_rptr, sim_can_count;
+static int sim_can_int_enabled;
+
+u32 platform_can_setup( unsigned id, u32 clock )
+{
+  sim_can_rptr = sim_can_count = 0;
+  return clock;
+}
+
+int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data )
+{
+  sim_can_frame *pf;
+
+  if( sim_can_count == SIM_CAN_FIFO_SIZE )
+    return PLATFORM_ERR;
+  pf = sim_can_fifo + ( sim_can_rptr + sim_can_count ) % SIM_CAN_FIFO_SIZE;
+  pf->canid = canid;
+  pf->idtype = idtype;
+  pf->len = len;
+  memcpy( pf->data, data, len );
+  sim_can_count ++;
+#ifdef BUILD_INT_HANDLERS
+  // The frame is "received" right away
+  if( sim_can_int_enabled )
+    cmn_int_handler( INT_CAN_RX, id );
+#endif
+  return PLATFORM_OK;
+}
+
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+{
+  sim_can_frame *pf;
+
+  if( sim_can_count == 0 )
+    return PLATFORM_UNDERFLOW;
+  pf = sim_can_fifo + sim_can_rptr;
+  *canid = pf->canid;
+  *idtype = pf->idtype;
+  *len = pf->len;
+  memcpy( data, pf->data, pf->len );
+  sim_can_rptr = ( sim_can_rptr + 1 ) % SIM_CAN_FIFO_SIZE;
+  sim_can_count --;
+  return PLATFORM_OK;
+}
+
+// ****************************************************************************
+// ADC functions (a synthetic signal source: channel 0 is a sawtooth that
+// increases by 1 at every sequence, channel 1 is a sine, channel 2 is a square
+// wave and channel 3 is noise. The single conversions are completed right away,
+// the continuous acquisition converts a sequence every SIM_ADC_SEQ_PERIOD_US
+// microseconds and is advanced every time the system timer is read)
+
+#ifdef BUILD_ADC
+
+#define SIM_ADC_SEQ_PERIOD_US   50
+#define SIM_ADC_MAX_SEQUENCES   ( 1 << 20 )
+#define SIM_ADC_MAXVAL          ( ( 1 << ADC_BIT_RESOLUTION ) - 1 )
+#define SIM_ADC_SIGNAL_PERIOD   400 // in sequences (50Hz with the continuous acquisition)
+
+static u32 sim_adc_seqnum, sim_adc_noise = 1;
+static u16 *sim_adc_stream_buf;
+static unsigned sim_adc_stream_len, sim_adc_stream_pos;
+static timer_data_type sim_adc_stream_last;
+
+static u16 sim_adc_sample( unsigned id )
+{
+  switch( id & 3 )
+  {
+    case 0:
+      return sim_adc_seqnum & SIM_ADC_MAXVAL;
+
+    case 1:
+      return ( u16 )( ( SIM_ADC_MAXVAL / 2 ) * ( 1 + sin( 2 * M_PI * ( sim_adc_seqnum % SIM_ADC_SIGNAL_PERIOD ) / SIM_ADC_SIGNAL_PERIOD ) ) );
+
+    case 2:
+      return ( sim_adc_seqnum % SIM_ADC_SIGNAL_PERIOD ) < SIM_ADC_SIGNAL_PERIOD / 2 ? SIM_ADC_MAXVAL : 0;
+
+    default:
+      sim_adc_noise = sim_adc_noise * 1103515245 + 12345;
+      return ( sim_adc_noise >> 16 ) & SIM_ADC_MAXVAL;
+  }
+}
+
+// Convert the active sequence (this does what the "end of sequence" interrupt
+// handler does on the real hardware)
+static void sim_adc_convert_sequence( void )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+  elua_adc_ch_state *s;
+
+  for( d->seq_ctr = 0; d->seq_ctr < d->seq_len; d->seq_ctr ++ )
+    d->sample_buf[ d->seq_ctr ] = sim_adc_sample( d->ch_state[ d->seq_ctr ]->id );
+  sim_adc_seqnum ++;
+
+  d->seq_ctr = 0;
+  while( d->seq_ctr < d->seq_len )
+  {
+    s = d->ch_state[ d->seq_ctr ];
+    s->value_fresh = 1;
+
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
+    // Fill in smoothing buffer until warmed up
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
+      adc_smooth_data( s->id );
+#if defined( BUF_ENABLE_ADC )
+    else if ( s->reqsamples > 1 )
+    {
+      buf_write( BUF_ID_ADC, s->id, ( t_buf_data* )s->value_ptr );
+      s->value_fresh = 0;
+    }
+#endif
+
+    // If we have the number of requested samples, stop sampling
+    if ( adc_samples_available( s->id ) >= s->reqsamples && s->freerunning == 0 )
+      platform_adc_stop( s->id );
+
+    d->seq_ctr++;
+  }
+  d->seq_ctr = 0;
+
+  if( d->running == 1 )
+    adc_update_dev_sequence( 0 );
+}
+
+// Write the sequences acquired since the last call to the stream buffer
+static void sim_adc_stream_update( timer_data_type now )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+  timer_data_type elapsed, rem;
+  u32 nseq;
+  unsigned i;
+
+  if( sim_adc_stream_buf == NULL )
+    return;
+  elapsed = platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, sim_adc_stream_last, now );
+  nseq = ( u32 )( elapsed / SIM_ADC_SEQ_PERIOD_US );
+  // The part of a period that already elapsed counts for the next sequence
+  rem = elapsed % SIM_ADC_SEQ_PERIOD_US;
+  sim_adc_stream_last = now >= rem ? now - rem : ( timer_data_type )( now + ( PLATFORM_TIMER_SYS_MAX + 1 ) - rem );
+  // Don't try to catch up after a long pause
+  if( nseq > SIM_ADC_MAX_SEQUENCES )
+    nseq = SIM_ADC_MAX_SEQUENCES;
+  while( nseq -- )
+  {
+    for( i = 0; i < d->seq_len; i ++ )
+      sim_adc_stream_buf[ sim_adc_stream_pos ++ ] = sim_adc_sample( d->ch_state[ i ]->id );
+    sim_adc_seqnum ++;
+    if( sim_adc_stream_pos == sim_adc_stream_len / 2 || sim_adc_stream_pos == sim_adc_stream_len )
+    {
+      if( sim_adc_stream_pos == sim_adc_stream_len )
+        sim_adc_stream_pos = 0;
+      adc_stream_half_done();
+    }
+  }
+}
+
+static void sim_adc_init( void )
+{
+  unsigned id;
+
+  for( id = 0; id < NUM_ADC; id ++ )
+    adc_init_ch_state( id );
+}
+
+int platform_adc_check_timer_id( unsigned id, unsigned timer_id )
+{
+  // No hardware timers on the simulator
+  return 0;
+}
+
+void platform_adc_stop( unsigned id )
+{
+  elua_adc_ch_state *s = adc_get_ch_state( id );
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  s->op_pending = 0;
+  INACTIVATE_CHANNEL( d, id );
+
+  // If there are no more active channels, stop the sequencer
+  if( d->ch_active == 0 )
+    d->running = 0;
+}
+
+int platform_adc_update_sequence( void )
+{
+  return PLATFORM_OK;
+}
+
+u32 platform_adc_set_clock( unsigned id, u32 frequency )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  d->clocked = 0;
+  return 1000000 / SIM_ADC_SEQ_PERIOD_US;
+}
+
+int platform_adc_start_sequence( void )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+  unsigned n;
+
+  if( d->running != 1 )
+  {
+    adc_update_dev_sequence( 0 );
+    d->running = 1;
+    // The simulated conversions are instantaneous
+    for( n = 0; n < SIM_ADC_MAX_SEQUENCES && d->running == 1; n ++ )
+      sim_adc_convert_sequence();
+  }
+  return PLATFORM_OK;
+}
+
+int platform_adc_start_stream( u16 *buf, unsigned len )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  sim_adc_stream_buf = buf;
+  sim_adc_stream_len = len;
+  sim_adc_stream_pos = 0;
+  sim_adc_stream_last = sim_timer_get_sys();
+  d->running = 1;
+  return PLATFORM_OK;
+}
+
+void platform_adc_stop_stream( void )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  sim_adc_stream_buf = NULL;
+  d->running = 0;
+}
+
+#endif // #ifdef BUILD_ADC
+
+// ****************************************************************************
+// Ethernet functions (two simulator instances are connected by a pair of UNIX
+// datagram sockets, one Ethernet frame per datagram; the first instance is unit
+// 0, the second one is unit 1 and uses the next MAC and IP addresses). There are
+// no interrupts, so the uIP main loop runs every SIM_ETH_TICK_US microseconds
+// when the system timer is read and continuously while the net functions wait.
+
+#ifdef BUILD_UIP
+
+#define SIM_ETH_SOCKET_0        "/tmp/elua_sim_eth0"
+#define SIM_ETH_SOCKET_1        "/tmp/elua_sim_eth1"
+#define SIM_ETH_TICK_US         10000
+// How long a frame waits for room in the receive queue of the other simulator
+#define SIM_ETH_TX_WAIT_US      5000
+
+static const char* const sim_eth_sockets[] = { SIM_ETH_SOCKET_0, SIM_ETH_SOCKET_1 };
+static int sim_eth_fd = -1;
+static unsigned sim_eth_unit;
+static s64 sim_eth_elapsed_start;
+static timer_data_type sim_eth_last_tick;
+static u8 sim_eth_running, sim_eth_got_packet;
+// The frames are received in this buffer, which is lent to uIP like the DMA
+// buffer of a real controller (PLATFORM_HAS_ETH_RX_BUFFER)
+static u32 sim_eth_rx_buf[ ( UIP_BUFSIZE + 2 + 3 ) >> 2 ];
+
+static void sim_eth_init( void )
+{
+  // Locally administered MAC address
+  static struct uip_eth_addr sim_eth_addr = { { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+  uip_ipaddr_t ipaddr;
+
+  for( sim_eth_unit = 0; sim_eth_unit < 2; sim_eth_unit ++ )
+    if( ( sim_eth_fd = hostif_dgram_open( sim_eth_sockets[ sim_eth_unit ] ) ) >= 0 )
+      break;
+  if( sim_eth_fd < 0 )
+  {
+    hostif_putstr( "Ethernet not available (two simulators are already running)\n" );
+    return;
+  }
+  sim_eth_addr.addr[ 5 ] = sim_eth_unit;
+  sim_eth_elapsed_start = hostif_gettime();
+  sim_eth_last_tick = sim_timer_get_sys();
+  elua_uip_init( &sim_eth_addr );
+  if( sim_eth_unit == 1 )
+  {
+    uip_ipaddr( ipaddr, ELUA_CONF_IPADDR0, ELUA_CONF_IPADDR1, ELUA_CONF_IPADDR2, ELUA_CONF_IPADDR3 + 1 );
+    uip_sethostaddr( ipaddr );
+  }
+}
+
+// Run the uIP main loop until all the received frames are processed
+static void sim_eth_run( void )
+{
+  if( sim_eth_fd < 0 || sim_eth_running )
+    return;
+  sim_eth_running = 1;
+  do
+  {
+    sim_eth_got_packet = 0;
+    elua_uip_mainloop();
+  } while( sim_eth_got_packet );
+  sim_eth_running = 0;
+}
+
+void platform_eth_send_packet( const void* src, u32 size )
+{
+  // The frame is lost if the other simulator is not running. If its receive
+  // queue (only a few frames) is full, wait a bit like a busy transmitter would.
+  hostif_dgram_send( sim_eth_fd, sim_eth_sockets[ sim_eth_unit ^ 1 ], src, size, SIM_ETH_TX_WAIT_US );
+}
+
+void* platform_eth_get_rx_buffer( u32 *psize )
+{
+  int res = hostif_dgram_recv( sim_eth_fd, sim_eth_rx_buf, UIP_BUFSIZE + 2 );
+
+  if( res <= 0 )
+    return NULL;
+  sim_eth_got_packet = 1;
+  *psize = res;
+  return sim_eth_rx_buf;
+}
+
+void platform_eth_release_rx_buffer( void *buf )
+{
+}
+
+void platform_eth_force_interrupt( void )
+{
+  sim_eth_run();
+}
+
+u32 platform_eth_get_elapsed_time( void )
+{
+  u32 elapsed_ms = ( u32 )( ( hostif_gettime() - sim_eth_elapsed_start ) / 1000 );
+
+  sim_eth_elapsed_start += ( s64 )elapsed_ms * 1000;
+  return elapsed_ms;
+}
+
+void platform_eth_poll( void )
+{
+  sim_eth_run();
+  // The net functions poll while they wait for the other simulator, which may
+  // need the same host CPU to answer
+  hostif_yield();
+}
+
+#endif // #ifdef BUILD_UIP
+
 // ****************************************************************************
 // "Dummy" timer functions
 
@@ -154,9 +722,41 @@ timer_data_type platform_s_timer_op( unsigned id, int op, timer_data_type data )
   return 0;
 }
 
+// The simulator doesn't have a system timer interrupt, so it is emulated by a
+// tick that runs at most once every SWTMR_TICK_US microseconds, when the system
+// timer is read. Like cmn_systimer_periodic() on the real targets, the tick
+// advances the software timers.
+static timer_data_type sim_systimer_last_tick;
+static u8 sim_systimer_in_tick;
+
+static void sim_systimer_tick( timer_data_type now )
+{
+  if( sim_systimer_in_tick || platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, sim_systimer_last_tick, now ) < SWTMR_TICK_US )
+    return;
+  sim_systimer_in_tick = 1;
+  sim_systimer_last_tick = now;
+  cmn_swtmr_run();
+  sim_systimer_in_tick = 0;
+}
+
 timer_data_type platform_timer_read_sys( void )
 {
-  return hostif_gettime();
+  timer_data_type now = sim_timer_get_sys();
+
+  // The continuous ADC acquisition and the TCP/IP stack are also advanced when
+  // the system timer is read
+  sim_systimer_tick( now );
+#ifdef BUILD_ADC
+  sim_adc_stream_update( now );
+#endif
+#ifdef BUILD_UIP
+  if( platform_timer_get_diff_us( PLATFORM_TIMER_SYS_ID, sim_eth_last_tick, now ) >= SIM_ETH_TICK_US )
+  {
+    sim_eth_last_tick = now;
+    sim_eth_run();
+  }
+#endif
+  return now;
 }
 
 // ****************************************************************************
@@ -173,3 +773,40 @@ int platform_cpu_get_global_interrupts( void )
   return 0;
 }
 
+// ****************************************************************************
+// Interrupt support
+
+#ifdef BUILD_INT_HANDLERS
+
+static int int_can_rx_set_status( elua_int_resnum resnum, int status )
+{
+  int prev = sim_can_int_enabled;
+
+  sim_can_int_enabled = status == PLATFORM_CPU_ENABLE;
+  return prev;
+}
+
+static int int_can_rx_get_status( elua_int_resnum resnum )
+{
+  return sim_can_int_enabled;
+}
+
+static int int_can_rx_get_flag( elua_int_resnum resnum, int clear )
+{
+  return sim_can_count > 0;
+}
+
+void platform_int_init()
+{
+}
+
+// Interrupt table
+// Must have a 1-to-1 correspondence with the interrupt enum in platform_ints.h!
+const elua_int_descriptor elua_int_table[ INT_ELUA_LAST ] =
+{
+  { int_can_rx_set_status, int_can_rx_get_status, int_can_rx_get_flag },
+  { cmn_swtmr_int_set_status, cmn_swtmr_int_get_status, cmn_swtmr_int_get_flag },
+  { elua_net_int_set_status, elua_net_int_get_status, elua_net_int_get_flag }
+};
+
+#endif // #ifdef BUILD_INT_HANDLERS
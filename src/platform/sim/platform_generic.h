@@ -4,6 +4,10 @@
 #define __PLATFORM_GENERIC_H__
 
 #define PLATFORM_HAS_SYSTIMER
+#define PLATFORM_HAS_SPI_BLOCK
+#define PLATFORM_HAS_ADC_STREAM
+#define PLATFORM_HAS_ETH_POLL
+#define PLATFORM_HAS_ETH_RX_BUFFER
 
 #endif // #ifndef __PLATFORM_GENERIC_H__
 
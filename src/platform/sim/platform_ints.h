@@ -0,0 +1,13 @@
+// This header lists all interrupts defined for this platform
+
+#ifndef __PLATFORM_INTS_H__
+#define __PLATFORM_INTS_H__
+
+#include "elua_int.h"
+
+#define INT_CAN_RX            ELUA_INT_FIRST_ID
+#define INT_TMR_SW            ( ELUA_INT_FIRST_ID + 1 )
+#define INT_NET_EVENT         ( ELUA_INT_FIRST_ID + 2 )
+#define INT_ELUA_LAST         INT_NET_EVENT
+
+#endif // #ifndef __PLATFORM_INTS_H__
@@ -297,10 +297,68 @@ static const u8 can_baud_sjw[]    = { CAN_SJW_1tq, CAN_SJW_1tq, CAN_SJW_1tq, CAN
 static const u8 can_baud_pre[]    = { 20, 16, 8, 6, 4 };
 static const u32 can_baud_rate[]  = { 100000, 125000, 250000, 500000, 1000000 };
 
+// Hardware acceptance filters: filter 'idx' uses filter bank 'idx + 1'. Filter
+// bank 0 accepts all the frames and is active only when no other filter is.
+#define CAN_HW_NUM_FILTERS    13
+
+static u32 can_hw_filter_id[ CAN_HW_NUM_FILTERS ];
+static u32 can_hw_filter_mask[ CAN_HW_NUM_FILTERS ];
+static u16 can_hw_filter_enabled;
+
+// Set when the RX interrupt was masked by the IRQ handler (see platform_int.c)
+u8 stm32_can_rx_int_masked;
+
+static void cans_init_filter( unsigned bank, u32 id, u32 mask, int enable )
+{
+  CAN_FilterInitTypeDef  CAN_FilterInitStructure;
+
+  CAN_FilterInitStructure.CAN_FilterNumber=bank;
+  CAN_FilterInitStructure.CAN_FilterMode=CAN_FilterMode_IdMask;
+  CAN_FilterInitStructure.CAN_FilterScale=CAN_FilterScale_32bit;
+  CAN_FilterInitStructure.CAN_FilterIdHigh=id >> 16;
+  CAN_FilterInitStructure.CAN_FilterIdLow=id & 0xFFFF;
+  CAN_FilterInitStructure.CAN_FilterMaskIdHigh=mask >> 16;
+  CAN_FilterInitStructure.CAN_FilterMaskIdLow=mask & 0xFFFF;
+  CAN_FilterInitStructure.CAN_FilterFIFOAssignment=CAN_FIFO0;
+  CAN_FilterInitStructure.CAN_FilterActivation=enable ? ENABLE : DISABLE;
+  CAN_FilterInit(&CAN_FilterInitStructure);
+}
+
+static void cans_apply_filters( void )
+{
+  unsigned i;
+
+  for( i = 0; i < CAN_HW_NUM_FILTERS; i ++ )
+    cans_init_filter( i + 1, can_hw_filter_id[ i ], can_hw_filter_mask[ i ], ( can_hw_filter_enabled >> i ) & 1 );
+  cans_init_filter( 0, 0, 0, can_hw_filter_enabled == 0 );
+}
+
+int platform_s_can_set_filter( unsigned id, unsigned idx, u32 canid, u32 mask, u8 idtype, int enable )
+{
+  if( idx >= CAN_HW_NUM_FILTERS )
+    return PLATFORM_ERR;
+  // 32-bit filter layout: STID[10:0] EXID[17:0] IDE RTR 0, the IDE bit must always match
+  if( idtype == ELUA_CAN_ID_STD )
+  {
+    can_hw_filter_id[ idx ] = canid << 21;
+    can_hw_filter_mask[ idx ] = ( mask << 21 ) | CAN_ID_EXT;
+  }
+  else
+  {
+    can_hw_filter_id[ idx ] = ( canid << 3 ) | CAN_ID_EXT;
+    can_hw_filter_mask[ idx ] = ( mask << 3 ) | CAN_ID_EXT;
+  }
+  if( enable )
+    can_hw_filter_enabled |= 1 << idx;
+  else
+    can_hw_filter_enabled &= ~( 1 << idx );
+  cans_apply_filters();
+  return PLATFORM_OK;
+}
+
 u32 platform_can_setup( unsigned id, u32 clock )
 {
   CAN_InitTypeDef        CAN_InitStructure;
-  CAN_FilterInitTypeDef  CAN_FilterInitStructure;
   GPIO_InitTypeDef GPIO_InitStructure;
   int cbaudidx = -1;
 
@@ -345,16 +403,7 @@ u32 platform_can_setup( unsigned id, u32 clock )
   CAN_Init( CAN1, &CAN_InitStructure );
 
   /* CAN filter init */
-  CAN_FilterInitStructure.CAN_FilterNumber=0;
-  CAN_FilterInitStructure.CAN_FilterMode=CAN_FilterMode_IdMask;
-  CAN_FilterInitStructure.CAN_FilterScale=CAN_FilterScale_32bit;
-  CAN_FilterInitStructure.CAN_FilterIdHigh=0x0000;
-  CAN_FilterInitStructure.CAN_FilterIdLow=0x0000;
-  CAN_FilterInitStructure.CAN_FilterMaskIdHigh=0x0000;
-  CAN_FilterInitStructure.CAN_FilterMaskIdLow=0x0000;
-  CAN_FilterInitStructure.CAN_FilterFIFOAssignment=CAN_FIFO0;
-  CAN_FilterInitStructure.CAN_FilterActivation=ENABLE;
-  CAN_FilterInit(&CAN_FilterInitStructure);
+  cans_apply_filters();
   
   return can_baud_rate[ cbaudidx ];
 }
@@ -406,33 +455,7 @@ int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data
   return PLATFORM_OK;
 }
 
-void USB_LP_CAN_RX0_IRQHandler(void)
-{
-/*
-  CanRxMsg RxMessage;
-
-  RxMessage.StdId=0x00;
-  RxMessage.ExtId=0x00;
-  RxMessage.IDE=0;
-  RxMessage.DLC=0;
-  RxMessage.FMI=0;
-  RxMessage.Data[0]=0x00;
-  RxMessage.Data[1]=0x00;
-
-  CAN_Receive(CAN_FIFO0, &RxMessage);
-
-  if((RxMessage.ExtId==0x1234) && (RxMessage.IDE==CAN_ID_EXT)
-     && (RxMessage.DLC==2) && ((RxMessage.Data[1]|RxMessage.Data[0]<<8)==0xDECA))
-  {
-    ret = 1; 
-  }
-  else
-  {
-    ret = 0; 
-  }*/
-}
-
-int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
 {
   CanRxMsg RxMessage;
   const char *s;
@@ -461,7 +484,15 @@ int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
     return PLATFORM_OK;
   }
   else
+  {
+    // The FIFO is empty, so the RX interrupt can be enabled again
+    if( stm32_can_rx_int_masked )
+    {
+      stm32_can_rx_int_masked = 0;
+      CAN_ITConfig( CAN1, CAN_IT_FMP0, ENABLE );
+    }
     return PLATFORM_UNDERFLOW;
+  }
 }
 
 // ****************************************************************************
@@ -949,7 +980,7 @@ u32 platform_pwm_set_clock( unsigned id, u32 clock )
   return platform_pwm_get_clock( id );
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   TIM_OCInitTypeDef  TIM_OCInitStructure;
   TIM_TypeDef* ptimer = TIM8;
@@ -1005,6 +1036,39 @@ u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
   return clock;
 }
 
+// Change the duty cycles of several channels. The update event is disabled
+// while the compare registers are written, so the new values are moved from the
+// preload registers together at the start of the next PWM period.
+void platform_s_pwm_update( unsigned n, const u8 *ids, const u8 *duties )
+{
+  TIM_TypeDef* ptimer = PWM_TIMER_NAME;
+  u32 period = ptimer->ARR + 1;
+  unsigned i;
+  u16 pulse;
+
+  TIM_UpdateDisableConfig( ptimer, ENABLE );
+  for( i = 0; i < n; i ++ )
+  {
+    pulse = ( u16 )( duties[ i ] * period / 100 );
+    switch( ids[ i ] )
+    {
+      case 0:
+        TIM_SetCompare1( ptimer, pulse );
+        break;
+      case 1:
+        TIM_SetCompare2( ptimer, pulse );
+        break;
+      case 2:
+        TIM_SetCompare3( ptimer, pulse );
+        break;
+      case 3:
+        TIM_SetCompare4( ptimer, pulse );
+        break;
+    }
+  }
+  TIM_UpdateDisableConfig( ptimer, DISABLE );
+}
+
 void platform_pwm_start( unsigned id )
 {
   PWM_TIMER_NAME->CCER |= ( ( u16 )1 << 4 * id );
@@ -1035,6 +1099,7 @@ static const u32 adc_timer[] = { ADC_ExternalTrigConv_T1_CC1, ADC_ExternalTrigCo
 
 ADC_InitTypeDef adc_init_struct;
 DMA_InitTypeDef dma_init_struct;
+static volatile u8 adc_streaming;
 
 int platform_adc_check_timer_id( unsigned id, unsigned timer_id )
 {
@@ -1115,6 +1180,22 @@ void DMA1_Channel1_IRQHandler(void)
   elua_adc_dev_state *d = adc_get_dev_state( 0 );
   elua_adc_ch_state *s;
   
+  if( adc_streaming )
+  {
+    // Half transfer or transfer complete: a half of the stream buffer is full
+    if( DMA_GetITStatus( DMA1_IT_HT1 ) != RESET )
+    {
+      DMA_ClearITPendingBit( DMA1_IT_HT1 );
+      adc_stream_half_done();
+    }
+    if( DMA_GetITStatus( DMA1_IT_TC1 ) != RESET )
+    {
+      DMA_ClearITPendingBit( DMA1_IT_TC1 );
+      adc_stream_half_done();
+    }
+    return;
+  }
+
   DMA_ClearITPendingBit( DMA1_IT_TC1 );
   
   d->seq_ctr = 0;
@@ -1123,8 +1204,11 @@ void DMA1_Channel1_IRQHandler(void)
     s = d->ch_state[ d->seq_ctr ];
     s->value_fresh = 1;
     
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
     // Fill in smoothing buffer until warmed up
-    if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
       adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
     else if ( s->reqsamples > 1 )
@@ -1281,6 +1365,66 @@ int platform_adc_start_sequence( )
   return PLATFORM_OK;
 }
 
+int platform_adc_start_stream( u16 *buf, unsigned len )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  // The DMA transfer counter has 16 bits
+  if( len > 0xFFFF )
+    return PLATFORM_ERR;
+  ADC_ExternalTrigConvCmd( adc[ d->seq_id ], DISABLE );
+
+  // The DMA channel writes the whole buffer in circular mode, with an
+  // interrupt when each half is full
+  DMA_Cmd( DMA1_Channel1, DISABLE );
+  DMA_DeInit( DMA1_Channel1 );
+  dma_init_struct.DMA_BufferSize = len;
+  dma_init_struct.DMA_MemoryBaseAddr = ( u32 )buf;
+  DMA_Init( DMA1_Channel1, &dma_init_struct );
+  DMA_Cmd( DMA1_Channel1, ENABLE );
+  DMA_ClearITPendingBit( DMA1_IT_GL1 );
+  DMA_ITConfig( DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE );
+
+  // Without a timer trigger the converter restarts the sequence by itself
+  if( d->clocked == 0 )
+  {
+    adc_init_struct.ADC_ContinuousConvMode = ENABLE;
+    ADC_Init( adc[ d->seq_id ], &adc_init_struct );
+  }
+
+  adc_streaming = 1;
+  d->running = 1;
+  nvic_init_structure_adc.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init( &nvic_init_structure_adc );
+
+  if( d->clocked == 1 )
+    ADC_ExternalTrigConvCmd( adc[ d->seq_id ], ENABLE );
+  else
+    ADC_SoftwareStartConvCmd( adc[ d->seq_id ], ENABLE );
+  return PLATFORM_OK;
+}
+
+void platform_adc_stop_stream( void )
+{
+  elua_adc_dev_state *d = adc_get_dev_state( 0 );
+
+  ADC_ExternalTrigConvCmd( adc[ d->seq_id ], DISABLE );
+  adc_init_struct.ADC_ContinuousConvMode = DISABLE;
+  ADC_Init( adc[ d->seq_id ], &adc_init_struct );
+
+  nvic_init_structure_adc.NVIC_IRQChannelCmd = DISABLE;
+  NVIC_Init( &nvic_init_structure_adc );
+  DMA_ITConfig( DMA1_Channel1, DMA_IT_HT, DISABLE );
+  // Stop the transfers to the stream buffer, which is freed after this call
+  DMA_Cmd( DMA1_Channel1, DISABLE );
+  ADC_DMACmd( adc[ d->seq_id ], DISABLE );
+  adc_streaming = 0;
+  d->running = 0;
+
+  // The DMA channel must be set up again for the single conversions
+  d->force_reseq = 1;
+}
+
 #endif // ifdef BUILD_ADC
 
 // ****************************************************************************
@@ -4,6 +4,9 @@
 #define __PLATFORM_GENERIC_H__
 
 #define PLATFORM_HAS_SYSTIMER
+#define PLATFORM_HAS_CAN_HW_FILTERS
+#define PLATFORM_HAS_ADC_STREAM
+#define PLATFORM_HAS_PWM_UPDATE
 
 #endif // #ifndef __PLATFORM_GENERIC_H__
 
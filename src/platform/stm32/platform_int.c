@@ -187,6 +187,24 @@ void TIM8_CC_IRQHandler(void)
   tmr_int_handler( 7 );
 }
 
+// ----------------------------------------------------------------------------
+// CAN interrupt handler
+
+extern u8 stm32_can_rx_int_masked;
+
+void USB_LP_CAN1_RX0_IRQHandler(void)
+{
+  cmn_int_handler( INT_CAN_RX, 0 );
+
+  // If the handlers didn't empty the FIFO mask the interrupt until they do,
+  // otherwise it will fire again immediately (see platform_s_can_recv)
+  if( CAN_MessagePending( CAN1, CAN_FIFO0 ) > 0 )
+  {
+    CAN_ITConfig( CAN1, CAN_IT_FMP0, DISABLE );
+    stm32_can_rx_int_masked = 1;
+  }
+}
+
 // ****************************************************************************
 // GPIO helper functions
 
@@ -342,6 +360,29 @@ static int int_uart_rx_get_flag( elua_int_resnum resnum, int clear )
   return status;
 }
 
+// ****************************************************************************
+// Interrupt: INT_CAN_RX
+
+static int int_can_rx_get_status( elua_int_resnum resnum )
+{
+  return ( CAN1->IER & CAN_IT_FMP0 ) != 0 || stm32_can_rx_int_masked;
+}
+
+static int int_can_rx_set_status( elua_int_resnum resnum, int status )
+{
+  int prev = int_can_rx_get_status( resnum );
+
+  stm32_can_rx_int_masked = 0;
+  CAN_ITConfig( CAN1, CAN_IT_FMP0, status == PLATFORM_CPU_ENABLE ? ENABLE : DISABLE );
+  return prev;
+}
+
+static int int_can_rx_get_flag( elua_int_resnum resnum, int clear )
+{
+  // The flag is cleared by reading all the messages from the FIFO
+  return CAN_MessagePending( CAN1, CAN_FIFO0 ) > 0;
+}
+
 // ****************************************************************************
 // Initialize interrupt subsystem
 
@@ -398,6 +439,11 @@ void platform_int_init()
   }
 #endif  
 
+  // Enable the CAN RX interrupt in the NVIC
+  nvic_init_structure.NVIC_IRQChannel = USB_LP_CAN1_RX0_IRQn;
+  nvic_init_structure.NVIC_IRQChannelSubPriority = 0;
+  NVIC_Init( &nvic_init_structure );
+
 }
 
 // ****************************************************************************
@@ -409,5 +455,7 @@ const elua_int_descriptor elua_int_table[ INT_ELUA_LAST ] =
   { int_gpio_posedge_set_status, int_gpio_posedge_get_status, int_gpio_posedge_get_flag },
   { int_gpio_negedge_set_status, int_gpio_negedge_get_status, int_gpio_negedge_get_flag },
   { int_tmr_match_set_status, int_tmr_match_get_status, int_tmr_match_get_flag },
-  { int_uart_rx_set_status, int_uart_rx_get_status, int_uart_rx_get_flag }  
+  { int_uart_rx_set_status, int_uart_rx_get_status, int_uart_rx_get_flag },
+  { int_can_rx_set_status, int_can_rx_get_status, int_can_rx_get_flag },
+  { cmn_swtmr_int_set_status, cmn_swtmr_int_get_status, cmn_swtmr_int_get_flag }
 };
@@ -1153,7 +1153,7 @@ void USB_LP_CAN_RX0_IRQHandler(void)
   }*/
 }
 
-int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
 {
   CanRxMsg RxMessage;
   const char *s;
@@ -1269,7 +1269,7 @@ u32 platform_pwm_set_clock( unsigned id, u32 clock )
   return platform_pwm_get_clock( id );
 }
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   TIM_OCInitTypeDef  TIM_OCInitStructure;
   TIM_TypeDef* ptimer = PWM_TIMER_NAME;
@@ -1552,8 +1552,11 @@ void DMA2_Stream0_IRQHandler(void)
     s = d->ch_state[ d->seq_ctr ];
     s->value_fresh = 1;
 
+    // Run the filter stage, the sample is dropped if it doesn't produce an output
+    if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+      s->value_fresh = 0;
     // Fill in smoothing buffer until warmed up
-    if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+    else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
       adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
     else if ( s->reqsamples > 1 )
@@ -296,7 +296,7 @@ timer_data_type platform_s_timer_op( unsigned id, int op, timer_data_type data )
 static const u16 pwm_pins[ NUM_PWM ] = { 1 << 7, 1 << 13, 1 << 2 };
 static const u8 pwm_ports[ NUM_PWM ] = { 1, 0, 1 };
  
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   u32 pwmclk = platform_timer_get_clock( id + 1 );
   u32 period;
@@ -509,8 +509,11 @@ void ADC_IRQHandler( void )
       d->sample_buf[ d->seq_ctr ] = ( u16 )ADC_GetConversionValue( s->id );
       s->value_fresh = 1;
     
+      // Run the filter stage, the sample is dropped if it doesn't produce an output
+      if ( s->filter != NULL && adc_filter_sample( s ) == 0 )
+        s->value_fresh = 0;
       // Fill in smoothing buffer until warmed up
-      if ( s->logsmoothlen > 0 && s->smooth_ready == 0)
+      else if ( s->logsmoothlen > 0 && s->smooth_ready == 0 )
         adc_smooth_data( s->id );
 #if defined( BUF_ENABLE_ADC )
       else if ( s->reqsamples > 1 )
@@ -679,7 +682,7 @@ int platform_adc_start_sequence()
 // ****************************************************************************
 // PWM functions
 
-u32 platform_pwm_setup( unsigned id, u32 frequency, unsigned duty )
+u32 platform_s_pwm_setup( unsigned id, u32 frequency, unsigned duty )
 {
   TIM_TypeDef* p_timer = ( TIM_TypeDef* )str9_timer_data[ id ];
   u32 base = SCU_GetPCLKFreqValue() * 1000;
@@ -967,7 +970,7 @@ int platform_can_send( unsigned id, u32 canid, u8 idtype, u8 len, const u8 *data
   return PLATFORM_ERR;
 }
 
-int platform_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
+int platform_s_can_recv( unsigned id, u32 *canid, u8 *idtype, u8 *len, u8 *data )
 {
   // wait for a message
   if ( frame_received_flag != 0){
@@ -118,21 +118,42 @@ struct namemap {
   u8_t retries;
   u8_t seqno;
   u8_t err;
+  unsigned long expires;
   char name[32];
   uip_ipaddr_t ipaddr;
 };
 
-#ifndef UIP_CONF_RESOLV_ENTRIES
-#define RESOLV_ENTRIES 4
-#else /* UIP_CONF_RESOLV_ENTRIES */
+/* eLua: the names are cached until their TTL expires. The size of the
+   cache and the TTLs can be set in the configurator (the attributes of
+   the 'dns' component). */
+#if defined(ELUA_NET_DNS_CACHE_SIZE)
+#define RESOLV_ENTRIES ELUA_NET_DNS_CACHE_SIZE
+#elif defined(UIP_CONF_RESOLV_ENTRIES)
 #define RESOLV_ENTRIES UIP_CONF_RESOLV_ENTRIES
-#endif /* UIP_CONF_RESOLV_ENTRIES */
+#else
+#define RESOLV_ENTRIES 4
+#endif
 
+/* The longest time (in seconds) an answer is cached, whatever its TTL */
+#ifndef ELUA_NET_DNS_MAX_TTL
+#define ELUA_NET_DNS_MAX_TTL 3600
+#endif
+
+/* How long (in seconds) a name that doesn't exist is cached */
+#ifndef ELUA_NET_DNS_NEG_TTL
+#define ELUA_NET_DNS_NEG_TTL 60
+#endif
 
 static struct namemap names[RESOLV_ENTRIES];
 
 static u8_t seqno;
 
+/* Seconds since the start, counted by resolv_tick() */
+static unsigned long resolv_time;
+
+/* True if the answer in an entry can still be used */
+#define VALID(nameptr) ((long)((nameptr)->expires - resolv_time) > 0)
+
 static struct uip_udp_conn *resolv_conn = NULL;
 
 
@@ -183,7 +204,9 @@ check_entries(void)
       if(namemapptr->state == STATE_ASKING) {
         if(--namemapptr->tmr == 0) {
           if(++namemapptr->retries == MAX_RETRIES) {
+            /* No answer, this is not cached. */
             namemapptr->state = STATE_ERROR;
+            namemapptr->expires = resolv_time;
             resolv_found(namemapptr->name, NULL);
             continue;
           }
@@ -242,6 +265,7 @@ newdata(void)
   struct dns_hdr *hdr;
   static u8_t nquestions, nanswers;
   static u8_t i;
+  static unsigned long ttl;
   register struct namemap *namemapptr;
   
   hdr = (struct dns_hdr *)uip_appdata;
@@ -266,9 +290,16 @@ newdata(void)
     namemapptr->state = STATE_DONE;
     namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
-    /* Check for error. If so, call callback to inform. */
+    /* Check for error. If so, call callback to inform. A name that
+       doesn't exist is cached as an entry with no address. */
     if(namemapptr->err != 0) {
       namemapptr->state = STATE_ERROR;
+      namemapptr->expires = resolv_time;
+      if(namemapptr->err == DNS_FLAG2_ERR_NAME) {
+        namemapptr->state = STATE_DONE;
+        namemapptr->expires += ELUA_NET_DNS_NEG_TTL;
+        uip_ipaddr(namemapptr->ipaddr, 0, 0, 0, 0);
+      }
       resolv_found(namemapptr->name, NULL);
       return;
     }
@@ -278,10 +309,14 @@ newdata(void)
     nquestions = htons(hdr->numquestions);
     nanswers = htons(hdr->numanswers);
 
-    /* Skip the name in the question. XXX: This should really be
-       checked agains the name in the question, to be sure that they
-       match. */
-    nameptr = parse_name((unsigned char *)uip_appdata + 12) + 4;
+    /* Skip the name, type and class of each question. XXX: The name
+       should really be checked agains the name in the question, to be
+       sure that they match. */
+    nameptr = (unsigned char *)uip_appdata + 12;
+    while(nquestions > 0) {
+      nameptr = parse_name(nameptr) + 4;
+      --nquestions;
+    }
 
     while(nanswers > 0) {
       /* The first byte in the answer resource record determines if it
@@ -314,6 +349,11 @@ newdata(void)
            we want. */
         namemapptr->ipaddr[0] = ans->ipaddr[0];
         namemapptr->ipaddr[1] = ans->ipaddr[1];
+        ttl = ((unsigned long)htons(ans->ttl[0]) << 16) | htons(ans->ttl[1]);
+        if(ttl > ELUA_NET_DNS_MAX_TTL) {
+          ttl = ELUA_NET_DNS_MAX_TTL;
+        }
+        namemapptr->expires = resolv_time + ttl;
         
         resolv_found(namemapptr->name, namemapptr->ipaddr);
         return;
@@ -322,6 +362,11 @@ newdata(void)
       }
       --nanswers;
     }
+
+    /* The name has no address. */
+    namemapptr->expires = resolv_time + ELUA_NET_DNS_NEG_TTL;
+    uip_ipaddr(namemapptr->ipaddr, 0, 0, 0, 0);
+    resolv_found(namemapptr->name, NULL);
   }
 
 }
@@ -346,6 +391,12 @@ resolv_appcall(void)
 /**
  * Queues a name so that a question for the name will be sent out.
  *
+ * The entry of the name is reused if it exists, otherwise the query
+ * takes an unused or expired entry, or the least recently used one.
+ * The entries of the names that are being asked for are never taken.
+ * resolv_found() is called with a NULL address if the name is too
+ * long or if there is no entry for it.
+ *
  * \param name The hostname that is to be queried.
  */
 /*---------------------------------------------------------------------------*/
@@ -355,21 +406,45 @@ resolv_query(char *name)
   static u8_t i;
   static u8_t lseq, lseqi;
   register struct namemap *nameptr;
-      
-  lseq = lseqi = 0;
+
+  if(strlen(name) >= sizeof(nameptr->name)) {
+    resolv_found(name, NULL);
+    return;
+  }
+
+  lseq = 0;
+  lseqi = RESOLV_ENTRIES;
   
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
-    if(nameptr->state == STATE_UNUSED) {
+    if(nameptr->state != STATE_UNUSED &&
+       strcmp(name, nameptr->name) == 0) {
+      if(nameptr->state == STATE_NEW ||
+         nameptr->state == STATE_ASKING) {
+        /* Already asking for it. */
+        return;
+      }
       break;
     }
-    if(seqno - nameptr->seqno > lseq) {
+    if(nameptr->state == STATE_NEW ||
+       nameptr->state == STATE_ASKING) {
+      continue;
+    }
+    if(nameptr->state == STATE_UNUSED || !VALID(nameptr)) {
+      lseq = 0xff;
+      lseqi = i;
+    } else if(lseqi == RESOLV_ENTRIES ||
+              (u8_t)(seqno - nameptr->seqno) > lseq) {
       lseq = seqno - nameptr->seqno;
       lseqi = i;
     }
   }
 
   if(i == RESOLV_ENTRIES) {
+    if(lseqi == RESOLV_ENTRIES) {
+      resolv_found(name, NULL);
+      return;
+    }
     i = lseqi;
     nameptr = &names[i];
   }
@@ -387,12 +462,12 @@ resolv_query(char *name)
  *
  * \note This function only looks in the internal array of known
  * hostnames, it does not send out a query for the hostname if none
- * was found. The function resolv_query() can be used to send a query
- * for a hostname.
+ * was found or if its entry expired. The function resolv_query() can
+ * be used to send a query for a hostname.
  *
  * \return A pointer to a 4-byte representation of the hostname's IP
- * address, or NULL if the hostname was not found in the array of
- * hostnames.
+ * address (0.0.0.0 if the name doesn't exist), or NULL if the hostname
+ * was not found in the array of hostnames.
  */
 /*---------------------------------------------------------------------------*/
 u16_t *
@@ -406,13 +481,26 @@ resolv_lookup(char *name)
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
     if(nameptr->state == STATE_DONE &&
+       VALID(nameptr) &&
        strcmp(name, nameptr->name) == 0) {
+      nameptr->seqno = seqno++;
       return nameptr->ipaddr;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * Counts the time for the expiration of the cached names. This
+ * function must be called every second.
+ */
+/*---------------------------------------------------------------------------*/
+void
+resolv_tick(void)
+{
+  ++resolv_time;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * Obtain the currently configured DNS server.
  *
@@ -457,7 +545,7 @@ resolv_init(void)
   static u8_t i;
   
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    names[i].state = STATE_DONE;
+    names[i].state = STATE_UNUSED;
   }
 
 }
@@ -470,6 +558,7 @@ resolv_init(void)
 void resolv_appcall( void );
 void resolv_init( void );
 void resolv_conf( void *dnsserver );
+void resolv_tick( void );
 
 void resolv_appcall( void )
 {
@@ -483,4 +572,8 @@ void resolv_conf( void *dnsserver )
 {
 }
 
+void resolv_tick( void )
+{
+}
+
 #endif // #ifdef BUILD_DNS
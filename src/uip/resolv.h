@@ -65,6 +65,7 @@ u16_t *resolv_getserver(void);
 void resolv_init(void);
 u16_t *resolv_lookup(char *name);
 void resolv_query(char *name);
+void resolv_tick(void);
 
 void resolv_appcall( void );
 
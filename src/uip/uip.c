@@ -138,10 +138,15 @@ const struct uip_eth_addr uip_ethaddr = {{UIP_ETHADDR0,
 struct uip_eth_addr uip_ethaddr = {{0,0,0,0,0,0}};
 #endif
 
-#ifndef UIP_CONF_EXTERNAL_BUFFER
+#if UIP_EXTERNAL_BUFFER
+u8_t uip_bufmem[UIP_BUFSIZE + 2];
+u8_t *uip_buf = uip_bufmem;      /* The packet being processed, in
+                                    uip_bufmem or in a buffer of the
+                                    device driver. */
+#else /* UIP_EXTERNAL_BUFFER */
 u8_t uip_buf[UIP_BUFSIZE + 2];   /* The packet buffer that contains
                                     incoming packets. */
-#endif /* UIP_CONF_EXTERNAL_BUFFER */
+#endif /* UIP_EXTERNAL_BUFFER */
 
 void *uip_appdata;               /* The uip_appdata pointer points to
                                     application data. */
@@ -175,6 +180,11 @@ u16_t uip_listenports[UIP_LISTENPORTS];
                                 listning ports. */
                                 
 u8_t uip_forced_poll;   // 1 if forcing the polling, 0 if the polling is not forced
+
+u16_t uip_acklen;            /* The number of bytes acknowledged by the
+                                incoming segment. */
+u16_t uip_rcvdrop;           /* The number of bytes of the incoming
+                                segment beyond the receive window. */
 #endif /* UIP_TCP */
 
 #if UIP_UDP
@@ -203,6 +213,11 @@ static u16_t lastport;       /* Keeps track of the last port used for
 u8_t uip_acc32[4];
 static u8_t c, opt;
 static u16_t tmp16;
+#if UIP_TCP_SND_WND
+static u16_t seqoff;         /* Offset of the outgoing segment from
+                                snd_nxt (new data sent after the data
+                                in transit). */
+#endif /* UIP_TCP_SND_WND */
 #endif /* UIP_TCP */
 
 /* Structures and definitions. */
@@ -467,6 +482,13 @@ uip_prepare_conn( struct uip_conn* conn, uip_ipaddr_t *ripaddr, u16_t rport )
   conn->snd_nxt[3] = iss[3];
 
   conn->initialmss = conn->mss = UIP_TCP_MSS;
+#if UIP_TCP_SND_WND
+  conn->snd_wnd = UIP_TCP_MSS;
+  conn->snd_max = 0;
+#endif /* UIP_TCP_SND_WND */
+#if UIP_TCP_RCV_WND
+  conn->rcv_wnd = UIP_RECEIVE_WINDOW;
+#endif /* UIP_TCP_RCV_WND */
   
   conn->len = 1;   /* TCP length of the SYN is one. */
   conn->nrtx = 0;
@@ -740,6 +762,28 @@ uip_add_rcv_nxt(u16_t n)
   uip_conn->rcv_nxt[2] = uip_acc32[2];
   uip_conn->rcv_nxt[3] = uip_acc32[3];
 }
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_SND_WND
+/* Returns how many bytes of the outstanding data of the connection
+   are acknowledged by the incoming segment. With several segments
+   in transit, the segment can acknowledge only some of them, or
+   also the segments that a retransmission removed from conn->len
+   (their ACK might just have been late or lost). */
+static u16_t
+uip_acked_len(struct uip_conn *conn)
+{
+  unsigned long diff;
+  u16_t sent;
+
+  diff = (((unsigned long)BUF->ackno[0] << 24) | ((unsigned long)BUF->ackno[1] << 16) |
+          ((unsigned long)BUF->ackno[2] << 8) | BUF->ackno[3]) -
+         (((unsigned long)conn->snd_nxt[0] << 24) | ((unsigned long)conn->snd_nxt[1] << 16) |
+          ((unsigned long)conn->snd_nxt[2] << 8) | conn->snd_nxt[3]);
+  diff &= 0xffffffffUL;
+  sent = conn->len > conn->snd_max ? conn->len : conn->snd_max;
+  return diff <= sent ? (u16_t)diff : 0;
+}
+#endif /* UIP_TCP_SND_WND */
 #endif /* UIP_TCP */
 /*---------------------------------------------------------------------------*/
 void
@@ -856,6 +900,21 @@ uip_process(u8_t flag)
                label). */
             uip_flags = UIP_REXMIT;
             UIP_APPCALL();
+#if UIP_TCP_SND_WND
+            /* Only the first segment is retransmitted. The data
+               after it is considered not sent, so the application
+               sends it again as new data. It can still be
+               acknowledged, so snd_max remembers it. */
+            if(uip_slen > uip_connr->mss) {
+              uip_slen = uip_connr->mss;
+            }
+            if(uip_slen > 0 && uip_slen < uip_connr->len) {
+              if(uip_connr->len > uip_connr->snd_max) {
+                uip_connr->snd_max = uip_connr->len;
+              }
+              uip_connr->len = uip_slen;
+            }
+#endif /* UIP_TCP_SND_WND */
             goto apprexmit;
             
           case UIP_FIN_WAIT_1:
@@ -867,6 +926,14 @@ uip_process(u8_t flag)
           }
         }
       } else if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+#if UIP_TCP_SND_WND
+        /* If the remote host closed its window, send a segment from
+           time to time to find out when it opens it again (the
+           update of the window could be lost). */
+        if(!uip_forced_poll && uip_connr->snd_wnd == 0 && !uip_outstanding(uip_connr)) {
+          uip_connr->snd_wnd = uip_connr->mss;
+        }
+#endif /* UIP_TCP_SND_WND */
         /* If there was no need for a retransmission, we poll the
            application for new data. */
         uip_flags = UIP_POLL;
@@ -1398,6 +1465,13 @@ uip_process(u8_t flag)
   uip_connr->snd_nxt[2] = iss[2];
   uip_connr->snd_nxt[3] = iss[3];
   uip_connr->len = 1;
+#if UIP_TCP_SND_WND
+  uip_connr->snd_wnd = UIP_TCP_MSS;
+  uip_connr->snd_max = 0;
+#endif /* UIP_TCP_SND_WND */
+#if UIP_TCP_RCV_WND
+  uip_connr->rcv_wnd = UIP_RECEIVE_WINDOW;
+#endif /* UIP_TCP_RCV_WND */
 
   /* rcv_nxt should be the seqno from the incoming packet + 1. */
   uip_connr->rcv_nxt[3] = BUF->seqno[3];
@@ -1506,13 +1580,24 @@ uip_process(u8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+  uip_acklen = 0;
+  uip_rcvdrop = 0;
   if((BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+#if UIP_TCP_SND_WND
+    uip_acklen = uip_acked_len(uip_connr);
+    uip_add32(uip_connr->snd_nxt, uip_acklen);
+#else /* UIP_TCP_SND_WND */
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
     if(BUF->ackno[0] == uip_acc32[0] &&
        BUF->ackno[1] == uip_acc32[1] &&
        BUF->ackno[2] == uip_acc32[2] &&
        BUF->ackno[3] == uip_acc32[3]) {
+      uip_acklen = uip_connr->len;
+    }
+#endif /* UIP_TCP_SND_WND */
+
+    if(uip_acklen > 0) {
       /* Update sequence number. */
       uip_connr->snd_nxt[0] = uip_acc32[0];
       uip_connr->snd_nxt[1] = uip_acc32[1];
@@ -1541,7 +1626,14 @@ uip_process(u8_t flag)
       uip_connr->timer = uip_connr->rto;
 
       /* Reset length of outstanding data. */
-      uip_connr->len = 0;
+#if UIP_TCP_SND_WND
+      uip_connr->snd_max = uip_connr->snd_max > uip_acklen ?
+        uip_connr->snd_max - uip_acklen : 0;
+      uip_connr->len = uip_connr->len > uip_acklen ?
+        uip_connr->len - uip_acklen : 0;
+#else /* UIP_TCP_SND_WND */
+      uip_connr->len -= uip_acklen;
+#endif /* UIP_TCP_SND_WND */
     }
     
   }
@@ -1562,6 +1654,12 @@ uip_process(u8_t flag)
       uip_flags = UIP_CONNECTED;
       uip_connr->len = 0;
       if(uip_len > 0) {
+#if UIP_TCP_RCV_WND
+        if(uip_len > uip_connr->rcv_wnd) {
+          uip_rcvdrop = uip_len - uip_connr->rcv_wnd;
+          uip_len = uip_connr->rcv_wnd;
+        }
+#endif /* UIP_TCP_RCV_WND */
         uip_flags |= UIP_NEWDATA;
         uip_add_rcv_nxt(uip_len);
       }
@@ -1648,7 +1746,12 @@ uip_process(u8_t flag)
     state. We require that there is no outstanding data; otherwise the
     sequence numbers will be screwed up. */
 
-    if(BUF->flags & TCP_FIN && !(uip_connr->tcpstateflags & UIP_STOPPED)) {
+    if(BUF->flags & TCP_FIN && !(uip_connr->tcpstateflags & UIP_STOPPED)
+#if UIP_TCP_RCV_WND
+       /* The FIN is after the data, so it must be in the window too. */
+       && uip_len <= uip_connr->rcv_wnd
+#endif /* UIP_TCP_RCV_WND */
+       ) {
       if(uip_outstanding(uip_connr)) {
         goto drop;
       }
@@ -1659,6 +1762,9 @@ uip_process(u8_t flag)
       }
       UIP_APPCALL();
       uip_connr->len = 1;
+#if UIP_TCP_SND_WND
+      uip_connr->snd_max = 0;
+#endif /* UIP_TCP_SND_WND */
       uip_connr->tcpstateflags = UIP_LAST_ACK;
       uip_connr->nrtx = 0;
     tcp_send_finack:
@@ -1693,6 +1799,16 @@ uip_process(u8_t flag)
        using uip_stop(), we must not accept any data packets from the
        remote host. */
     if(uip_len > 0 && !(uip_connr->tcpstateflags & UIP_STOPPED)) {
+#if UIP_TCP_RCV_WND
+      /* Only the data that fits in the receive window is accepted,
+         the remote host sends the rest again. The segment is still
+         flagged as new data, so the ACK tells the remote host about
+         the current window even if no data was accepted. */
+      if(uip_len > uip_connr->rcv_wnd) {
+        uip_rcvdrop = uip_len - uip_connr->rcv_wnd;
+        uip_len = uip_connr->rcv_wnd;
+      }
+#endif /* UIP_TCP_RCV_WND */
       uip_flags |= UIP_NEWDATA;
       uip_add_rcv_nxt(uip_len);
     }
@@ -1710,6 +1826,9 @@ uip_process(u8_t flag)
        "persistent timer" and uses the retransmission mechanim.
     */
     tmp16 = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
+#if UIP_TCP_SND_WND
+    uip_connr->snd_wnd = tmp16;
+#endif /* UIP_TCP_SND_WND */
     if(tmp16 > uip_connr->initialmss ||
        tmp16 == 0) {
       tmp16 = uip_connr->initialmss;
@@ -1748,6 +1867,9 @@ uip_process(u8_t flag)
       if(uip_flags & UIP_CLOSE) {
         uip_slen = 0;
         uip_connr->len = 1;
+#if UIP_TCP_SND_WND
+        uip_connr->snd_max = 0;
+#endif /* UIP_TCP_SND_WND */
         uip_connr->tcpstateflags = UIP_FIN_WAIT_1;
         uip_connr->nrtx = 0;
         BUF->flags = TCP_FIN | TCP_ACK;
@@ -1757,6 +1879,23 @@ uip_process(u8_t flag)
       /* If uip_slen > 0, the application has data to be sent. */
       if(uip_slen > 0) {
 
+#if UIP_TCP_SND_WND
+        /* The new data is sent after the data in transit, if the
+           window allows it. */
+        if(uip_slen > uip_connr->mss) {
+          uip_slen = uip_connr->mss;
+        }
+        tmp16 = uip_sndwnd();
+        if(uip_connr->len >= tmp16) {
+          uip_slen = 0;
+        } else if(uip_slen > tmp16 - uip_connr->len) {
+          uip_slen = tmp16 - uip_connr->len;
+        }
+        if(uip_slen > 0) {
+          seqoff = uip_connr->len;
+          uip_connr->len += uip_slen;
+        }
+#else /* UIP_TCP_SND_WND */
         /* If the connection has acknowledged data, the contents of
            the ->len variable should be discarded. */
         if((uip_flags & UIP_ACKDATA) != 0) {
@@ -1785,6 +1924,7 @@ uip_process(u8_t flag)
              retransmit) out more than it previously sent out. */
           uip_slen = uip_connr->len;
         }
+#endif /* UIP_TCP_SND_WND */
       }
       uip_connr->nrtx = 0;
     apprexmit:
@@ -1794,7 +1934,11 @@ uip_process(u8_t flag)
          packet had new data in it, we must send out a packet. */
       if(uip_slen > 0 && uip_connr->len > 0) {
         /* Add the length of the IP and TCP headers. */
+#if UIP_TCP_SND_WND
+        uip_len = uip_slen + UIP_TCPIP_HLEN;
+#else /* UIP_TCP_SND_WND */
         uip_len = uip_connr->len + UIP_TCPIP_HLEN;
+#endif /* UIP_TCP_SND_WND */
         /* We always set the ACK flag in response packets. */
         BUF->flags = TCP_ACK | TCP_PSH;
         /* Send the packet. */
@@ -1899,6 +2043,23 @@ uip_process(u8_t flag)
   BUF->seqno[1] = uip_connr->snd_nxt[1];
   BUF->seqno[2] = uip_connr->snd_nxt[2];
   BUF->seqno[3] = uip_connr->snd_nxt[3];
+#if UIP_TCP_SND_WND
+  /* New data is sent after the data in transit. The ACKs without data
+     carry the sequence number that follows the data in transit too, or
+     the remote host would find them out of its window. */
+  if(seqoff == 0 && uip_len == UIP_IPTCPH_LEN && BUF->flags == TCP_ACK &&
+     (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+    seqoff = uip_connr->len;
+  }
+  if(seqoff > 0) {
+    uip_add32(uip_connr->snd_nxt, seqoff);
+    BUF->seqno[0] = uip_acc32[0];
+    BUF->seqno[1] = uip_acc32[1];
+    BUF->seqno[2] = uip_acc32[2];
+    BUF->seqno[3] = uip_acc32[3];
+    seqoff = 0;
+  }
+#endif /* UIP_TCP_SND_WND */
 
   BUF->proto = UIP_PROTO_TCP;
   
@@ -1913,8 +2074,13 @@ uip_process(u8_t flag)
        window so that the remote host will stop sending data. */
     BUF->wnd[0] = BUF->wnd[1] = 0;
   } else {
+#if UIP_TCP_RCV_WND
+    BUF->wnd[0] = uip_connr->rcv_wnd >> 8;
+    BUF->wnd[1] = uip_connr->rcv_wnd & 0xff;
+#else /* UIP_TCP_RCV_WND */
     BUF->wnd[0] = ((UIP_RECEIVE_WINDOW) >> 8);
     BUF->wnd[1] = ((UIP_RECEIVE_WINDOW) & 0xff);
+#endif /* UIP_TCP_RCV_WND */
   }
 
  tcp_send_noconn:
@@ -430,8 +430,16 @@ extern u8_t uip_forced_poll;
     }
  }
  \endcode
+ *
+ * \note With UIP_CONF_EXTERNAL_BUFFER, uip_buf is a pointer to the
+ * packet being processed (see UIP_EXTERNAL_BUFFER).
  */
+#if UIP_EXTERNAL_BUFFER
+extern u8_t uip_bufmem[UIP_BUFSIZE+2];
+extern u8_t *uip_buf;
+#else /* UIP_EXTERNAL_BUFFER */
 extern u8_t uip_buf[UIP_BUFSIZE+2];
+#endif /* UIP_EXTERNAL_BUFFER */
 
 /** @} */
 
@@ -753,6 +761,79 @@ void uip_send(const void *data, int len);
  */
 #define uip_mss()             (uip_conn->mss)
 
+/**
+ * Get the number of bytes acknowledged by the remote host.
+ *
+ * Only valid when uip_acked() is true.
+ *
+ * \hideinitializer
+ */
+#define uip_ackedlen()        uip_acklen
+
+/**
+ * Get the number of bytes sent on the current connection that were
+ * not acknowledged yet.
+ *
+ * \hideinitializer
+ */
+#define uip_unacked()         (uip_conn->len)
+
+/**
+ * Get the maximum number of unacknowledged bytes that the current
+ * connection can have in transit.
+ *
+ * The application can send new data if uip_unacked() is smaller than
+ * this value. Without UIP_TCP_SND_WND, or if the remote host
+ * advertises a window of a single segment, one segment can be in
+ * transit, so the value is 0 until the segment is acknowledged. It is
+ * also 0 while the remote host advertises a zero window.
+ *
+ * \hideinitializer
+ */
+#if UIP_TCP_SND_WND
+#define uip_sndwnd()          (uip_conn->snd_wnd > uip_conn->mss ? \
+                               (uip_conn->snd_wnd < UIP_TCP_SND_WND ? uip_conn->snd_wnd : UIP_TCP_SND_WND) : \
+                               (uip_conn->snd_wnd == 0 || uip_conn->len > 0 ? 0 : uip_conn->mss))
+#else
+#define uip_sndwnd()          (uip_conn->len > 0 ? 0 : uip_conn->mss)
+#endif
+
+#if UIP_TCP_RCV_WND
+/**
+ * Get the receive window of the current connection.
+ *
+ * This is the number of bytes that the remote host can still send.
+ *
+ * \hideinitializer
+ */
+#define uip_rcvwnd()          (uip_conn->rcv_wnd)
+
+/**
+ * Set the receive window of the current connection.
+ *
+ * The new window is advertised with the next segment sent on the
+ * connection. The application should reduce it by the length of the
+ * data it receives (uip_datalen()), and should enlarge it only when
+ * it has room for at least a full segment (or half of its buffer), to
+ * avoid receiving many small segments. Use uip_restart() to send the
+ * new window right away.
+ *
+ * \hideinitializer
+ */
+#define uip_setrcvwnd(wnd)    (uip_conn->rcv_wnd = (wnd))
+
+/**
+ * Get the number of bytes of the incoming segment that were dropped
+ * because they didn't fit in the receive window.
+ *
+ * Only valid when uip_newdata() is true. uip_datalen() can be 0 if
+ * all the data was dropped.
+ *
+ * \hideinitializer
+ */
+#define uip_rcvdropped()      uip_rcvdrop
+#endif /* UIP_TCP_RCV_WND */
+
 /**
  * Set up a new UDP connection.
  *
@@ -1150,6 +1231,19 @@ extern void *uip_urgdata;
  */
 extern u16_t uip_len;
 
+/**
+ * The number of bytes acknowledged by the last incoming segment (see
+ * uip_ackedlen()).
+ */
+extern u16_t uip_acklen;
+
+/**
+ * The number of bytes of the last incoming segment that were dropped
+ * because they didn't fit in the receive window (see
+ * uip_rcvdropped()).
+ */
+extern u16_t uip_rcvdrop;
+
 /** @} */
 
 #if UIP_URGDATA > 0
@@ -1184,6 +1278,15 @@ struct uip_conn {
                          connection. */
   u16_t initialmss;   /**< Initial maximum segment size for the
                          connection. */
+#if UIP_TCP_SND_WND
+  u16_t snd_wnd;      /**< The window advertised by the remote host. */
+  u16_t snd_max;      /**< Length of all the data sent after snd_nxt,
+                         including the segments that a retransmission
+                         removed from len. */
+#endif
+#if UIP_TCP_RCV_WND
+  u16_t rcv_wnd;      /**< The window advertised to the remote host. */
+#endif
   u8_t sa;            /**< Retransmission time-out calculation state
                          variable. */
   u8_t sv;            /**< Retransmission time-out calculation state
@@ -116,6 +116,43 @@ static u8_t i, c;
 static u8_t arptime;
 static u8_t tmpage;
 
+struct uip_arp_stats uip_arp_stat;
+
+/* eLua: the ARP table is a hash table. An IP address can only be in the
+   ARP_WAYS entries that follow the one selected by a hash of the address,
+   so a lookup checks only these entries, whatever the size of the table. */
+#if UIP_ARP_WAYS < UIP_ARPTAB_SIZE
+#define ARP_WAYS UIP_ARP_WAYS
+#else
+#define ARP_WAYS UIP_ARPTAB_SIZE
+#endif
+
+/* The first entry for an IP address: the hash is the XOR of the bytes of
+   the address (the same in both byte orders) */
+static u8_t
+arp_first(u16_t *ipaddr)
+{
+  u16_t h = ipaddr[0] ^ ipaddr[1];
+
+  return (u8_t)((h ^ (h >> 8)) & 0xff) % UIP_ARPTAB_SIZE;
+}
+
+/* The entries for an IP address: c counts the entries, i is the index */
+#define ARP_FOREACH(ipaddr) \
+  for(c = 0, i = arp_first(ipaddr); c < ARP_WAYS; ++c, i = i + 1 == UIP_ARPTAB_SIZE ? 0 : i + 1)
+
+/* Return the entry of an IP address, NULL if it is not in the table */
+static struct arp_entry *
+arp_find(u16_t *ipaddr)
+{
+  ARP_FOREACH(ipaddr) {
+    if(uip_ipaddr_cmp(ipaddr, arp_table[i].ipaddr)) {
+      return &arp_table[i];
+    }
+  }
+  return NULL;
+}
+
 #define BUF   ((struct arp_hdr *)&uip_buf[0])
 #define IPBUF ((struct ethip_hdr *)&uip_buf[0])
 /*-----------------------------------------------------------------------------------*/
@@ -160,62 +197,31 @@ uip_arp_timer(void)
 static void
 uip_arp_update(u16_t *ipaddr, struct uip_eth_addr *ethaddr)
 {
-  register struct arp_entry *tabptr;
-  /* Walk through the ARP mapping table and try to find an entry to
-     update. If none is found, the IP -> MAC address mapping is
-     inserted in the ARP table. */
-  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-
-    tabptr = &arp_table[i];
-    /* Only check those entries that are actually in use. */
-    if(tabptr->ipaddr[0] != 0 &&
-       tabptr->ipaddr[1] != 0) {
-
-      /* Check if the source IP address of the incoming packet matches
-         the IP address in this ARP table entry. */
-      if(ipaddr[0] == tabptr->ipaddr[0] &&
-         ipaddr[1] == tabptr->ipaddr[1]) {
- 
-        /* An old entry found, update this and return. */
-        memcpy(tabptr->ethaddr.addr, ethaddr->addr, 6);
-        tabptr->time = arptime;
-
-        return;
-      }
-    }
-  }
+  register struct arp_entry *tabptr, *oldest;
 
-  /* If we get here, no existing ARP table entry was found, so we
-     create one. */
-
-  /* First, we try to find an unused entry in the ARP table. */
-  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-    tabptr = &arp_table[i];
-    if(tabptr->ipaddr[0] == 0 &&
-       tabptr->ipaddr[1] == 0) {
-      break;
-    }
-  }
-
-  /* If no unused entry is found, we try to find the oldest entry and
-     throw it away. */
-  if(i == UIP_ARPTAB_SIZE) {
+  /* Try to find the entry of the IP address to update it. If there is
+     none, the IP -> MAC address mapping is inserted in an unused
+     entry for this address, or in the oldest one. */
+  tabptr = arp_find(ipaddr);
+  if(tabptr == NULL) {
     tmpage = 0;
-    c = 0;
-    for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
+    oldest = NULL;
+    ARP_FOREACH(ipaddr) {
       tabptr = &arp_table[i];
-      if(arptime - tabptr->time > tmpage) {
+      if(tabptr->ipaddr[0] == 0 &&
+         tabptr->ipaddr[1] == 0) {
+        break;
+      }
+      if(oldest == NULL || (u8_t)(arptime - tabptr->time) > tmpage) {
         tmpage = arptime - tabptr->time;
-        c = i;
+        oldest = tabptr;
       }
     }
-    i = c;
-    tabptr = &arp_table[i];
+    if(c == ARP_WAYS) {
+      tabptr = oldest;
+    }
+    memcpy(tabptr->ipaddr, ipaddr, 4);
   }
-
-  /* Now, i is the ARP table entry which we will fill with the new
-     information. */
-  memcpy(tabptr->ipaddr, ipaddr, 4);
   memcpy(tabptr->ethaddr.addr, ethaddr->addr, 6);
   tabptr->time = arptime;
 }
@@ -233,11 +239,11 @@ uip_arp_update(u16_t *ipaddr, struct uip_eth_addr *ethaddr)
  * variable uip_len.
  */
 /*-----------------------------------------------------------------------------------*/
-#if 0
 void
 uip_arp_ipin(void)
 {
-  uip_len -= sizeof(struct uip_eth_hdr);
+  /* eLua: uip_len keeps the length of the Ethernet frame (uip_input
+     expects it). */
 
   /* Only insert/update an entry if the source IP address of the
      incoming IP packet comes from a host on the local network. */
@@ -253,7 +259,6 @@ uip_arp_ipin(void)
   
   return;
 }
-#endif /* 0 */
 /*-----------------------------------------------------------------------------------*/
 /**
  * ARP processing for incoming ARP packets.
@@ -379,17 +384,13 @@ uip_arp_out(void)
       /* Else, we use the destination IP address. */
       uip_ipaddr_copy(ipaddr, IPBUF->destipaddr);
     }
-      
-    for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-      tabptr = &arp_table[i];
-      if(uip_ipaddr_cmp(ipaddr, tabptr->ipaddr)) {
-        break;
-      }
-    }
 
-    if(i == UIP_ARPTAB_SIZE) {
+    tabptr = arp_find(ipaddr);
+
+    if(tabptr == NULL) {
       /* The destination address was not in our ARP table, so we
          overwrite the IP packet with an ARP request. */
+      ++uip_arp_stat.misses;
 
       memset(BUF->ethhdr.dest.addr, 0xff, 6);
       memset(BUF->dhwaddr.addr, 0x00, 6);
@@ -412,6 +413,7 @@ uip_arp_out(void)
     }
 
     /* Build an ethernet header. */
+    ++uip_arp_stat.hits;
     memcpy(IPBUF->ethhdr.dest.addr, tabptr->ethaddr.addr, 6);
   }
   memcpy(IPBUF->ethhdr.src.addr, uip_ethaddr.addr, 6);
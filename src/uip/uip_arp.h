@@ -80,8 +80,7 @@ void uip_arp_init(void);
    inserts a new mapping if none exists. The function assumes that an
    IP packet with an Ethernet header is present in the uip_buf buffer
    and that the length of the packet is in the uip_len variable. */
-/*void uip_arp_ipin(void);*/
-#define uip_arp_ipin()
+void uip_arp_ipin(void);
 
 /* The uip_arp_arpin() should be called when an ARP packet is received
    by the Ethernet driver. This function also assumes that the
@@ -107,6 +106,15 @@ void uip_arp_out(void);
    is responsible for flushing old entries in the ARP table. */
 void uip_arp_timer(void);
 
+/* Statistics of the lookups in the ARP table done by uip_arp_out(). A
+   miss sends an ARP request instead of the IP packet. */
+struct uip_arp_stats {
+  unsigned long hits;
+  unsigned long misses;
+};
+
+extern struct uip_arp_stats uip_arp_stat;
+
 /** @} */
 
 /**
@@ -0,0 +1,240 @@
+#include "platform_conf.h"
+#ifdef BUILD_UIP
+
+/**
+ * \addtogroup uiparch
+ * @{
+ */
+
+/**
+ * \file
+ * Word-at-a-time Internet checksum (UIP_ARCH_CHKSUM).
+ *
+ * The checksum code in uip.c adds the data one 16-bit word at a time
+ * and folds the carry after each addition. This implementation adds
+ * 32-bit words in the byte order of the CPU to a 64-bit sum, so the
+ * carries pile up in the upper half of the sum and are folded only
+ * once at the end. The one's complement sum does not depend on the
+ * byte order of the words (RFC 1071), so the sum computed in CPU byte
+ * order is the sum in network byte order.
+ *
+ * It is enabled by defining UIP_ARCH_CHKSUM to 1 in uip-conf.h. The
+ * main loop can be chosen with these options (also in uip-conf.h):
+ *
+ * - UIP_CONF_CHKSUM_UNROLL: 1 to add 4 words for each iteration of
+ *   the loop instead of one.
+ *
+ * - UIP_CONF_CHKSUM_THUMB2: use a Thumb-2 assembler loop (ARM
+ *   Cortex-M3/M4) that adds 16 bytes for each iteration with the
+ *   carry flag of the CPU.
+ *
+ * The 32-bit loads are always aligned, so the CPU doesn't need to
+ * support unaligned accesses.
+ */
+
+#include "uip.h"
+#include "uipopt.h"
+#include "uip_arch.h"
+#include "type.h"
+
+#if UIP_ARCH_CHKSUM
+
+#ifdef UIP_CONF_CHKSUM_UNROLL
+#define UIP_CHKSUM_UNROLL UIP_CONF_CHKSUM_UNROLL
+#else
+#define UIP_CHKSUM_UNROLL 0
+#endif
+
+#ifdef UIP_CONF_CHKSUM_THUMB2
+#define UIP_CHKSUM_THUMB2 UIP_CONF_CHKSUM_THUMB2
+#else
+#define UIP_CHKSUM_THUMB2 0
+#endif
+
+#define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/*---------------------------------------------------------------------------*/
+#if UIP_CHKSUM_THUMB2
+/* Adds 'blocks' blocks of 16 bytes from 'p' (aligned to 32 bits) to
+   'sum', with the carry of each block added back at the end of the
+   block. 'blocks' must not be 0. */
+static u32
+chksum_blocks(u32 sum, const u32 *p, u32 blocks)
+{
+  u32 a, b, c, d;
+
+  __asm__ __volatile__(
+    "1:                      \n\t"
+    "ldr   %[a], [%[p]], #4  \n\t"
+    "ldr   %[b], [%[p]], #4  \n\t"
+    "ldr   %[c], [%[p]], #4  \n\t"
+    "ldr   %[d], [%[p]], #4  \n\t"
+    "adds  %[s], %[s], %[a]  \n\t"
+    "adcs  %[s], %[s], %[b]  \n\t"
+    "adcs  %[s], %[s], %[c]  \n\t"
+    "adcs  %[s], %[s], %[d]  \n\t"
+    "adc   %[s], %[s], #0    \n\t"
+    "subs  %[n], %[n], #1    \n\t"
+    "bne   1b                \n\t"
+    : [s] "+r" (sum), [p] "+r" (p), [n] "+r" (blocks),
+      [a] "=&r" (a), [b] "=&r" (b), [c] "=&r" (c), [d] "=&r" (d)
+    :
+    : "cc", "memory");
+  return sum;
+}
+#endif /* UIP_CHKSUM_THUMB2 */
+/*---------------------------------------------------------------------------*/
+/* Returns the one's complement sum of 'len' bytes at 'data' (aligned
+   to 16 bits) added to 'acc', in CPU byte order. */
+static u16_t
+chksum_words(u64 acc, const u8_t *data, u16_t len)
+{
+  const u32 *p;
+  u16_t t;
+
+  /* Align the data to 32 bits. */
+  if(((unsigned long)data & 2) != 0 && len >= 2) {
+    acc += *(const u16_t *)data;
+    data += 2;
+    len -= 2;
+  }
+  p = (const u32 *)data;
+
+#if UIP_CHKSUM_THUMB2
+  if(len >= 16) {
+    acc += chksum_blocks(0, p, len >> 4);
+    p += (len >> 4) << 2;
+    len &= 15;
+  }
+#elif UIP_CHKSUM_UNROLL
+  while(len >= 16) {
+    acc += p[0];
+    acc += p[1];
+    acc += p[2];
+    acc += p[3];
+    p += 4;
+    len -= 16;
+  }
+#endif /* UIP_CHKSUM_THUMB2 */
+  while(len >= 4) {
+    acc += *p++;
+    len -= 4;
+  }
+
+  data = (const u8_t *)p;
+  if(len >= 2) {
+    acc += *(const u16_t *)data;
+    data += 2;
+    len -= 2;
+  }
+  if(len == 1) {
+    /* The last byte is the first byte of a word padded with zero. */
+    t = 0;
+    *(u8_t *)&t = *data;
+    acc += t;
+  }
+
+  /* Fold the carries. */
+  while(acc >> 16) {
+    acc = (acc & 0xffff) + (acc >> 16);
+  }
+  return (u16_t)acc;
+}
+/*---------------------------------------------------------------------------*/
+/* Same as chksum() in uip.c: adds 'len' bytes at 'data' to 'sum' and
+   returns the sum, both in host byte order. */
+static u16_t
+chksum(u16_t sum, const u8_t *data, u16_t len)
+{
+  u16_t t;
+
+  if(len == 0) {
+    return sum;
+  }
+  if(((unsigned long)data & 1) != 0) {
+    /* Sum the data after the first byte, which starts in the middle
+       of a word, and swap the bytes of the result to get the sum of
+       the words in the right place. */
+    t = chksum_words(0, data + 1, len - 1);
+    t = (t << 8) | (t >> 8);
+    sum = chksum_words((u64)t + HTONS(sum), data, 1);
+  } else {
+    sum = chksum_words(HTONS(sum), data, len);
+  }
+  return HTONS(sum);
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_chksum(u16_t *data, u16_t len)
+{
+  return htons(chksum(0, (u8_t *)data, len));
+}
+/*---------------------------------------------------------------------------*/
+#ifndef UIP_ARCH_IPCHKSUM
+u16_t
+uip_ipchksum(void)
+{
+  u16_t sum;
+
+  sum = chksum(0, &uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
+  return (sum == 0) ? 0xffff : htons(sum);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+#if UIP_CONF_IPV6 || UIP_TCP || UIP_UDP_CHECKSUMS
+static u16_t
+upper_layer_chksum(u8_t proto)
+{
+  u16_t upper_layer_len;
+  u16_t sum;
+
+#if UIP_CONF_IPV6
+  upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]);
+#else /* UIP_CONF_IPV6 */
+  upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]) - UIP_IPH_LEN;
+#endif /* UIP_CONF_IPV6 */
+
+  /* First sum pseudoheader. */
+
+  /* IP protocol and length fields. This addition cannot carry. */
+  sum = upper_layer_len + proto;
+  /* Sum IP source and destination addresses. */
+  sum = chksum(sum, (u8_t *)&BUF->srcipaddr[0], 2 * sizeof(uip_ipaddr_t));
+
+  /* Sum TCP header and data. */
+  sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+               upper_layer_len);
+
+  return (sum == 0) ? 0xffff : htons(sum);
+}
+#endif /* UIP_CONF_IPV6 || UIP_TCP || UIP_UDP_CHECKSUMS */
+/*---------------------------------------------------------------------------*/
+#if UIP_CONF_IPV6
+u16_t
+uip_icmp6chksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_ICMP6);
+}
+#endif /* UIP_CONF_IPV6 */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP
+u16_t
+uip_tcpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_TCP);
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
+#if UIP_UDP_CHECKSUMS
+u16_t
+uip_udpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_UDP);
+}
+#endif /* UIP_UDP_CHECKSUMS */
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_ARCH_CHKSUM */
+
+/** @} */
+
+#endif // #ifdef BUILD_UIP
@@ -330,6 +330,46 @@
 #define UIP_RECEIVE_WINDOW UIP_CONF_RECEIVE_WINDOW
 #endif
 
+/**
+ * The maximum amount of unacknowledged data in transit on a connection.
+ *
+ * If set to 0, uIP sends a single segment and waits for its
+ * acknowledgement before the application can send new data. Otherwise
+ * the application can send new segments (see uip_sndwnd() and
+ * uip_unacked()) while the previous ones are in transit, up to the
+ * window advertised by the remote host and this value, which should
+ * be at least UIP_TCP_MSS. The application must then keep the data
+ * until it is acknowledged (see uip_ackedlen()), and a retransmission
+ * restarts from the first unacknowledged byte.
+ *
+ * \hideinitializer
+ */
+#ifndef UIP_CONF_TCP_SND_WND
+#define UIP_TCP_SND_WND 0
+#else
+#define UIP_TCP_SND_WND UIP_CONF_TCP_SND_WND
+#endif
+
+/**
+ * Let the application set the receive window of each connection.
+ *
+ * If this option is set, a connection advertises the window set by
+ * the application with uip_setrcvwnd() (UIP_RECEIVE_WINDOW when the
+ * connection is created) instead of UIP_RECEIVE_WINDOW, so it can
+ * receive several segments in a buffer of the application. The
+ * application makes the window smaller as it receives data, and
+ * larger again when it has more room for it. The data of an incoming
+ * segment that doesn't fit in the window is dropped (see
+ * uip_rcvdropped()) and later retransmitted by the remote host.
+ *
+ * \hideinitializer
+ */
+#ifndef UIP_CONF_TCP_RCV_WND
+#define UIP_TCP_RCV_WND 0
+#else
+#define UIP_TCP_RCV_WND UIP_CONF_TCP_RCV_WND
+#endif
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -368,6 +408,22 @@
  */
 #define UIP_ARP_MAXAGE 120
 
+/**
+ * The number of ARP table entries that can hold an IP address.
+ *
+ * The ARP table is a hash table: the entry of an IP address is one of
+ * the UIP_ARP_WAYS entries that follow the entry selected by the hash
+ * of the address. Lookups check only these entries, but an address can
+ * evict another one even if the table isn't full.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_ARP_WAYS
+#define UIP_ARP_WAYS UIP_CONF_ARP_WAYS
+#else
+#define UIP_ARP_WAYS 4
+#endif
+
 /** @} */
 
 /*------------------------------------------------------------------------------*/
@@ -392,6 +448,25 @@
 #define UIP_BUFSIZE UIP_CONF_BUFFER_SIZE
 #endif /* UIP_CONF_BUFFER_SIZE */
 
+/**
+ * Makes uip_buf a pointer instead of an array.
+ *
+ * If this option is set, uip_buf points to the packet buffer of uIP
+ * (uip_bufmem) by default, and the device driver can point it to its
+ * own receive buffer while a packet is processed, which avoids
+ * copying the packet. uIP builds its answer in the same buffer, so it
+ * must have room for UIP_BUFSIZE + 2 bytes, and it must be aligned to
+ * 16 bits. uip_buf must point to uip_bufmem again before the periodic
+ * processing.
+ *
+ * \hideinitializer
+ */
+#ifndef UIP_CONF_EXTERNAL_BUFFER
+#define UIP_EXTERNAL_BUFFER 0
+#else /* UIP_CONF_EXTERNAL_BUFFER */
+#define UIP_EXTERNAL_BUFFER UIP_CONF_EXTERNAL_BUFFER
+#endif /* UIP_CONF_EXTERNAL_BUFFER */
+
 
 /**
  * Determines if statistics support should be compiled in.
@@ -0,0 +1,43 @@
+-- ADC filter stage benchmark: input samples/s for each filter type
+-- Runs on the simulator, where the conversions are instantaneous, so the time
+-- is spent in the sample processing (on a board, the ADC clock limits the rate)
+
+local id, count = 0, 4096
+
+-- 16 taps low pass FIR (Q15), about 1/16 each
+local fir16 = { adc.FIR }
+for i = 1, 16 do fir16[ i + 1 ] = 2048 end
+
+local filters =
+{
+  { "none" },
+  { "fir16", { fir16 } },
+  { "biquad", { { adc.IIR, 1024, 2048, 1024, -22528, 8192 } } },
+  { "decim4", { { adc.DECIMATE, 4 } } },
+  { "fir16+dec4", { fir16, { adc.DECIMATE, 4 } } },
+  { "biquad x2", { { adc.IIR, 1024, 2048, 1024, -22528, 8192 }, { adc.IIR, 1024, 2048, 1024, -22528, 8192 } } },
+}
+
+local function bench( name, stages )
+  local decim = 1
+  for _, s in ipairs( stages or {} ) do
+    if s[ 1 ] == adc.DECIMATE then decim = decim * s[ 2 ] end
+  end
+  adc.setfilter( id, stages )
+  local t = os.clock()
+  adc.sample( id, count / decim )
+  local data = adc.getsamples( id )
+  t = os.clock() - t
+  assert( #data == count / decim, "missing samples" )
+  if t > 0 then
+    print( string.format( "%-12s %10.0f samples/s", name, count / t ) )
+  else
+    print( string.format( "%-12s too fast to measure", name ) )
+  end
+end
+
+adc.setclock( id, 0 )
+for _, f in ipairs( filters ) do
+  bench( f[ 1 ], f[ 2 ] )
+end
+adc.setfilter( id )
@@ -0,0 +1,53 @@
+-- HTTP server benchmark between two simulator instances (or two boards)
+-- Start the first simulator and run "lua /rom/bench-httpd.lua server", then
+-- start a second simulator (it gets the next IP address) and run the script
+-- without arguments. The client sends requests on a single keep-alive
+-- connection, both to a Lua handler and for a file from /rom (this script).
+
+local port, requests = 80, 100
+local server_ip = net.packip( 10, 0, 0, 1 )
+local paths = { "/hello", "/bench-httpd.lua" }
+
+local function server()
+  print( "Serving on port " .. port )
+  httpd.serve( port, {
+    [ "/hello" ] = function( req ) return 200, "Hello from eLua!\n", { [ "Content-Type" ] = "text/plain" } end
+  }, "/rom" )
+end
+
+-- Read a response, return the size of its body
+local function response( sock )
+  local status = net.recv( sock, "*l" )
+  assert( status:match( "^HTTP/1.1 200" ), "wrong status " .. status )
+  local length
+  while true do
+    local line = net.recv( sock, "*l" ):gsub( "\r$", "" )
+    if line == "" then break end
+    length = length or tonumber( line:lower():match( "^content%-length:%s*(%d+)" ) )
+  end
+  local left = assert( length, "no Content-Length" )
+  while left > 0 do
+    local data, err = net.recv( sock, left )
+    assert( err == net.ERR_OK, "connection closed" )
+    left = left - #data
+  end
+  return length
+end
+
+local function client()
+  local sock = net.socket( net.SOCK_STREAM )
+  assert( net.connect( sock, server_ip, port ) == net.ERR_OK, "unable to connect" )
+  for _, path in ipairs( paths ) do
+    local total, t = 0, os.clock()
+    for i = 1, requests do
+      net.send( sock, "GET " .. path .. " HTTP/1.1\r\nHost: elua\r\n\r\n" )
+      total = total + response( sock )
+    end
+    t = os.clock() - t
+    print( string.format( "%-20s %5d requests %8.3f s %8.1f req/s %10.0f B/s", path, requests, t,
+      t > 0 and requests / t or 0, t > 0 and total / t or 0 ) )
+  end
+  net.close( sock )
+end
+
+if arg and arg[ 1 ] == "server" then server() else client() end
@@ -0,0 +1,53 @@
+-- Integer heavy benchmark, used to compare the "lua" and "luahybrid" targets
+-- Run it on both images and compare the reported times (os.clock() uses the
+-- system timer, so the platform must have one)
+
+local clock = os.clock
+
+local function bench( name, f, ... )
+  local t = clock()
+  local res = f( ... )
+  print( string.format( "%-12s %8.3f s (result %s)", name, clock() - t, tostring( res ) ) )
+end
+
+-- Plain integer arithmetic in a numeric loop
+local function arith( n )
+  local s = 0
+  for i = 1, n do
+    s = ( s + i * 3 - i % 7 ) % 65521
+  end
+  return s
+end
+
+-- Array part of a table indexed with integers
+local function fill( n )
+  local t = {}
+  for i = 1, n do t[ i ] = i end
+  local s = 0
+  for i = n, 1, -1 do s = s + t[ i ] end
+  return s
+end
+
+-- Sieve of Eratosthenes
+local function sieve( n )
+  local t, c = {}, 0
+  for i = 2, n do
+    if not t[ i ] then
+      c = c + 1
+      for j = i + i, n, i do t[ j ] = true end
+    end
+  end
+  return c
+end
+
+-- Floating point values must not become slower
+local function float( n )
+  local s = 0
+  for i = 1, n do s = s + i / 3 end
+  return s
+end
+
+bench( "arith", arith, 100000 )
+bench( "fill", fill, 20000 )
+bench( "sieve", sieve, 20000 )
+bench( "float", float, 100000 )
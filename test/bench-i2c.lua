@@ -0,0 +1,37 @@
+-- I2C register read benchmark: discrete calls vs. i2c.readreg
+-- Runs on the simulator (slave at address 0x50) or on a board with a register
+-- based slave (change 'id', 'addr' and 'reg' below)
+
+local id, addr, reg, count = 0, 0x50, 0x10, 4
+local iterations = 2000
+
+local function discrete()
+  i2c.start( id )
+  i2c.address( id, addr, i2c.TRANSMITTER )
+  i2c.write( id, reg )
+  i2c.start( id )
+  i2c.address( id, addr, i2c.RECEIVER )
+  local data = i2c.read( id, count )
+  i2c.stop( id )
+  return data
+end
+
+local function combined()
+  return i2c.readreg( id, addr, reg, count )
+end
+
+local function bench( name, f )
+  local t = os.clock()
+  for i = 1, iterations do f() end
+  t = os.clock() - t
+  if t > 0 then
+    print( string.format( "%-10s %8.0f reads/s", name, iterations / t ) )
+  else
+    print( string.format( "%-10s too fast to measure", name ) )
+  end
+end
+
+i2c.setup( id, i2c.FAST )
+assert( discrete() == combined(), "register data mismatch" )
+bench( "discrete", discrete )
+bench( "readreg", combined )
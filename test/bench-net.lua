@@ -0,0 +1,48 @@
+-- TCP throughput benchmark between two simulator instances (or two boards)
+-- Start the first simulator and run "lua /rom/bench-net.lua server", then start
+-- a second simulator (it gets the next IP address) and run the script without
+-- arguments. The client sends blocks of data, the server answers with the number
+-- of bytes received.
+
+local port, blocksize = 5000, 1024
+local server_ip = net.packip( 10, 0, 0, 1 )
+local sizes = { 16, 64, 256 }
+
+local function server()
+  print( "Waiting for connections on port " .. port )
+  while true do
+    local sock, remoteip, err = net.accept( port )
+    local total = 0
+    while true do
+      local data, err = net.recv( sock, blocksize )
+      if err ~= net.ERR_OK or #data == 0 then break end
+      total = total + #data
+      if data:sub( -1 ) == "!" then
+        net.send( sock, tostring( total ) .. "\n" )
+        total = 0
+      end
+    end
+    local _, buffered, dropped = net.rxstats( sock )
+    print( string.format( "Received %d bytes, dropped %d (receive buffer full)", buffered, dropped ) )
+    net.close( sock )
+  end
+end
+
+local function client()
+  local sock = net.socket( net.SOCK_STREAM )
+  assert( net.connect( sock, server_ip, port ) == net.ERR_OK, "unable to connect" )
+  local block = string.rep( "x", blocksize - 1 )
+  for _, kb in ipairs( sizes ) do
+    local t = os.clock()
+    for i = 1, kb do
+      net.send( sock, block .. ( i == kb and "!" or "x" ) )
+    end
+    local res = net.recv( sock, "*l" )
+    t = os.clock() - t
+    assert( tonumber( res ) == kb * blocksize, "wrong size " .. tostring( res ) )
+    print( string.format( "%5d KB %8.3f s %10.0f B/s", kb, t, t > 0 and kb * blocksize / t or 0 ) )
+  end
+  net.close( sock )
+end
+
+if arg and arg[ 1 ] == "server" then server() else client() end
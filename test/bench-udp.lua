@@ -0,0 +1,56 @@
+-- UDP datagram rate benchmark between two simulator instances (or two boards)
+-- Start the first simulator and run "lua /rom/bench-udp.lua server", then start
+-- a second simulator (it gets the next IP address) and run the script without
+-- arguments. The client sends bursts of datagrams, then asks the server how many
+-- datagrams it received.
+
+local port = 6000
+local server_ip = net.packip( 10, 0, 0, 1 )
+local count = 2000
+local sizes = { 16, 64, 256, 1024 }
+
+local function server()
+  local sock = net.socket( net.SOCK_DGRAM )
+  assert( sock ~= -1 and net.bind( sock, port ) == 0, "unable to create the socket" )
+  print( "Waiting for datagrams on port " .. port )
+  local received = 0
+  while true do
+    local data, ip, rport, err = net.recvfrom( sock, 1500 )
+    if data == "?" then
+      net.sendto( sock, tostring( received ), ip, rport )
+      received = 0
+    elseif #data > 1 then
+      received = received + 1
+    end
+  end
+end
+
+-- Ask the server for the number of datagrams received (the question or the
+-- answer could be lost, so ask again after a while)
+local function get_received( sock )
+  for i = 1, 10 do
+    net.sendto( sock, "?", server_ip, port )
+    local res = net.recvfrom( sock, 16, tmr.SYS_TIMER, 500000 )
+    if #res > 0 then return tonumber( res ) end
+  end
+end
+
+local function client()
+  local sock = net.socket( net.SOCK_DGRAM )
+  assert( sock ~= -1, "unable to create the socket" )
+  -- The first datagram may be replaced by an ARP request
+  get_received( sock )
+  for _, size in ipairs( sizes ) do
+    local data = string.rep( "x", size )
+    local t = os.clock()
+    for i = 1, count do
+      net.sendto( sock, data, server_ip, port )
+    end
+    t = os.clock() - t
+    local received = get_received( sock ) or 0
+    print( string.format( "%5d bytes %10.0f datagrams/s, %5.1f%% received", size, t > 0 and count / t or 0, received * 100 / count ) )
+  end
+  net.close( sock )
+end
+
+if arg and arg[ 1 ] == "server" then server() else client() end